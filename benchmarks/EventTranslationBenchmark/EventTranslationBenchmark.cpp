@@ -0,0 +1,301 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include <QtGui/QKeyEvent>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QWheelEvent>
+
+#include "G3DWidgetEventTranslation.hpp"
+#include "InputLatencyTracker.hpp"
+
+//
+// Count heap allocations, so we can report allocations per event alongside the time
+// per event.
+//
+static unsigned long long g_allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    ++g_allocationCount;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace
+{
+
+//
+// Stands in for G3D::OSWindow's event queue. The event handlers below do what the
+// G3DWidget handlers do, including reporting each event to an InputLatencyTracker,
+// minus the G3DWidget, so no window or OpenGL context is needed.
+//
+class EventSink
+{
+public:
+    EventSink() :
+        m_mousePrevPos          (0, 0),
+        m_mousePressEventButtons(Qt::NoButton),
+        m_pendingWheelDelta     (0, 0),
+        m_devicePixelRatio      (2.0),
+        m_count                 (0),
+        m_checksum              (0) {
+    }
+
+    void fireEvent(const G3D::GEvent& e) {
+        m_events[m_count++ % kQueueSize] = e;
+        m_checksum += e.type;
+    }
+
+    void mouseMoveEvent(QMouseEvent* mouseEvent) {
+        G3D::GEvent e;
+        mojo::makeMouseMotionEvent(mouseEvent, m_mousePrevPos, m_devicePixelRatio, e);
+        m_inputLatencyTracker.inputReceived(mojo::InputLatencyTracker::INPUT_MOUSE_MOTION, mouseEvent->timestamp());
+
+        m_mousePrevPos = mouseEvent->pos();
+
+        fireEvent(e);
+    }
+
+    void mousePressEvent(QMouseEvent* mouseEvent) {
+        G3D::GEvent e;
+        mojo::makeMouseButtonDownEvent(mouseEvent, m_devicePixelRatio, e);
+        m_inputLatencyTracker.inputReceived(mojo::InputLatencyTracker::INPUT_MOUSE_BUTTON, mouseEvent->timestamp());
+
+        m_mousePressEventButtons = mouseEvent->buttons();
+
+        fireEvent(e);
+    }
+
+    void mouseReleaseEvent(QMouseEvent* mouseEvent) {
+        G3D::GEvent e;
+        mojo::makeMouseButtonUpEvent(mouseEvent, m_mousePressEventButtons, m_devicePixelRatio, e);
+        m_inputLatencyTracker.inputReceived(mojo::InputLatencyTracker::INPUT_MOUSE_BUTTON, mouseEvent->timestamp());
+
+        m_mousePressEventButtons = Qt::NoButton;
+
+        fireEvent(e);
+
+        e.type             = G3D::GEventType::MOUSE_BUTTON_CLICK;
+        e.button.numClicks = 1;
+
+        fireEvent(e);
+    }
+
+    void wheelEvent(QWheelEvent* wheelEvent) {
+        G3D::GEvent e;
+        bool        notch = mojo::makeMouseScrollEvent(wheelEvent, m_pendingWheelDelta, e);
+        m_inputLatencyTracker.inputReceived(mojo::InputLatencyTracker::INPUT_MOUSE_WHEEL, wheelEvent->timestamp());
+
+        if (notch) {
+            fireEvent(e);
+        }
+    }
+
+    void keyPressEvent(QKeyEvent* k) {
+        G3D::GEvent e;
+        mojo::makeKeyDownEvent(k, e);
+        m_inputLatencyTracker.inputReceived(mojo::InputLatencyTracker::INPUT_KEY, k->timestamp());
+        fireEvent(e);
+
+        G3D::GEvent c;
+        if (mojo::makeCharInputEvent(k, c)) {
+            fireEvent(c);
+        }
+    }
+
+    void keyReleaseEvent(QKeyEvent* k) {
+        if (!k->isAutoRepeat()) {
+            G3D::GEvent e;
+            mojo::makeKeyUpEvent(k, e);
+            m_inputLatencyTracker.inputReceived(mojo::InputLatencyTracker::INPUT_KEY, k->timestamp());
+            fireEvent(e);
+        }
+    }
+
+    unsigned long long checksum() const {
+        return m_checksum;
+    }
+
+private:
+    static const int kQueueSize = 256;
+
+    G3D::GEvent               m_events[kQueueSize];
+    QPoint                    m_mousePrevPos;
+    Qt::MouseButtons          m_mousePressEventButtons;
+    QPoint                    m_pendingWheelDelta;
+    qreal                     m_devicePixelRatio;
+    mojo::InputLatencyTracker m_inputLatencyTracker;
+    unsigned long long        m_count;
+    unsigned long long        m_checksum;
+};
+
+struct KeySpec
+{
+    int                   key;
+    Qt::KeyboardModifiers modifiers;
+    const char*           text;
+};
+
+//
+// A mix of what the demo apps see: WASD camera movement, arrows, modifiers, function
+// keys, punctuation and the numeric keypad.
+//
+const KeySpec kKeys[] = {
+    { Qt::Key_W,         Qt::NoModifier,      "w" },
+    { Qt::Key_A,         Qt::NoModifier,      "a" },
+    { Qt::Key_S,         Qt::NoModifier,      "s" },
+    { Qt::Key_D,         Qt::ShiftModifier,   "D" },
+    { Qt::Key_Up,        Qt::NoModifier,      ""  },
+    { Qt::Key_Left,      Qt::NoModifier,      ""  },
+    { Qt::Key_Shift,     Qt::ShiftModifier,   ""  },
+    { Qt::Key_Control,   Qt::ControlModifier, ""  },
+    { Qt::Key_Escape,    Qt::NoModifier,      ""  },
+    { Qt::Key_Space,     Qt::NoModifier,      " " },
+    { Qt::Key_F8,        Qt::NoModifier,      ""  },
+    { Qt::Key_Tab,       Qt::NoModifier,      "\t"},
+    { Qt::Key_Comma,     Qt::NoModifier,      "," },
+    { Qt::Key_7,         Qt::KeypadModifier,  "7" },
+    { Qt::Key_Plus,      Qt::KeypadModifier,  "+" },
+    { Qt::Key_Enter,     Qt::KeypadModifier,  ""  },
+};
+
+const int kNumKeys = sizeof(kKeys) / sizeof(kKeys[0]);
+
+struct Result
+{
+    double nanosecondsPerEvent;
+    double allocationsPerEvent;
+};
+
+template <typename Function>
+Result measure(int iterations, int eventsPerIteration, Function function)
+{
+    unsigned long long allocationsBegin = g_allocationCount;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        function(i);
+    }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    double events = (double)iterations * eventsPerIteration;
+
+    Result result;
+    result.nanosecondsPerEvent = std::chrono::duration<double, std::nano>(end - begin).count() / events;
+    result.allocationsPerEvent = (double)(g_allocationCount - allocationsBegin) / events;
+    return result;
+}
+
+void report(const char* name, const Result& result)
+{
+    std::printf("%-36s %9.1f ns/event %6.2f allocs/event\n", name, result.nanosecondsPerEvent, result.allocationsPerEvent);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    EventSink sink;
+
+    //
+    // The Qt events are built up front, so we measure the translation and not the
+    // construction of the QEvents, which Qt does for us in the real application.
+    //
+    std::vector<QMouseEvent*> mouseMoves;
+    for (int i = 0; i < 64; ++i) {
+        Qt::MouseButtons buttons = (i % 4 == 0) ? Qt::MouseButtons(Qt::LeftButton) : (i % 4 == 1 ? Qt::MouseButtons(Qt::RightButton | Qt::MiddleButton) : Qt::MouseButtons(Qt::NoButton));
+        mouseMoves.push_back(new QMouseEvent(QEvent::MouseMove, QPointF(i * 7 % 800, i * 13 % 600), Qt::NoButton, buttons, Qt::NoModifier));
+    }
+
+    const Qt::MouseButton mouseButtons[] = { Qt::LeftButton, Qt::RightButton, Qt::MiddleButton, Qt::XButton1 };
+    std::vector<QMouseEvent*> mousePresses;
+    std::vector<QMouseEvent*> mouseReleases;
+    for (int i = 0; i < 4; ++i) {
+        mousePresses.push_back(new QMouseEvent(QEvent::MouseButtonPress,   QPointF(100 + i, 200), mouseButtons[i], mouseButtons[i], Qt::NoModifier));
+        mouseReleases.push_back(new QMouseEvent(QEvent::MouseButtonRelease, QPointF(100 + i, 200), mouseButtons[i], Qt::NoButton,    Qt::NoModifier));
+    }
+
+    //
+    // Whole notches, as from a mouse wheel, and fractions of one, as from a trackpad,
+    // which only add up to a G3D::GEvent every few events.
+    //
+    std::vector<QWheelEvent*> wheels;
+    for (int i = 0; i < 64; ++i) {
+        QPoint angleDelta(0, (i % 2 == 0) ? 120 : -15);
+        wheels.push_back(new QWheelEvent(QPointF(i * 7 % 800, i * 13 % 600), QPointF(i * 7 % 800, i * 13 % 600), QPoint(), angleDelta, angleDelta.y(), Qt::Vertical, Qt::NoButton, Qt::NoModifier));
+    }
+
+    std::vector<QKeyEvent*> keyPresses;
+    std::vector<QKeyEvent*> keyRepeats;
+    std::vector<QKeyEvent*> keyReleases;
+    for (int i = 0; i < kNumKeys; ++i) {
+        keyPresses.push_back(new QKeyEvent(QEvent::KeyPress,   kKeys[i].key, kKeys[i].modifiers, kKeys[i].text, false));
+        keyRepeats.push_back(new QKeyEvent(QEvent::KeyPress,   kKeys[i].key, kKeys[i].modifiers, kKeys[i].text, true));
+        keyReleases.push_back(new QKeyEvent(QEvent::KeyRelease, kKeys[i].key, kKeys[i].modifiers, kKeys[i].text, false));
+    }
+
+    report("mouseMoveEvent", measure(iterations, 1, [&](int i) {
+        sink.mouseMoveEvent(mouseMoves[i % mouseMoves.size()]);
+    }));
+
+    report("mousePressEvent + mouseReleaseEvent", measure(iterations, 2, [&](int i) {
+        sink.mousePressEvent(mousePresses[i % mousePresses.size()]);
+        sink.mouseReleaseEvent(mouseReleases[i % mouseReleases.size()]);
+    }));
+
+    report("wheelEvent", measure(iterations, 1, [&](int i) {
+        sink.wheelEvent(wheels[i % wheels.size()]);
+    }));
+
+    report("keyPressEvent", measure(iterations, 1, [&](int i) {
+        sink.keyPressEvent(keyPresses[i % kNumKeys]);
+    }));
+
+    report("keyPressEvent (auto repeat)", measure(iterations, 1, [&](int i) {
+        sink.keyPressEvent(keyRepeats[i % kNumKeys]);
+    }));
+
+    report("keyReleaseEvent", measure(iterations, 1, [&](int i) {
+        sink.keyReleaseEvent(keyReleases[i % kNumKeys]);
+    }));
+
+    unsigned long long translated = 0;
+
+    report("getG3DMouseButtonPressedFlags", measure(iterations, 1, [&](int i) {
+        translated += mojo::getG3DMouseButtonPressedFlags(Qt::MouseButtons(i & 0x1f));
+    }));
+
+    report("translateKeyEvent", measure(iterations, 1, [&](int i) {
+        G3D::GEvent e;
+        mojo::translateKeyEvent(keyPresses[i % kNumKeys], e);
+        translated += e.key.keysym.sym + e.key.keysym.mod;
+    }));
+
+    // printed so the compiler can't discard the work
+    std::printf("checksum %llu %llu\n", sink.checksum(), translated);
+
+    for (QMouseEvent* e : mouseMoves)    delete e;
+    for (QMouseEvent* e : mousePresses)  delete e;
+    for (QMouseEvent* e : mouseReleases) delete e;
+    for (QWheelEvent* e : wheels)        delete e;
+    for (QKeyEvent* e   : keyPresses)    delete e;
+    for (QKeyEvent* e   : keyRepeats)    delete e;
+    for (QKeyEvent* e   : keyReleases)   delete e;
+
+    return 0;
+}
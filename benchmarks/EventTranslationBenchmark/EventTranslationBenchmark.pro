@@ -0,0 +1,42 @@
+#-------------------------------------------------
+#
+# Measures the translation of Qt input events into
+# G3D::GEvents, without a window or OpenGL.
+#
+#-------------------------------------------------
+
+QT += core gui widgets
+
+TARGET = EventTranslationBenchmark
+
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++11
+
+TEMPLATE = app
+
+QMAKE_CXXFLAGS_WARN_ON  = ""
+QMAKE_CXXFLAGS         += -msse4.1 -Wno-unknown-pragmas
+
+INCLUDEPATH +=              \
+    /opt/local/include      \
+    ${G3D10DATA}/../include \
+    ../../code              \
+
+LIBS +=                      \
+    -F"/Library/Frameworks/" \
+    -L"${G3D10DATA}/../lib/" \
+    -framework Cocoa         \
+    -framework OpenGL        \
+    -lz                      \
+
+CONFIG(debug,   release|debug):LIBS += -lG3Dd -lGLG3Dd
+CONFIG(release, release|debug):LIBS += -lG3D  -lGLG3D
+
+SOURCES +=                                     \
+    EventTranslationBenchmark.cpp              \
+    ../../code/G3DWidgetEventTranslation.cpp   \
+    ../../code/InputLatencyTracker.cpp         \
+    ../../code/Assert.cpp                      \
+    ../../code/Log.cpp                         \
+    ../../code/Printf.cpp                      \
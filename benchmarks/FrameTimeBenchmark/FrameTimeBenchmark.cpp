@@ -0,0 +1,806 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "G3D/G3D.h"
+#include "GLG3D/GLG3D.h"
+
+#include "FrameArena.hpp"
+#include "GPUTimer.hpp"
+#include "PixelShaderApp.hpp"
+#include "StarterApp.hpp"
+#include "VideoTextureSource.hpp"
+
+//
+// Count heap allocations, so we can report allocations per frame alongside the frame
+// times. This only sees operator new; transient G3D::Arrays allocate through their
+// G3D::MemoryManager instead, which is the frame arena, and the arena counts its own
+// heap allocations. A steady-state frame should not make any of the latter.
+//
+// Only the render thread counts, and only during the measured frames, while
+// t_countAllocations is set. Video, ingest, log and simulation threads allocate at
+// their own pace, so their allocations are not the frame's.
+//
+static std::atomic<unsigned long long> g_allocationCount(0);
+static thread_local bool               t_countAllocations = false;
+
+void* operator new(std::size_t size) {
+    if (t_countAllocations) {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace
+{
+
+struct Options
+{
+    std::string app;
+    std::string scene;
+    std::string video;
+    int         width;
+    int         height;
+    int         warmupFrames;
+    int         measuredFrames;
+};
+
+struct Statistics
+{
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+Statistics computeStatistics(std::vector<float> samples)
+{
+    Statistics statistics = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+    if (samples.empty()) {
+        return statistics;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0.0;
+    for (float sample : samples) {
+        sum += sample;
+    }
+
+    int last = (int)samples.size() - 1;
+    statistics.mean = sum / samples.size();
+    statistics.p50  = samples[(int)std::lround(last * 0.50)];
+    statistics.p95  = samples[(int)std::lround(last * 0.95)];
+    statistics.p99  = samples[(int)std::lround(last * 0.99)];
+    statistics.max  = samples[last];
+    return statistics;
+}
+
+double peakResidentKilobytes()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024.0;
+#else
+    return (double)usage.ru_maxrss;
+#endif
+}
+
+//
+// Only PixelShaderApp plays video, in its reflections. BenchmarkApp passes itself as
+// App, so a PixelShaderApp gets the overload that plays the video.
+//
+G3D::shared_ptr<mojo::VideoTextureSource> playVideo(G3D::GApp&, const std::string&)
+{
+    return G3D::shared_ptr<mojo::VideoTextureSource>();
+}
+
+G3D::shared_ptr<mojo::VideoTextureSource> playVideo(G3D::PixelShaderApp& app, const std::string& filename)
+{
+    app.setVideoEnvironment(filename.c_str());
+    return app.videoEnvironmentSource();
+}
+
+//
+// Runs App for a fixed number of frames along a scripted camera path and records the
+// time of every measured frame. The CPU time of a frame is the time spent in the app's
+// simulation, pose and graphics callbacks; the GPU time is measured with timestamp
+// queries around onGraphics. Both exclude waiting for the next frame to start, so
+// comparing them with the frame time shows which side bounds the frame rate.
+//
+// With a video, e.g., a 4K clip, the app plays it while it renders, and the run also
+// reports how many video frames were presented and dropped while measuring.
+//
+template <typename App>
+class BenchmarkApp : public App
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    BenchmarkApp(const G3D::GApp::Settings& settings, const Options& options) :
+        App                        (settings),
+        m_options                  (options),
+        m_frame                    (0),
+        m_cpuMilliseconds          (0.0f),
+        m_gpuTimer                 (1, 4),
+        m_allocationsBegin         (0),
+        m_allocationsPerFrame      (0.0),
+        m_frameArena               (mojo::FrameArena::create()),
+        m_arenaHeapAllocationsBegin(0),
+        m_arenaHeapAllocations     (0),
+        m_failed                   (false),
+        m_videoPresentedBegin      (0),
+        m_videoDroppedBegin        (0),
+        m_videoPresentedFrames     (0),
+        m_videoDroppedFrames       (0)
+    {
+        // reserved up front, so recording the samples doesn't count as allocations of the frames
+        m_frameMilliseconds.reserve(options.measuredFrames + 1);
+        m_cpuSamples.reserve(options.measuredFrames + 1);
+        m_gpuSamples.reserve(options.measuredFrames + 1);
+
+        //
+        // The GPUTimer's own statistics only cover its most recent kHistorySize frames,
+        // so we keep the result of every measured frame. Results arrive a few frames late,
+        // so those of the last frames in flight are not included.
+        //
+        m_gpuTimer.setResultFunction([this](int, float milliseconds) {
+            if (m_frame >= m_options.warmupFrames && m_gpuSamples.size() < m_gpuSamples.capacity()) {
+                m_gpuSamples.push_back(milliseconds);
+            }
+        });
+    }
+
+    virtual void onInit() override
+    {
+        App::onInit();
+
+        if (!m_options.scene.empty()) {
+            this->loadScene(m_options.scene.c_str());
+        }
+
+        // the scripted camera path replaces user control of the camera
+        this->setCameraManipulator(G3D::shared_ptr<G3D::Manipulator>());
+        this->setActiveCamera(this->m_debugCamera);
+
+        if (!m_options.video.empty()) {
+            m_video = playVideo(static_cast<App&>(*this), m_options.video);
+            if (!m_video) {
+                std::fprintf(stderr, "Cannot play %s in %s\n", m_options.video.c_str(), m_options.app.c_str());
+                m_failed = true;
+                this->setExitCode(1);
+            }
+        }
+    }
+
+    virtual void onSimulation(G3D::RealTime rdt, G3D::SimTime sdt, G3D::SimTime idt) override
+    {
+        Clock::time_point begin = Clock::now();
+
+        // like a G3DWidget, the arena is current from here to the end of onGraphics
+        mojo::FrameArena::setCurrent(m_frameArena);
+
+        // the frame's allocations are counted from here to the end of onGraphics
+        t_countAllocations = (m_frame >= m_options.warmupFrames);
+
+        if (m_frame == m_options.warmupFrames) {
+            m_allocationsBegin          = g_allocationCount.load();
+            m_arenaHeapAllocationsBegin = m_frameArena->heapAllocations();
+            m_gpuTimer.clearStatistics();
+
+            if (m_video) {
+                m_videoPresentedBegin = m_video->presentedFrames();
+                m_videoDroppedBegin   = m_video->droppedFrames();
+            }
+        }
+
+        //
+        // One revolution around the origin every 600 frames, bobbing up and down, so
+        // the path only depends on the frame number and not on how fast we render.
+        //
+        float angle = m_frame * (G3D::twoPi() / 600.0f);
+        this->activeCamera()->setFrame(G3D::CFrame::fromXYZYPRRadians(
+            4.0f * std::sin(angle), 1.0f + 0.5f * std::sin(angle * 3.0f), 4.0f * std::cos(angle),
+            angle, -0.15f));
+
+        App::onSimulation(rdt, sdt, idt);
+
+        m_cpuMilliseconds = millisecondsSince(begin);
+    }
+
+    virtual void onPose(G3D::Array<G3D::shared_ptr<G3D::Surface> >& posed3D, G3D::Array<G3D::shared_ptr<G3D::Surface2D> >& posed2D) override
+    {
+        Clock::time_point begin = Clock::now();
+        App::onPose(posed3D, posed2D);
+        m_cpuMilliseconds += millisecondsSince(begin);
+    }
+
+    virtual void onGraphics(G3D::RenderDevice* rd, G3D::Array<G3D::shared_ptr<G3D::Surface> >& posed3D, G3D::Array<G3D::shared_ptr<G3D::Surface2D> >& posed2D) override
+    {
+        Clock::time_point begin = Clock::now();
+
+        m_gpuTimer.beginFrame();
+        m_gpuTimer.beginZone(0);
+        App::onGraphics(rd, posed3D, posed2D);
+        m_gpuTimer.endZone(0);
+        m_gpuTimer.endFrame();
+
+        mojo::FrameArena::setCurrent(G3D::shared_ptr<mojo::FrameArena>());
+        m_frameArena->reset();
+
+        t_countAllocations = false;
+
+        m_cpuMilliseconds += millisecondsSince(begin);
+
+        if (m_frame >= m_options.warmupFrames) {
+            if (m_frame > m_options.warmupFrames) {
+                m_frameMilliseconds.push_back(std::chrono::duration<float, std::milli>(begin - m_previousFrameBegin).count());
+            }
+            m_cpuSamples.push_back(m_cpuMilliseconds);
+        }
+
+        m_previousFrameBegin = begin;
+
+        if (++m_frame == m_options.warmupFrames + m_options.measuredFrames + 1) {
+            m_allocationsPerFrame  = (double)(g_allocationCount.load() - m_allocationsBegin) / (m_options.measuredFrames + 1);
+            m_arenaHeapAllocations = m_frameArena->heapAllocations() - m_arenaHeapAllocationsBegin;
+
+            if (m_video) {
+                m_videoPresentedFrames = m_video->presentedFrames() - m_videoPresentedBegin;
+                m_videoDroppedFrames   = m_video->droppedFrames() - m_videoDroppedBegin;
+            }
+
+            this->setExitCode(0);
+        }
+    }
+
+    virtual void onCleanup() override
+    {
+        m_gpuTimer.cleanup();
+        App::onCleanup();
+    }
+
+    bool failed() const
+    {
+        return m_failed;
+    }
+
+    void printResult() const
+    {
+        Statistics frame = computeStatistics(m_frameMilliseconds);
+        Statistics cpu   = computeStatistics(m_cpuSamples);
+        Statistics gpu   = computeStatistics(m_gpuSamples);
+
+        std::printf("RESULT {\"app\": \"%s\", \"scene\": \"%s\", \"width\": %d, \"height\": %d, "
+            "\"frameMean\": %.4f, \"frameP50\": %.4f, \"frameP95\": %.4f, \"frameP99\": %.4f, \"frameMax\": %.4f, "
+            "\"cpuMean\": %.4f, \"cpuP95\": %.4f, \"gpuMean\": %.4f, \"gpuP95\": %.4f, \"gpuSupported\": %s, "
+            "\"peakResidentKilobytes\": %.0f, \"allocationsPerFrame\": %.2f, "
+            "\"arenaHeapAllocations\": %llu, \"arenaPeakKilobytes\": %.1f, "
+            "\"video\": %s, \"videoWidth\": %d, \"videoHeight\": %d, \"videoPresentedFrames\": %llu, \"videoDroppedFrames\": %llu}\n",
+            m_options.app.c_str(), m_options.scene.c_str(), m_options.width, m_options.height,
+            frame.mean, frame.p50, frame.p95, frame.p99, frame.max,
+            cpu.mean, cpu.p95, gpu.mean, gpu.p95, m_gpuTimer.supported() ? "true" : "false",
+            peakResidentKilobytes(), m_allocationsPerFrame,
+            (unsigned long long)m_arenaHeapAllocations, m_frameArena->peakBytesAllocated() / 1024.0,
+            m_video ? "true" : "false", m_video ? m_video->width() : 0, m_video ? m_video->height() : 0,
+            (unsigned long long)m_videoPresentedFrames, (unsigned long long)m_videoDroppedFrames);
+    }
+
+private:
+    static float millisecondsSince(Clock::time_point begin)
+    {
+        return std::chrono::duration<float, std::milli>(Clock::now() - begin).count();
+    }
+
+    Options                                   m_options;
+    int                                       m_frame;
+    float                                     m_cpuMilliseconds;
+    mojo::GPUTimer                            m_gpuTimer;
+    unsigned long long                        m_allocationsBegin;
+    double                                    m_allocationsPerFrame;
+    G3D::shared_ptr<mojo::FrameArena>         m_frameArena;
+    std::uint64_t                             m_arenaHeapAllocationsBegin;
+    std::uint64_t                             m_arenaHeapAllocations;
+    Clock::time_point                         m_previousFrameBegin;
+    std::vector<float>                        m_frameMilliseconds;
+    std::vector<float>                        m_cpuSamples;
+    std::vector<float>                        m_gpuSamples;
+    bool                                      m_failed;
+    G3D::shared_ptr<mojo::VideoTextureSource> m_video;
+    std::uint64_t                             m_videoPresentedBegin;
+    std::uint64_t                             m_videoDroppedBegin;
+    std::uint64_t                             m_videoPresentedFrames;
+    std::uint64_t                             m_videoDroppedFrames;
+};
+
+G3D::GApp::Settings makeSettings(const Options& options)
+{
+    G3D::GApp::Settings settings;
+    settings.window.caption      = "FrameTimeBenchmark";
+    settings.window.width        = options.width;
+    settings.window.height       = options.height;
+    settings.window.visible      = false;
+    settings.window.asynchronous = true;
+    return settings;
+}
+
+template <typename App>
+int runApp(const Options& options)
+{
+    BenchmarkApp<App> app(makeSettings(options), options);
+    int exitCode = app.run();
+    if (app.failed()) {
+        return 1;
+    }
+
+    app.printResult();
+    return exitCode;
+}
+
+//
+// Our JSON is written one run per line, so reading it back only needs to find keys
+// within a line.
+//
+bool findNumber(const std::string& line, const char* key, double& value)
+{
+    std::string quotedKey = std::string("\"") + key + "\": ";
+    std::string::size_type position = line.find(quotedKey);
+    if (position == std::string::npos) {
+        return false;
+    }
+
+    value = std::atof(line.c_str() + position + quotedKey.size());
+    return true;
+}
+
+std::string findString(const std::string& line, const char* key)
+{
+    std::string quotedKey = std::string("\"") + key + "\": \"";
+    std::string::size_type begin = line.find(quotedKey);
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+
+    begin += quotedKey.size();
+    return line.substr(begin, line.find('"', begin) - begin);
+}
+
+std::string runKey(const std::string& line)
+{
+    double width  = 0.0;
+    double height = 0.0;
+    findNumber(line, "width", width);
+    findNumber(line, "height", height);
+
+    // a run with video is compared with the baseline's run with video, whichever clip it played
+    std::string video = line.find("\"video\": true") != std::string::npos ? " video" : "";
+
+    return findString(line, "app") + " " + findString(line, "scene") + " " + std::to_string((int)width) + "x" + std::to_string((int)height) + video;
+}
+
+std::vector<std::string> readRuns(const char* filename)
+{
+    std::vector<std::string> runs;
+
+    std::FILE* file = std::fopen(filename, "r");
+    if (file == NULL) {
+        std::fprintf(stderr, "Cannot open %s\n", filename);
+        return runs;
+    }
+
+    char buffer[4096];
+    while (std::fgets(buffer, sizeof(buffer), file) != NULL) {
+        if (std::strstr(buffer, "\"app\"") != NULL) {
+            runs.push_back(buffer);
+        }
+    }
+
+    std::fclose(file);
+    return runs;
+}
+
+//
+// Flags every run whose frame, CPU or GPU time got worse than the baseline by more
+// than the tolerance, e.g., 0.1 for 10%.
+//
+bool compareWithBaseline(const std::vector<std::string>& runs, const char* baselineFilename, double tolerance)
+{
+    static const char* const kKeys[] = { "frameMean", "frameP95", "frameP99", "cpuMean", "gpuMean" };
+
+    std::vector<std::string> baselineRuns = readRuns(baselineFilename);
+    bool                     regressed    = false;
+
+    for (const std::string& run : runs) {
+        std::string key = runKey(run);
+
+        std::vector<std::string>::const_iterator baseline = std::find_if(baselineRuns.begin(), baselineRuns.end(),
+            [&key](const std::string& baselineRun) { return runKey(baselineRun) == key; });
+
+        if (baseline == baselineRuns.end()) {
+            std::printf("%-40s not in baseline\n", key.c_str());
+            continue;
+        }
+
+        for (const char* statistic : kKeys) {
+            double current  = 0.0;
+            double previous = 0.0;
+            if (!findNumber(run, statistic, current) || !findNumber(*baseline, statistic, previous) || previous <= 0.0) {
+                continue;
+            }
+
+            double change = current / previous - 1.0;
+            bool   worse  = change > tolerance;
+            regressed    |= worse;
+
+            std::printf("%-40s %-10s %9.3f ms -> %9.3f ms  %+6.1f%%%s\n",
+                key.c_str(), statistic, previous, current, change * 100.0, worse ? "  REGRESSION" : "");
+        }
+    }
+
+    return !regressed;
+}
+
+//
+// Flags every run whose frame arena went to the heap after the warmup frames. Once
+// the arena has grown to the size of a frame, a frame should never need more.
+//
+bool checkArenaAllocations(const std::vector<std::string>& runs)
+{
+    bool allocated = false;
+
+    for (const std::string& run : runs) {
+        double heapAllocations = 0.0;
+        if (findNumber(run, "arenaHeapAllocations", heapAllocations) && heapAllocations > 0.0) {
+            std::printf("%-40s frame arena allocated from the heap %.0f times after warmup  ALLOCATES\n", runKey(run).c_str(), heapAllocations);
+            allocated = true;
+        }
+    }
+
+    return !allocated;
+}
+
+//
+// The heap allocations a measured frame of each app may make on the render thread,
+// with the app's own scene. The transient containers of our own code come from the
+// frame arena, whose budget is zero, see checkArenaAllocations(...). These budgets
+// cover what G3D itself still allocates every frame, e.g., the surfaces that
+// G3D::ArticulatedModel::pose(...) and the GUI create, their shared_ptr control
+// blocks, and the strings of screenPrintf(...). They are upper bounds with headroom;
+// lower them as G3D's share goes down, never raise them to let a change through.
+//
+struct AllocationBudget
+{
+    const char* app;
+    const char* scene;
+    double      allocationsPerFrame;
+};
+
+const AllocationBudget kAllocationBudgets[] = {
+    { "starter",     "", 256.0 },
+    { "pixelshader", "", 128.0 },
+};
+
+bool findAllocationBudget(const std::string& run, double& budget)
+{
+    std::string app   = findString(run, "app");
+    std::string scene = findString(run, "scene");
+
+    for (const AllocationBudget& allocationBudget : kAllocationBudgets) {
+        if (app == allocationBudget.app && scene == allocationBudget.scene) {
+            budget = allocationBudget.allocationsPerFrame;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+// Flags every run that made more heap allocations per measured frame than its budget.
+// The budget is the smallest of --allocations, the same run of the baseline, and,
+// without either, the app's budget in kAllocationBudgets. A run without any budget,
+// e.g., of another scene, fails, so a run always proves something about its frames.
+// Allocation counts do not depend on timing, so unlike the timings they are compared
+// without a tolerance.
+//
+bool checkAllocationsPerFrame(const std::vector<std::string>& runs, const char* baselineFilename, double maxAllocationsPerFrame)
+{
+    std::vector<std::string> baselineRuns;
+    if (baselineFilename != NULL) {
+        baselineRuns = readRuns(baselineFilename);
+    }
+
+    bool allocated = false;
+
+    for (const std::string& run : runs) {
+        double allocationsPerFrame = 0.0;
+        if (!findNumber(run, "allocationsPerFrame", allocationsPerFrame)) {
+            continue;
+        }
+
+        double budget = maxAllocationsPerFrame;
+
+        std::string key = runKey(run);
+        std::vector<std::string>::const_iterator baseline = std::find_if(baselineRuns.begin(), baselineRuns.end(),
+            [&key](const std::string& baselineRun) { return runKey(baselineRun) == key; });
+
+        double previous = 0.0;
+        if (baseline != baselineRuns.end() && findNumber(*baseline, "allocationsPerFrame", previous)) {
+            budget = (budget < 0.0) ? previous : std::min(budget, previous);
+        }
+
+        if (budget < 0.0 && !findAllocationBudget(run, budget)) {
+            std::printf("%-40s %.2f heap allocations per frame, no budget  NO BUDGET\n", key.c_str(), allocationsPerFrame);
+            allocated = true;
+            continue;
+        }
+
+        // the count is averaged over the measured frames, so allow for rounding in the JSON
+        bool over  = allocationsPerFrame > budget + 0.005;
+        allocated |= over;
+
+        std::printf("%-40s %.2f heap allocations per frame, budget %.2f%s\n",
+            key.c_str(), allocationsPerFrame, budget, over ? "  ALLOCATES" : "");
+    }
+
+    return !allocated;
+}
+
+//
+// Shows what playing the video costs: the frame times of every run with video next to
+// the same run without it. The video must not drop the render frame rate, so a run
+// whose frame time percentiles got worse than without video by more than the
+// tolerance, e.g., 0.1 for 10%, fails. The means are only shown.
+//
+bool compareVideoRuns(const std::vector<std::string>& runs, double tolerance)
+{
+    static const char* const kKeys[] = { "frameMean", "frameP95", "frameP99", "cpuMean", "gpuMean" };
+
+    bool slowed = false;
+
+    for (const std::string& run : runs) {
+        if (run.find("\"video\": true") == std::string::npos) {
+            continue;
+        }
+
+        std::string key        = runKey(run);
+        std::string withoutKey = key.substr(0, key.size() - std::strlen(" video"));
+
+        std::vector<std::string>::const_iterator without = std::find_if(runs.begin(), runs.end(),
+            [&withoutKey](const std::string& otherRun) { return runKey(otherRun) == withoutKey; });
+
+        double videoWidth      = 0.0;
+        double videoHeight     = 0.0;
+        double presentedFrames = 0.0;
+        double droppedFrames   = 0.0;
+        findNumber(run, "videoWidth", videoWidth);
+        findNumber(run, "videoHeight", videoHeight);
+        findNumber(run, "videoPresentedFrames", presentedFrames);
+        findNumber(run, "videoDroppedFrames", droppedFrames);
+
+        std::printf("%-40s %dx%d video, %.0f frames presented, %.0f dropped\n",
+            key.c_str(), (int)videoWidth, (int)videoHeight, presentedFrames, droppedFrames);
+
+        if (without == runs.end()) {
+            continue;
+        }
+
+        for (const char* statistic : kKeys) {
+            double withVideo    = 0.0;
+            double withoutVideo = 0.0;
+            if (!findNumber(run, statistic, withVideo) || !findNumber(*without, statistic, withoutVideo) || withoutVideo <= 0.0) {
+                continue;
+            }
+
+            double change     = withVideo / withoutVideo - 1.0;
+            bool   percentile = std::strcmp(statistic, "frameP95") == 0 || std::strcmp(statistic, "frameP99") == 0;
+            bool   slower     = percentile && change > tolerance;
+            slowed           |= slower;
+
+            std::printf("%-40s %-10s %9.3f ms without video -> %9.3f ms with  %+6.1f%%%s\n",
+                key.c_str(), statistic, withoutVideo, withVideo, change * 100.0, slower ? "  SLOWED BY VIDEO" : "");
+        }
+    }
+
+    return !slowed;
+}
+
+void printUsage()
+{
+    std::printf(
+        "FrameTimeBenchmark [options]\n"
+        "  --apps starter,pixelshader     apps to run\n"
+        "  --scene NAME                   scene for StarterApp (default: the app's own)\n"
+        "  --video FILE                   also run pixelshader playing FILE, e.g., a 4K clip\n"
+        "  --resolutions 640x360,...      framebuffer sizes to run at\n"
+        "  --warmup N                     frames before measuring (default 120)\n"
+        "  --frames N                     measured frames (default 600)\n"
+        "  --output FILE                  write the results as JSON (default: stdout)\n"
+        "  --baseline FILE                compare against a previous --output\n"
+        "  --tolerance T                  allowed slowdown vs. the baseline (default 0.1)\n"
+        "  --video-tolerance T            allowed frameP95 and frameP99 slowdown with --video vs. without (default 0.1)\n"
+        "  --allocations N                heap allocations allowed per measured frame (default: the baseline's, or the app's own)\n");
+}
+
+std::vector<std::string> split(const std::string& string, char separator)
+{
+    std::vector<std::string> parts;
+    std::string::size_type   begin = 0;
+
+    while (begin <= string.size()) {
+        std::string::size_type end = string.find(separator, begin);
+        if (end == std::string::npos) {
+            end = string.size();
+        }
+        if (end > begin) {
+            parts.push_back(string.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+
+    return parts;
+}
+
+}
+
+//
+// Each app and resolution runs in a child process of its own (--run), so every run
+// starts from a fresh OpenGL context and reports its own peak memory.
+//
+int main(int argc, char* argv[]) {
+    Options options;
+    options.app            = "starter";
+    options.width          = 1280;
+    options.height         = 720;
+    options.warmupFrames   = 120;
+    options.measuredFrames = 600;
+
+    std::string apps           = "starter,pixelshader";
+    std::string resolutions    = "640x360,1280x720,1920x1080";
+    const char* output         = NULL;
+    const char* baseline       = NULL;
+    double      tolerance      = 0.1;
+    double      videoTolerance = 0.1;
+    double      allocations    = -1.0;
+    bool        child          = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        const char* value    = i + 1 < argc ? argv[i + 1] : "";
+
+        if      (argument == "--run")             { child = true; options.app = value; ++i; }
+        else if (argument == "--apps")            { apps = value; ++i; }
+        else if (argument == "--scene")           { options.scene = value; ++i; }
+        else if (argument == "--video")           { options.video = value; ++i; }
+        else if (argument == "--resolutions")     { resolutions = value; ++i; }
+        else if (argument == "--width")           { options.width = std::atoi(value); ++i; }
+        else if (argument == "--height")          { options.height = std::atoi(value); ++i; }
+        else if (argument == "--warmup")          { options.warmupFrames = std::atoi(value); ++i; }
+        else if (argument == "--frames")          { options.measuredFrames = std::atoi(value); ++i; }
+        else if (argument == "--output")          { output = value; ++i; }
+        else if (argument == "--baseline")        { baseline = value; ++i; }
+        else if (argument == "--tolerance")       { tolerance = std::atof(value); ++i; }
+        else if (argument == "--video-tolerance") { videoTolerance = std::atof(value); ++i; }
+        else if (argument == "--allocations")     { allocations = std::atof(value); ++i; }
+        else                                      { printUsage(); return 1; }
+    }
+
+    if (child) {
+        if (options.app == "starter") {
+            return runApp<G3D::StarterApp>(options);
+        }
+        if (options.app == "pixelshader") {
+            return runApp<G3D::PixelShaderApp>(options);
+        }
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::string> runs;
+    bool                     success = true;
+
+    for (const std::string& app : split(apps, ',')) {
+
+        // with --video, pixelshader runs once without and once with the video
+        std::vector<std::string> videos(1);
+        if (app == "pixelshader" && !options.video.empty()) {
+            videos.push_back(options.video);
+        }
+
+        for (const std::string& resolution : split(resolutions, ',')) {
+            int width  = 0;
+            int height = 0;
+            if (std::sscanf(resolution.c_str(), "%dx%d", &width, &height) != 2) {
+                printUsage();
+                return 1;
+            }
+
+            for (const std::string& video : videos) {
+                std::string command = std::string("\"") + argv[0] + "\" --run " + app +
+                    " --width " + std::to_string(width) + " --height " + std::to_string(height) +
+                    " --warmup " + std::to_string(options.warmupFrames) + " --frames " + std::to_string(options.measuredFrames);
+                if (!options.scene.empty()) {
+                    command += " --scene \"" + options.scene + "\"";
+                }
+                if (!video.empty()) {
+                    command += " --video \"" + video + "\"";
+                }
+
+                std::FILE* pipe = popen(command.c_str(), "r");
+                if (pipe == NULL) {
+                    std::fprintf(stderr, "Cannot run %s\n", command.c_str());
+                    return 1;
+                }
+
+                bool reported = false;
+                char buffer[4096];
+                while (std::fgets(buffer, sizeof(buffer), pipe) != NULL) {
+                    if (std::strncmp(buffer, "RESULT ", 7) == 0) {
+                        runs.push_back(buffer + 7);
+                        reported = true;
+                    }
+                }
+
+                if (pclose(pipe) != 0 || !reported) {
+                    std::fprintf(stderr, "%s %dx%d%s failed\n", app.c_str(), width, height, video.empty() ? "" : " with video");
+                    success = false;
+                }
+            }
+        }
+    }
+
+    std::FILE* file = output != NULL ? std::fopen(output, "w") : stdout;
+    if (file == NULL) {
+        std::fprintf(stderr, "Cannot write %s\n", output);
+        return 1;
+    }
+
+    std::fprintf(file, "{\n  \"warmupFrames\": %d,\n  \"measuredFrames\": %d,\n  \"runs\": [\n", options.warmupFrames, options.measuredFrames);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        std::string run = runs[i];
+        run.erase(run.find_last_not_of("\r\n") + 1);
+        std::fprintf(file, "    %s%s\n", run.c_str(), i + 1 < runs.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+
+    if (file != stdout) {
+        std::fclose(file);
+    }
+
+    success &= compareVideoRuns(runs, videoTolerance);
+    success &= checkArenaAllocations(runs);
+    success &= checkAllocationsPerFrame(runs, baseline, allocations);
+
+    if (baseline != NULL) {
+        success &= compareWithBaseline(runs, baseline, tolerance);
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+#-------------------------------------------------
+#
+# Runs StarterApp and PixelShaderApp in a hidden
+# window for a fixed number of frames and reports
+# frame time statistics as JSON.
+#
+#-------------------------------------------------
+
+QT += core gui widgets
+
+TARGET = FrameTimeBenchmark
+
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++11
+
+TEMPLATE = app
+
+QMAKE_CXXFLAGS_WARN_ON  = ""
+QMAKE_CXXFLAGS         += -msse4.1 -Wno-unknown-pragmas
+
+INCLUDEPATH +=              \
+    /opt/local/include      \
+    ${G3D10DATA}/../include \
+    ../../code              \
+
+LIBS +=                      \
+    -L"${G3D10DATA}/../lib/" \
+
+macx {
+    LIBS +=                      \
+        -F"/Library/Frameworks/" \
+        -framework Cocoa         \
+        -framework CoreVideo     \
+        -framework OpenGL        \
+        -framework SDL           \
+        -lavcodec.56             \
+        -lavformat.56            \
+        -lavutil.54              \
+        -lfmod                   \
+        -lfreeimage              \
+        -lswscale.3              \
+        -lz                      \
+}
+
+#
+# Linux builds link G3D against X11 and libGL. With Mesa's software rasterizer,
+# llvmpipe, the benchmark runs on machines without a GPU, e.g., CI runners, see
+# run_headless.sh.
+#
+unix:!macx {
+    LIBS +=          \
+        -lavcodec    \
+        -lavformat   \
+        -lavutil     \
+        -lfmod       \
+        -lfreeimage  \
+        -lswscale    \
+        -lz          \
+        -lGL         \
+        -lX11        \
+        -lXcursor    \
+        -lXi         \
+        -lXinerama   \
+        -lXrandr     \
+        -lXxf86vm    \
+        -lpthread    \
+        -ldl         \
+
+    QMAKE_RPATHDIR += ${G3D10DATA}/../lib
+}
+
+CONFIG(debug,   release|debug):LIBS += -lG3Dd -lGLG3Dd -lassimpd -lcivetwebd -lenetd -lglewd -lglfwd -lnfdd -lzipd
+CONFIG(release, release|debug):LIBS += -lG3D  -lGLG3D  -lassimp  -lcivetweb  -lenet  -lglew  -lglfw  -lnfd  -lzip
+
+HEADERS +=                            \
+    ../../code/ShaderWatcher.hpp      \
+    ../../code/ContentHash.hpp        \
+    ../../code/TextureCache.hpp       \
+    ../../code/FlatMesh.hpp           \
+    ../../code/MeshCache.hpp          \
+    ../../code/VideoTextureSource.hpp \
+
+SOURCES +=                                       \
+    FrameTimeBenchmark.cpp                       \
+    ../../code/Assert.cpp                        \
+    ../../code/Log.cpp                           \
+    ../../code/Printf.cpp                        \
+    ../../code/GPUTimer.cpp                      \
+    ../../code/FrameArena.cpp                    \
+    ../../code/FrameProfiler.cpp                 \
+    ../../code/DynamicResolutionController.cpp   \
+    ../../code/CachedGUILayer.cpp                \
+    ../../code/RenderTargetSetup.cpp             \
+    ../../code/ShaderWatcher.cpp                 \
+    ../../code/ContentHash.cpp                   \
+    ../../code/TextureCache.cpp                  \
+    ../../code/FlatMesh.cpp                      \
+    ../../code/MeshCache.cpp                     \
+    ../../code/VideoTextureSource.cpp            \
+    ../../code/PixelShaderApp.cpp                \
+    ../../code/StarterApp.cpp                    \
+
+QMAKE_POST_LINK +=                  \
+    cp ../../bin/*     $$OUT_PWD && \
+    cp ../../shaders/* $$OUT_PWD    \
+
+macx:QMAKE_POST_LINK += && install_name_tool -change "@rpath/libfmod.dylib" "@loader_path/libfmod.dylib" $$OUT_PWD/${TARGET}
@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Builds FrameTimeBenchmark on Linux and runs it on a machine without a GPU, e.g., a
+# CI runner. G3D still opens an OpenGL window, so the benchmark runs on a virtual X
+# server (Xvfb) and renders with Mesa's software rasterizer, llvmpipe, which also
+# supports the timestamp queries behind the GPU times.
+#
+# Software rendering is much slower than a GPU, and its times depend on the runner's
+# CPU, so compare timings only against a baseline recorded on the same kind of runner.
+# The allocation checks do not depend on timing and hold anywhere.
+#
+# Usage: run_headless.sh [FrameTimeBenchmark options]
+#
+#   e.g. run_headless.sh --resolutions 640x360 --frames 300 --baseline baseline.json
+#        run_headless.sh --apps pixelshader --resolutions 1920x1080 --video clip-3840x2160.mp4
+#
+# With --video, pixelshader also runs playing the clip in its reflections, and the
+# frame times of that run are printed next to those of the run without video. llvmpipe
+# shares the CPU with the video's decoding and conversion threads, so measure what
+# video costs on a machine with a GPU.
+#
+# Requires qmake, make, xvfb-run and Mesa's libGL, and G3D10DATA set as for any build.
+#
+
+set -e
+
+BENCHMARK_DIR=$(cd "$(dirname "$0")" && pwd)
+BUILD_DIR="$BENCHMARK_DIR/../build-FrameTimeBenchmark-headless"
+JOBS=$(nproc)
+
+mkdir -p "$BUILD_DIR"
+(cd "$BUILD_DIR" && qmake "$BENCHMARK_DIR/FrameTimeBenchmark.pro" CONFIG+=release && make -j"$JOBS")
+
+cd "$BUILD_DIR"
+LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe \
+    xvfb-run --auto-servernum --server-args="-screen 0 3840x2160x24" \
+    ./FrameTimeBenchmark "$@"
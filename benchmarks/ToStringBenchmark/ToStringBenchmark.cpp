@@ -0,0 +1,162 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <boost/lexical_cast.hpp>
+
+#include "ToString.hpp"
+
+//
+// Count heap allocations, so we can report allocations per call alongside the time
+// per call.
+//
+static unsigned long long g_allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    ++g_allocationCount;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace legacy
+{
+
+//
+// The previous implementation of mojo::toString: every argument becomes a temporary
+// std::string via boost::lexical_cast, and the temporaries are joined with operator+.
+//
+template <typename T>
+inline std::string toStringHelper(T t)
+{
+    return boost::lexical_cast<std::string>(t);
+}
+
+template <typename T00>
+inline std::string toString(T00 t00)
+{
+    return std::string(toStringHelper(t00));
+}
+
+template <typename T00, typename... Types>
+inline std::string toString(T00 t00, Types... values)
+{
+    return std::string(toStringHelper(t00) + toString(values...));
+}
+
+}
+
+namespace
+{
+
+struct Result
+{
+    double             nanosecondsPerCall;
+    double             allocationsPerCall;
+    unsigned long long checksum;
+};
+
+template <typename Function>
+Result measure(int iterations, Function function)
+{
+    Result result;
+    result.checksum = 0;
+
+    unsigned long long allocationsBegin = g_allocationCount;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        result.checksum += function(i);
+    }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    result.nanosecondsPerCall = std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+    result.allocationsPerCall = (double)(g_allocationCount - allocationsBegin) / iterations;
+    return result;
+}
+
+template <typename LegacyFunction, typename NewFunction>
+bool runWorkload(const char* name, int iterations, LegacyFunction legacyFunction, NewFunction newFunction)
+{
+    Result legacyResult = measure(iterations, legacyFunction);
+    Result newResult    = measure(iterations, newFunction);
+
+    std::printf("%-28s legacy %9.1f ns/call %6.2f allocs/call    new %9.1f ns/call %6.2f allocs/call    speedup %5.2fx\n",
+        name,
+        legacyResult.nanosecondsPerCall, legacyResult.allocationsPerCall,
+        newResult.nanosecondsPerCall,    newResult.allocationsPerCall,
+        legacyResult.nanosecondsPerCall / newResult.nanosecondsPerCall);
+
+    return legacyResult.checksum == newResult.checksum;
+}
+
+bool checkSameOutput()
+{
+    bool same = true;
+
+    #define CHECK_SAME_OUTPUT(...)                                                                  \
+        if (legacy::toString(__VA_ARGS__) != mojo::toString(__VA_ARGS__)) {                        \
+            std::printf("MISMATCH: \"%s\" != \"%s\"\n",                                            \
+                legacy::toString(__VA_ARGS__).c_str(), mojo::toString(__VA_ARGS__).c_str());       \
+            same = false;                                                                          \
+        }
+
+    CHECK_SAME_OUTPUT("Filename: ", __FILE__, "\n\nLine Number: ", __LINE__, "\n\nExpression: ", "x != NULL");
+    CHECK_SAME_OUTPUT(0, -1, 1, 2147483647, -2147483647 - 1, 4294967295u, -9223372036854775807LL - 1, 18446744073709551615ULL);
+    CHECK_SAME_OUTPUT((short)-32768, (unsigned short)65535, 123456789L, 987654321UL);
+    CHECK_SAME_OUTPUT(0.0, -0.0, 0.1, 1.0 / 3.0, 1e300, -1e-300, 123456.789, 5e-324);
+    CHECK_SAME_OUTPUT(0.0f, 0.1f, 1.0f / 3.0f, 3.402823e38f, -1.5f, 16777216.0f);
+    CHECK_SAME_OUTPUT(1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0, 1.0f / 0.0f);
+    CHECK_SAME_OUTPUT(0.1L, 1.0L / 3.0L);
+    CHECK_SAME_OUTPUT(true, false, 'a', (signed char)'b', (unsigned char)'c');
+    CHECK_SAME_OUTPUT(std::string("std::string"), " ", (const void*)&same);
+
+    #undef CHECK_SAME_OUTPUT
+
+    return same;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    bool success = checkSameOutput();
+
+    success &= runWorkload("log line (string, int, float)", iterations,
+        [](int i) { return legacy::toString("Frame ", i, " took ", i * 0.001f, " ms").size(); },
+        [](int i) { return mojo::toString("Frame ", i, " took ", i * 0.001f, " ms").size(); });
+
+    success &= runWorkload("assert message (6 args)", iterations,
+        [](int i) { return legacy::toString("Filename: ", __FILE__, "\n\nLine Number: ", i, "\n\nExpression: ", "m_initialized").size(); },
+        [](int i) { return mojo::toString("Filename: ", __FILE__, "\n\nLine Number: ", i, "\n\nExpression: ", "m_initialized").size(); });
+
+    success &= runWorkload("integers only (8 args)", iterations,
+        [](int i) { return legacy::toString(i, ",", i * 7, ",", -i, ",", i * 1000003LL, ";").size(); },
+        [](int i) { return mojo::toString(i, ",", i * 7, ",", -i, ",", i * 1000003LL, ";").size(); });
+
+    success &= runWorkload("doubles (3 args)", iterations,
+        [](int i) { return legacy::toString(i * 0.1, " ", i / 3.0, " ", 1.0 / (i + 1)).size(); },
+        [](int i) { return mojo::toString(i * 0.1, " ", i / 3.0, " ", 1.0 / (i + 1)).size(); });
+
+    std::string buffer;
+    success &= runWorkload("appendToString (reused)", iterations,
+        [](int i) { return legacy::toString("Frame ", i, " took ", i * 0.001f, " ms").size(); },
+        [&buffer](int i) { buffer.clear(); mojo::appendToString(buffer, "Frame ", i, " took ", i * 0.001f, " ms"); return buffer.size(); });
+
+    std::printf("%s\n", success ? "Output matches the legacy implementation." : "Output DIFFERS from the legacy implementation.");
+    return success ? 0 : 1;
+}
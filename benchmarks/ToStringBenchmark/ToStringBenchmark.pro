@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Compares mojo::toString against the previous
+# boost::lexical_cast based implementation.
+#
+#-------------------------------------------------
+
+TARGET = ToStringBenchmark
+
+CONFIG += console
+CONFIG -= app_bundle qt
+CONFIG += c++11
+
+TEMPLATE = app
+
+QMAKE_CXXFLAGS_WARN_ON  = ""
+QMAKE_CXXFLAGS         += -msse4.1 -Wno-unknown-pragmas
+
+INCLUDEPATH +=         \
+    /opt/local/include \
+    ../../code         \
+
+SOURCES +=                 \
+    ToStringBenchmark.cpp  \
@@ -0,0 +1,149 @@
+#include "Assert.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include <QtCore/QThread>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QMessageBox>
+
+#include "Log.hpp"
+#include "Printf.hpp"
+#include "ToString.hpp"
+
+namespace mojo
+{
+
+namespace
+{
+
+std::mutex  s_failedSitesMutex;
+AssertSite* s_failedSites = NULL;
+
+void printAssertFailuresOnExit() {
+    printAssertFailures();
+    flushLog();
+}
+
+//
+// With ASSERT_POLICY_COUNT_ONLY nothing is logged when an assert fails, so the counts
+// are logged at exit instead, however the policy was set.
+//
+void printAssertFailuresAtExit() {
+    static std::once_flag registered;
+    std::call_once(registered, [] { std::atexit(&printAssertFailuresOnExit); });
+}
+
+AssertPolicy initialAssertPolicy() {
+    const char* policy = std::getenv("MOJO_ASSERT_POLICY");
+
+    if (policy == NULL) {
+        return ASSERT_POLICY_MODAL_DIALOG;
+    }
+
+    if (std::strcmp(policy, "continue") == 0) {
+        return ASSERT_POLICY_LOG_AND_CONTINUE;
+    }
+
+    if (std::strcmp(policy, "abort") == 0) {
+        return ASSERT_POLICY_LOG_AND_ABORT;
+    }
+
+    if (std::strcmp(policy, "count") == 0) {
+        printAssertFailuresAtExit();
+        return ASSERT_POLICY_COUNT_ONLY;
+    }
+
+    return ASSERT_POLICY_MODAL_DIALOG;
+}
+
+std::atomic<int>& assertPolicyStorage() {
+    static std::atomic<int> policy(initialAssertPolicy());
+    return policy;
+}
+
+void showModalDialog(const AssertSite& site, const char* modalDialogTitle) {
+    std::string assertMessage = toString("Filename: ", site.file, "\n\n\n\nLine Number: ", site.line, "\n\n\n\nExpression: ", site.expression);
+
+    QMessageBox messageBox;
+    messageBox.setText(modalDialogTitle);
+    messageBox.setInformativeText(QString(assertMessage.c_str()));
+    messageBox.setStandardButtons(QMessageBox::Abort | QMessageBox::Ignore | QMessageBox::Retry);
+    int response = messageBox.exec();
+    bool debugBreak = false;
+    switch(response)
+    {
+        case QMessageBox::Abort:  exit( -1 );
+        case QMessageBox::Ignore: break;
+        case QMessageBox::Retry:  debugBreak = true; break;
+        default:                  debugBreak = true; break;
+    }
+    if (debugBreak)
+    {
+        __asm__("int $3");
+    }
+}
+
+}
+
+void setAssertPolicy(AssertPolicy policy) {
+    if (policy == ASSERT_POLICY_COUNT_ONLY) {
+        printAssertFailuresAtExit();
+    }
+
+    assertPolicyStorage().store(policy, std::memory_order_relaxed);
+}
+
+AssertPolicy assertPolicy() {
+    return (AssertPolicy)assertPolicyStorage().load(std::memory_order_relaxed);
+}
+
+void printAssertFailures() {
+    std::lock_guard<std::mutex> lock(s_failedSitesMutex);
+
+    for (AssertSite* site = s_failedSites; site != NULL; site = site->next) {
+        printf(site->file, ":", site->line, ": ", site->expression, " failed ", site->failureCount.load(std::memory_order_relaxed), " time(s)");
+    }
+}
+
+void assertFailed(AssertSite& site, const char* modalDialogTitle) {
+    std::uint64_t failureCount = site.failureCount.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    if (failureCount == 1) {
+        std::lock_guard<std::mutex> lock(s_failedSitesMutex);
+        site.next     = s_failedSites;
+        s_failedSites = &site;
+    }
+
+    AssertPolicy policy = assertPolicy();
+
+    if (policy == ASSERT_POLICY_COUNT_ONLY) {
+        return;
+    }
+
+    //
+    // An assert that keeps failing, e.g., once per frame, would otherwise flood the log,
+    // so when continuing we only log the 1st, 2nd, 4th, 8th, ... failure of each assert.
+    //
+    if (policy == ASSERT_POLICY_LOG_AND_CONTINUE && (failureCount & (failureCount - 1)) != 0) {
+        return;
+    }
+
+    printf("\n\n\n", modalDialogTitle, "\n\nFilename: ", site.file, "\n\nLine Number: ", site.line, "\n\nExpression: ", site.expression, "\n\nFailure Count: ", failureCount, "\n\n\n");
+    flushLog();
+
+    // Qt widgets may only be created on the GUI thread, e.g., not on an IngestPipeline worker
+    if (policy == ASSERT_POLICY_MODAL_DIALOG && (QApplication::instance() == NULL || QThread::currentThread() != QApplication::instance()->thread())) {
+        policy = ASSERT_POLICY_LOG_AND_ABORT;
+    }
+
+    switch(policy) {
+    case ASSERT_POLICY_MODAL_DIALOG:     showModalDialog(site, modalDialogTitle); break;
+    case ASSERT_POLICY_LOG_AND_ABORT:    std::abort();
+    default:                             break;
+    }
+}
+
+}
@@ -1,44 +1,72 @@
 #ifndef ASSERT_HPP
 #define ASSERT_HPP
 
-#include <string>
-
-#include <QtWidgets/QMessageBox>
-
-#include "Printf.hpp"
-#include "ToString.hpp"
-
-#define MOJO_ASSERT_HELPER(expression, modalDialogTitle)                                                                                                               \
-    do                                                                                                                                                                 \
-    {                                                                                                                                                                  \
-        if (!(expression))                                                                                                                                             \
-        {                                                                                                                                                              \
-            std::string assertMessage       = mojo::toString("Filename: ", __FILE__, "\n\n\n\nLine Number: ", __LINE__, "\n\n\n\nExpression: ", #expression );         \
-            std::string assertMessagePrintf = mojo::toString("Filename: ", __FILE__, "\n\nLine Number: ",     __LINE__, "\n\nExpression: ",     #expression );         \
-            mojo::printf("\n\n\n", assertMessagePrintf, "\n\n\n");                                                                                                     \
-            QMessageBox messageBox;                                                                                                                                    \
-            messageBox.setText(modalDialogTitle);                                                                                                                      \
-            messageBox.setInformativeText(QString(assertMessage.c_str()));                                                                                             \
-            messageBox.setStandardButtons(QMessageBox::Abort | QMessageBox::Ignore | QMessageBox::Retry);                                                              \
-            int response = messageBox.exec();                                                                                                                          \
-            bool debugBreak = false;                                                                                                                                   \
-            switch(response)                                                                                                                                           \
-            {                                                                                                                                                          \
-                case QMessageBox::Abort:  exit( -1 );                                                                                                                  \
-                case QMessageBox::Ignore: break;                                                                                                                       \
-                case QMessageBox::Retry:  debugBreak = true; break;                                                                                                    \
-                default:                  debugBreak = true; break;                                                                                                    \
-            }                                                                                                                                                          \
-            if (debugBreak)                                                                                                                                            \
-            {                                                                                                                                                          \
-                __asm__("int $3");                                                                                                                                     \
-                debugBreak = false;                                                                                                                                    \
-            }                                                                                                                                                          \
-            while (debugBreak)                                                                                                                                         \
-            {                                                                                                                                                          \
-            }                                                                                                                                                          \
-        }                                                                                                                                                              \
-    } while (0)                                                                                                                                                        \
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mojo
+{
+
+//
+// What happens when an assert fails. ASSERT_POLICY_MODAL_DIALOG is the default and
+// shows the Abort/Ignore/Retry dialog, unless there is no QApplication to show it
+// with, or the assert failed on a thread other than the QApplication's, in which
+// case it behaves like ASSERT_POLICY_LOG_AND_ABORT. The policy can be set with
+// setAssertPolicy(...), or at startup with the MOJO_ASSERT_POLICY environment
+// variable ("dialog", "continue", "abort" or "count"), so headless runs never block.
+//
+enum AssertPolicy
+{
+    ASSERT_POLICY_MODAL_DIALOG,
+    ASSERT_POLICY_LOG_AND_CONTINUE,
+    ASSERT_POLICY_LOG_AND_ABORT,
+    ASSERT_POLICY_COUNT_ONLY
+};
+
+//
+// Every assert owns one of these as a function-local static. It is constant
+// initialized, so it costs nothing until the assert fails, and it counts how often
+// the assert has failed.
+//
+struct AssertSite
+{
+    const char*                file;
+    int                        line;
+    const char*                expression;
+    std::atomic<std::uint64_t> failureCount;
+    AssertSite*                next;
+};
+
+void setAssertPolicy(AssertPolicy policy);
+AssertPolicy assertPolicy();
+
+//
+// Logs every assert that has failed so far and how often. Called at exit once
+// ASSERT_POLICY_COUNT_ONLY has been set.
+//
+void printAssertFailures();
+
+//
+// Kept out of line and marked cold, so that an assert costs its callers a compare and
+// a rarely taken branch, and the failure handling doesn't take up space in hot code.
+//
+__attribute__((noinline, cold)) void assertFailed(AssertSite& site, const char* modalDialogTitle);
+
+}
+
+#define MOJO_LIKELY(expression)   __builtin_expect(!!(expression), 1)
+#define MOJO_UNLIKELY(expression) __builtin_expect(!!(expression), 0)
+
+#define MOJO_ASSERT_HELPER(expression, modalDialogTitle)                                                 \
+    do                                                                                                   \
+    {                                                                                                    \
+        if (MOJO_UNLIKELY(!(expression)))                                                                \
+        {                                                                                                \
+            static mojo::AssertSite assertSite = { __FILE__, __LINE__, #expression, { 0 }, NULL };       \
+            mojo::assertFailed(assertSite, modalDialogTitle);                                            \
+        }                                                                                                \
+    } while (0)                                                                                          \
 
 #define MOJO_RELEASE_ASSERT(expression) MOJO_ASSERT_HELPER(expression, "MOJO_RELEASE_ASSERT")
 
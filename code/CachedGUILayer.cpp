@@ -0,0 +1,117 @@
+#include "CachedGUILayer.hpp"
+
+namespace mojo
+{
+
+const double CachedGUILayer::kRefreshSeconds = 0.25;
+
+CachedGUILayer::CachedGUILayer() :
+    m_dirty         (true),
+    m_hovering      (false),
+    m_lastRenderTime(0.0),
+    m_renderCount   (0),
+    m_compositeCount(0) {
+}
+
+void CachedGUILayer::invalidate() {
+    m_dirty = true;
+}
+
+void CachedGUILayer::onEvent(const G3D::GEvent& event) {
+    switch (event.type) {
+    case G3D::GEventType::MOUSE_MOTION:
+    {
+        //
+        // Controls highlight while hovered, so we re-render while the mouse is over a
+        // 2D surface, and once more when it leaves, to remove the highlight.
+        //
+        bool hovered = hovering(G3D::Point2(event.motion.x, event.motion.y));
+        if (hovered || m_hovering) {
+            m_dirty = true;
+        }
+
+        m_hovering = hovered;
+        break;
+    }
+
+    case G3D::GEventType::FOCUS:
+    case G3D::GEventType::JOYSTICK_AXIS_MOTION:
+    case G3D::GEventType::JOYSTICK_HAT_MOTION:
+    case G3D::GEventType::JOYSTICK_BUTTON_DOWN:
+    case G3D::GEventType::JOYSTICK_BUTTON_UP:
+        break;
+
+    default:
+        m_dirty = true;
+        break;
+    }
+}
+
+void CachedGUILayer::render(G3D::RenderDevice* rd, G3D::Array<G3D::shared_ptr<G3D::Surface2D> >& posed2D) {
+    using namespace G3D;
+
+    if (posed2D.size() == 0) {
+        m_bounds.fastClear();
+        return;
+    }
+
+    int width  = (int)rd->viewport().width();
+    int height = (int)rd->viewport().height();
+
+    if (isNull(m_framebuffer) || (m_framebuffer->width() != width) || (m_framebuffer->height() != height)) {
+        m_framebuffer = Framebuffer::create(Texture::createEmpty("mojo::CachedGUILayer", width, height, ImageFormat::RGBA8(), Texture::DIM_2D, false));
+        m_dirty       = true;
+    }
+
+    if (posed2D.size() != m_bounds.size()) {
+        m_dirty = true;
+    }
+
+    if (m_dirty || (System::time() - m_lastRenderTime >= kRefreshSeconds)) {
+        m_bounds.fastClear();
+        for (int i = 0; i < posed2D.size(); ++i) {
+            m_bounds.append(posed2D[i]->bounds());
+        }
+
+        rd->push2D(m_framebuffer); {
+            rd->setColorClearValue(Color4::clear());
+            rd->clear(true, false, false);
+            Surface2D::sortAndRender(rd, posed2D);
+        } rd->pop2D();
+
+        m_dirty          = false;
+        m_lastRenderTime = System::time();
+        ++m_renderCount;
+    }
+
+    rd->push2D(); {
+        rd->setBlendFunc(RenderDevice::BLEND_ONE, RenderDevice::BLEND_ONE_MINUS_SRC_ALPHA);
+
+        Args args;
+        args.setRect(rd->viewport());
+        args.setUniform("guiTexture", m_framebuffer->texture(0), Sampler::buffer());
+        LAUNCH_SHADER("compositeGUI.pix", args);
+    } rd->pop2D();
+
+    ++m_compositeCount;
+}
+
+std::uint64_t CachedGUILayer::renderCount() const {
+    return m_renderCount;
+}
+
+std::uint64_t CachedGUILayer::compositeCount() const {
+    return m_compositeCount;
+}
+
+bool CachedGUILayer::hovering(const G3D::Point2& position) const {
+    for (int i = 0; i < m_bounds.size(); ++i) {
+        if (m_bounds[i].contains(position)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
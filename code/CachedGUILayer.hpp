@@ -0,0 +1,58 @@
+#ifndef CACHED_GUI_LAYER_HPP
+#define CACHED_GUI_LAYER_HPP
+
+#include <cstdint>
+
+#include <G3D/G3D.h>
+#include <GLG3D/GLG3D.h>
+
+namespace mojo
+{
+
+//
+// CachedGUILayer renders the 2D surfaces of a GLG3D::GApp, e.g., the developer HUD
+// and other GUI windows, into a texture, and composites that texture over the frame
+// with a single quad. The texture is only re-rendered when the GUI may look different:
+//
+//   - after a GUI, key or mouse button event
+//   - while the mouse hovers over a 2D surface, and once when it leaves
+//   - when the viewport is resized, or 2D surfaces are added or removed
+//   - every kRefreshSeconds, for controls that show live values, e.g., the camera
+//
+// GUI controls blend onto the transparent texture with the usual alpha blending, which
+// leaves their colors premultiplied and their alpha squared. compositeGUI.pix undoes
+// the square, which is exact for a single layer of translucency.
+//
+class CachedGUILayer
+{
+public:
+    static const double kRefreshSeconds;
+
+    CachedGUILayer();
+
+    void invalidate();
+    void onEvent(const G3D::GEvent& event);
+
+    //
+    // Replaces G3D::Surface2D::sortAndRender(rd, posed2D) in onGraphics2D(...).
+    //
+    void render(G3D::RenderDevice* rd, G3D::Array<G3D::shared_ptr<G3D::Surface2D> >& posed2D);
+
+    std::uint64_t renderCount() const;
+    std::uint64_t compositeCount() const;
+
+private:
+    bool hovering(const G3D::Point2& position) const;
+
+    G3D::shared_ptr<G3D::Framebuffer> m_framebuffer;
+    G3D::Array<G3D::Rect2D>           m_bounds;
+    bool                              m_dirty;
+    bool                              m_hovering;
+    G3D::RealTime                     m_lastRenderTime;
+    std::uint64_t                     m_renderCount;
+    std::uint64_t                     m_compositeCount;
+};
+
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "ContentHash.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mojo
+{
+
+static const std::uint64_t kContentHashPrime = 0x100000001b3ULL;
+static const std::size_t   kChunkSize        = 16 * 1024 * 1024;
+static const unsigned int  kMaxThreads       = 8;
+
+std::uint64_t hashBytes(std::uint64_t hash, const void* data, std::size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * kContentHashPrime;
+    }
+
+    return hash;
+}
+
+std::uint64_t hashString(std::uint64_t hash, const std::string& value) {
+    return hashBytes(hash, value.data(), value.size());
+}
+
+bool hashFile(const std::string& path, std::uint64_t& hash) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return false;
+    }
+
+    std::size_t size = (std::size_t)status.st_size;
+    if (size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    madvise(mapping, size, MADV_WILLNEED);
+
+    //
+    // Each chunk is hashed on its own, and the chunk hashes are hashed in order, so the
+    // result depends on the contents and the chunk size, but not on the thread count.
+    //
+    const unsigned char*       bytes      = (const unsigned char*)mapping;
+    std::size_t                chunkCount = (size + kChunkSize - 1) / kChunkSize;
+    std::vector<std::uint64_t> chunkHashes(chunkCount);
+
+    unsigned int threadCount = std::min<std::size_t>(chunkCount, std::max(1u, std::min(std::thread::hardware_concurrency(), kMaxThreads)));
+
+    auto hashChunks = [&](unsigned int first) {
+        for (std::size_t chunk = first; chunk < chunkCount; chunk += threadCount) {
+            std::size_t offset = chunk * kChunkSize;
+            chunkHashes[chunk] = hashBytes(kContentHashSeed, bytes + offset, std::min(kChunkSize, size - offset));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        threads.push_back(std::thread(hashChunks, i));
+    }
+
+    hashChunks(0);
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    munmap(mapping, size);
+
+    hash = hashBytes(hash, &chunkHashes[0], chunkCount * sizeof(std::uint64_t));
+    return true;
+}
+
+}
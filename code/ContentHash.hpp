@@ -0,0 +1,30 @@
+#ifndef CONTENT_HASH_HPP
+#define CONTENT_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mojo
+{
+
+//
+// 64-bit FNV-1a hashes that name the entries of the TextureCache and the MeshCache.
+// They are stable across runs and platforms, and plenty to tell edited files apart,
+// but they are not cryptographic.
+//
+static const std::uint64_t kContentHashSeed = 0xcbf29ce484222325ULL;
+
+std::uint64_t hashBytes(std::uint64_t hash, const void* data, std::size_t size);
+std::uint64_t hashString(std::uint64_t hash, const std::string& value);
+
+//
+// Hashes the contents of the file into hash, and returns false if it cannot be read.
+// Large files are mapped and hashed in chunks on several threads, so hashing a model
+// export of hundreds of megabytes doesn't add much to loading it from a cache.
+//
+bool hashFile(const std::string& path, std::uint64_t& hash);
+
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "DynamicResolutionController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+DynamicResolutionController::Settings::Settings() :
+    enabled            (false),
+    targetMilliseconds (1000.0f / 60.0f),
+    minScale           (0.5f),
+    maxScale           (1.0f),
+    scaleStep          (0.125f),
+    increaseThreshold  (0.75f),
+    framesPerAdjustment(30),
+    settleFrames       (8) {
+}
+
+DynamicResolutionController::DynamicResolutionController(const Settings& settings) :
+    m_scale             (1.0f),
+    m_windowMilliseconds(0.0f),
+    m_windowFrames      (0),
+    m_settleFrames      (0) {
+
+    setSettings(settings);
+}
+
+void DynamicResolutionController::setSettings(const Settings& settings) {
+    MOJO_RELEASE_ASSERT(settings.minScale            >  0.0f);
+    MOJO_RELEASE_ASSERT(settings.minScale            <= settings.maxScale);
+    MOJO_RELEASE_ASSERT(settings.scaleStep           >  0.0f);
+    MOJO_RELEASE_ASSERT(settings.targetMilliseconds  >  0.0f);
+    MOJO_RELEASE_ASSERT(settings.framesPerAdjustment >  0);
+    MOJO_RELEASE_ASSERT(settings.settleFrames        >= 0);
+
+    m_settings           = settings;
+    m_scale              = settings.enabled ? quantize(m_scale) : settings.maxScale;
+    m_windowMilliseconds = 0.0f;
+    m_windowFrames       = 0;
+    m_settleFrames       = settings.settleFrames;
+}
+
+const DynamicResolutionController::Settings& DynamicResolutionController::settings() const {
+    return m_settings;
+}
+
+void DynamicResolutionController::addFrame(float gpuMilliseconds, float cpuMilliseconds) {
+    if (!m_settings.enabled) {
+        return;
+    }
+
+    if (m_settleFrames > 0) {
+        --m_settleFrames;
+        return;
+    }
+
+    m_windowMilliseconds += std::max(gpuMilliseconds, cpuMilliseconds);
+    ++m_windowFrames;
+
+    if (m_windowFrames < m_settings.framesPerAdjustment) {
+        return;
+    }
+
+    float frameMilliseconds = m_windowMilliseconds / m_windowFrames;
+    m_windowMilliseconds    = 0.0f;
+    m_windowFrames          = 0;
+
+    float previousScale = m_scale;
+
+    if (frameMilliseconds > m_settings.targetMilliseconds) {
+
+        //
+        // Frame cost is roughly proportional to the number of pixels, i.e., to the
+        // square of the scale, so we jump straight to the scale we expect to fit the
+        // budget, and always drop by at least one step.
+        //
+        float fittedScale = m_scale * std::sqrt(m_settings.targetMilliseconds / frameMilliseconds);
+        m_scale = quantize(std::min(fittedScale, m_scale - m_settings.scaleStep));
+
+    } else if (frameMilliseconds < m_settings.targetMilliseconds * m_settings.increaseThreshold) {
+
+        //
+        // Grow one step at a time so we don't oscillate around the budget.
+        //
+        m_scale = quantize(m_scale + m_settings.scaleStep);
+    }
+
+    if (m_scale != previousScale) {
+        m_settleFrames = m_settings.settleFrames;
+    }
+}
+
+float DynamicResolutionController::scale() const {
+    return m_scale;
+}
+
+int DynamicResolutionController::scaledSize(int nativeSize) const {
+    return std::max(1, (int)std::floor(nativeSize * m_scale + 0.5f));
+}
+
+float DynamicResolutionController::quantize(float scale) const {
+    float quantized = std::floor(scale / m_settings.scaleStep + 0.5f) * m_settings.scaleStep;
+    return std::min(m_settings.maxScale, std::max(m_settings.minScale, quantized));
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef DYNAMIC_RESOLUTION_CONTROLLER_HPP
+#define DYNAMIC_RESOLUTION_CONTROLLER_HPP
+
+namespace mojo
+{
+
+//
+// DynamicResolutionController chooses an internal render scale that holds a
+// frame-time budget. It is fed the GPU and CPU time of each frame, and every
+// framesPerAdjustment frames it compares the slower of the two against the budget
+// and moves the scale within [minScale, maxScale]. The scale is quantized to
+// scaleStep and only changes once per adjustment window, so render targets sized
+// from it are reallocated at most that often, never every frame.
+//
+// The first settleFrames frames after a change are not counted. They still carry
+// GPU results measured at the previous scale, and the cost of reallocating the
+// render targets, so counting them would make the scale swing back and forth.
+//
+class DynamicResolutionController
+{
+public:
+    struct Settings
+    {
+        Settings();
+
+        bool  enabled;
+        float targetMilliseconds;
+        float minScale;
+        float maxScale;
+        float scaleStep;
+        float increaseThreshold;
+        int   framesPerAdjustment;
+        int   settleFrames;
+    };
+
+    DynamicResolutionController(const Settings& settings = Settings());
+
+    void setSettings(const Settings& settings);
+    const Settings& settings() const;
+
+    void addFrame(float gpuMilliseconds, float cpuMilliseconds);
+
+    float scale() const;
+    int scaledSize(int nativeSize) const;
+
+private:
+    float quantize(float scale) const;
+
+    Settings m_settings;
+    float    m_scale;
+    float    m_windowMilliseconds;
+    int      m_windowFrames;
+    int      m_settleFrames;
+};
+
+}
+
+#endif
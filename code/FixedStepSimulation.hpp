@@ -0,0 +1,235 @@
+#ifndef FIXED_STEP_SIMULATION_HPP
+#define FIXED_STEP_SIMULATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+//
+// FixedStepSimulation advances a State at a fixed time step on a worker thread,
+// independently of the render loop. After every step it publishes the two most
+// recent states, so the render thread can interpolate between them. Publishing
+// uses a lock-free triple buffer: the worker never waits for the render thread
+// and vice versa, so a slow frame cannot perturb the simulation (which depends
+// only on the number of steps taken) and a slow step cannot stall a frame.
+//
+// The step function runs on the worker thread and must only touch the State it
+// is given.
+//
+// If the worker falls behind the wall clock, e.g., because a step takes longer than
+// the time step, it takes at most kMaxCatchUpSteps steps in a row and then drops the
+// time it cannot catch up on, rather than falling further behind with every step.
+//
+template <typename State>
+class FixedStepSimulation
+{
+public:
+    typedef std::function<void (State& state, double time, double timeStep)> StepFunction;
+
+    static const int kMaxCatchUpSteps = 8;
+
+    FixedStepSimulation(const State& initialState, double timeStep, StepFunction step);
+    ~FixedStepSimulation();
+
+    void start();
+    void stop();
+
+    bool running() const;
+    double timeStep() const;
+    std::uint64_t stepCount() const;
+
+    //
+    // Called from the render thread. Copies the two most recently published states
+    // into previous and current, and returns in alpha how far the render clock is
+    // between them. We render one time step behind the simulation so that there is
+    // always a pair of states to interpolate between. Returns false until the first
+    // step has been published.
+    //
+    bool sample(State& previous, State& current, float& alpha);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Snapshot
+    {
+        State         previous;
+        State         current;
+        std::uint64_t step;
+    };
+
+    static const int kDirty = 4;
+
+    void run();
+    Clock::time_point startTime() const;
+
+    Snapshot                   m_snapshots[3];
+    std::atomic<int>           m_middle;
+    int                        m_back;
+    int                        m_front;
+    bool                       m_published;
+
+    State                      m_state;
+    double                     m_timeStep;
+    StepFunction               m_step;
+    std::atomic<std::uint64_t> m_stepCount;
+    std::atomic<bool>          m_running;
+    std::thread                m_thread;
+
+    //
+    // The wall-clock time of step 0, in Clock ticks. The worker moves it forward when
+    // it drops time, and sample(...) reads it, so it is atomic.
+    //
+    std::atomic<Clock::rep>    m_startTime;
+};
+
+template <typename State>
+inline FixedStepSimulation<State>::FixedStepSimulation(const State& initialState, double timeStep, StepFunction step) :
+    m_middle   (1),
+    m_back     (0),
+    m_front    (2),
+    m_published(false),
+    m_state    (initialState),
+    m_timeStep (timeStep),
+    m_step     (step),
+    m_stepCount(0),
+    m_running  (false),
+    m_startTime(0)
+{
+    MOJO_RELEASE_ASSERT(timeStep > 0.0);
+    MOJO_RELEASE_ASSERT(step);
+
+    for (int i = 0; i < 3; ++i) {
+        m_snapshots[i].previous = initialState;
+        m_snapshots[i].current  = initialState;
+        m_snapshots[i].step     = 0;
+    }
+}
+
+template <typename State>
+inline FixedStepSimulation<State>::~FixedStepSimulation()
+{
+    stop();
+}
+
+template <typename State>
+inline void FixedStepSimulation<State>::start()
+{
+    MOJO_RELEASE_ASSERT(!m_running);
+
+    m_running   = true;
+    m_startTime = Clock::now().time_since_epoch().count();
+    m_thread    = std::thread(&FixedStepSimulation<State>::run, this);
+}
+
+template <typename State>
+inline void FixedStepSimulation<State>::stop()
+{
+    if (m_running) {
+        m_running = false;
+        m_thread.join();
+    }
+}
+
+template <typename State>
+inline bool FixedStepSimulation<State>::running() const
+{
+    return m_running;
+}
+
+template <typename State>
+inline double FixedStepSimulation<State>::timeStep() const
+{
+    return m_timeStep;
+}
+
+template <typename State>
+inline std::uint64_t FixedStepSimulation<State>::stepCount() const
+{
+    return m_stepCount.load(std::memory_order_acquire);
+}
+
+template <typename State>
+inline void FixedStepSimulation<State>::run()
+{
+    int catchUpSteps = 0;
+
+    while (m_running) {
+        std::uint64_t step = m_stepCount.load(std::memory_order_relaxed);
+
+        //
+        // Catch up with the wall clock one fixed step at a time, publishing after
+        // each step. If we fall behind, we keep stepping rather than enlarging the
+        // time step, so the result never depends on how the steps were scheduled.
+        //
+        Clock::time_point now          = Clock::now();
+        Clock::time_point nextStepTime = startTime() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((step + 1) * m_timeStep));
+        if (now < nextStepTime) {
+            catchUpSteps = 0;
+            std::this_thread::sleep_until(nextStepTime);
+            continue;
+        }
+
+        //
+        // Still behind after kMaxCatchUpSteps steps, so we move the start time forward
+        // until the next step is due a time step from now. The simulation time of each
+        // step stays step * m_timeStep, only the wall clock it follows shifts.
+        //
+        if (catchUpSteps == kMaxCatchUpSteps) {
+            catchUpSteps = 0;
+            m_startTime.store((now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(step * m_timeStep))).time_since_epoch().count(),
+                              std::memory_order_release);
+            continue;
+        }
+
+        Snapshot& snapshot = m_snapshots[m_back];
+        snapshot.previous  = m_state;
+        m_step(m_state, step * m_timeStep, m_timeStep);
+        snapshot.current   = m_state;
+        snapshot.step      = step + 1;
+
+        m_back = m_middle.exchange(m_back | kDirty, std::memory_order_acq_rel) & ~kDirty;
+        m_stepCount.store(step + 1, std::memory_order_release);
+        ++catchUpSteps;
+    }
+}
+
+template <typename State>
+inline typename FixedStepSimulation<State>::Clock::time_point FixedStepSimulation<State>::startTime() const
+{
+    return Clock::time_point(Clock::duration(m_startTime.load(std::memory_order_acquire)));
+}
+
+template <typename State>
+inline bool FixedStepSimulation<State>::sample(State& previous, State& current, float& alpha)
+{
+    if (m_middle.load(std::memory_order_acquire) & kDirty) {
+        m_front     = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~kDirty;
+        m_published = true;
+    }
+
+    if (!m_published) {
+        return false;
+    }
+
+    const Snapshot& snapshot = m_snapshots[m_front];
+    previous = snapshot.previous;
+    current  = snapshot.current;
+
+    double renderTime  = std::chrono::duration<double>(Clock::now() - startTime()).count() - m_timeStep;
+    double currentTime = snapshot.step * m_timeStep;
+    double t           = (renderTime - (currentTime - m_timeStep)) / m_timeStep;
+
+    alpha = (float)(t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t));
+    return true;
+}
+
+}
+
+#endif
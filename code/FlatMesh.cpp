@@ -0,0 +1,298 @@
+#include "FlatMesh.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#include "Printf.hpp"
+
+namespace mojo
+{
+
+namespace
+{
+
+//
+// An OBJ face corner refers to a position, a normal and a texture coordinate each by
+// index. Corners that agree on all three become the same vertex.
+//
+struct VertexKey
+{
+    int position;
+    int normal;
+    int texCoord;
+
+    bool operator==(const VertexKey& other) const {
+        return position == other.position && normal == other.normal && texCoord == other.texCoord;
+    }
+};
+
+struct VertexKeyHash
+{
+    std::size_t operator()(const VertexKey& key) const {
+        return ((std::size_t)key.position * 73856093u) ^ ((std::size_t)key.normal * 19349663u) ^ ((std::size_t)key.texCoord * 83492791u);
+    }
+};
+
+// the .mtl files of a model, by the names the OBJ file gives them, in the order it does
+typedef std::vector<std::pair<G3D::String, std::shared_ptr<G3D::ParseMTL> > > MaterialLibraries;
+
+G3D::Vector3 anyPerpendicular(const G3D::Vector3& v) {
+    return v.cross(std::fabs(v.x) < 0.9f ? G3D::Vector3::unitX() : G3D::Vector3::unitY()).directionOrZero();
+}
+
+//
+// G3D::ParseOBJ doesn't tell which file a material came from, so we find the mtllib
+// lines ourselves. Each names one or more .mtl files.
+//
+std::vector<G3D::String> materialLibraryNames(const char* data, std::size_t size) {
+    std::vector<G3D::String> names;
+
+    const char* end = data + size;
+    for (const char* line = data; line < end;) {
+        const char* lineEnd = (const char*)std::memchr(line, '\n', end - line);
+        if (lineEnd == NULL) {
+            lineEnd = end;
+        }
+
+        while (line < lineEnd && (*line == ' ' || *line == '\t')) {
+            ++line;
+        }
+
+        if (lineEnd - line > 7 && std::strncmp(line, "mtllib", 6) == 0 && (line[6] == ' ' || line[6] == '\t')) {
+            std::istringstream stream(std::string(line + 7, lineEnd));
+            std::string        name;
+
+            while (stream >> name) {
+                names.push_back(name.c_str());
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+
+    return names;
+}
+
+MaterialLibraries parseMaterialLibraries(const G3D::String& basePath, const std::vector<G3D::String>& names) {
+    MaterialLibraries libraries;
+
+    for (const G3D::String& name : names) {
+        G3D::String filename = G3D::FilePath::concat(basePath, name);
+
+        try {
+            G3D::TextInput                 textInput(filename);
+            std::shared_ptr<G3D::ParseMTL> library = std::make_shared<G3D::ParseMTL>();
+            library->parse(textInput, basePath);
+
+            libraries.push_back(std::make_pair(name, library));
+        } catch (...) {
+            mojo::printf("Cannot parse ", filename.c_str(), ", using default materials instead");
+        }
+    }
+
+    return libraries;
+}
+
+// like G3D::ParseOBJ, a material defined by a later file replaces one of the same name
+void setMaterials(const MaterialLibraries& libraries, std::vector<FlatMesh>& meshes) {
+    for (FlatMesh& mesh : meshes) {
+        mesh.material.reset();
+
+        for (MaterialLibraries::const_reverse_iterator library = libraries.rbegin(); library != libraries.rend(); ++library) {
+            if (library->first == mesh.materialLibrary) {
+                library->second->materialTable.get(mesh.materialName, mesh.material);
+                break;
+            }
+        }
+    }
+}
+
+}
+
+bool parseOBJ(const char* data, std::size_t size, const std::string& path, std::vector<FlatMesh>& meshes, std::string& error, const std::function<bool (float)>& progress) {
+    G3D::String   basePath = G3D::FilePath::parent(path.c_str());
+    G3D::ParseOBJ parser;
+
+    // G3D::ParseOBJ takes the size as an int, and would parse only part of a larger file
+    if (size > INT_MAX) {
+        error = "Model is too large";
+        return false;
+    }
+
+    try {
+        parser.parse(data, (int)size, basePath);
+    } catch (...) {
+        error = "Cannot parse model";
+        return false;
+    }
+
+    if (!progress(0.5f)) {
+        return false;
+    }
+
+    MaterialLibraries libraries = parseMaterialLibraries(basePath, materialLibraryNames(data, size));
+
+    auto materialLibrary = [&libraries](const G3D::String& materialName) -> G3D::String {
+        for (MaterialLibraries::const_reverse_iterator library = libraries.rbegin(); library != libraries.rend(); ++library) {
+            if (library->second->materialTable.containsKey(materialName)) {
+                return library->first;
+            }
+        }
+
+        return G3D::String();
+    };
+
+    int numGroups = parser.groupTable.size();
+    int group     = 0;
+
+    for (auto groupEntry = parser.groupTable.begin(); groupEntry != parser.groupTable.end(); ++groupEntry, ++group) {
+        const G3D::ParseOBJ::Group& objGroup = *groupEntry->value;
+
+        for (auto meshEntry = objGroup.meshTable.begin(); meshEntry != objGroup.meshTable.end(); ++meshEntry) {
+            if (!progress(0.5f + 0.5f * group / numGroups)) {
+                return false;
+            }
+
+            const G3D::ParseOBJ::Mesh& objMesh = *meshEntry->value;
+
+            FlatMesh flat;
+            flat.name            = groupEntry->key;
+            flat.materialName    = objMesh.material ? objMesh.material->name : G3D::String();
+            flat.materialLibrary = materialLibrary(flat.materialName);
+            flat.hasTexCoord0    = false;
+
+            std::unordered_map<VertexKey, int, VertexKeyHash> vertexIndices;
+            std::vector<bool>                                 computeNormal;
+
+            auto vertexIndex = [&](const G3D::ParseOBJ::Index& index) -> int {
+                VertexKey key = { index.vertex, index.normal, index.texCoord };
+
+                std::unordered_map<VertexKey, int, VertexKeyHash>::const_iterator found = vertexIndices.find(key);
+                if (found != vertexIndices.end()) {
+                    return found->second;
+                }
+
+                G3D::CPUVertexArray::Vertex vertex;
+                vertex.position  = parser.vertexArray[index.vertex];
+                vertex.normal    = (index.normal   >= 0) ? parser.normalArray[index.normal]      : G3D::Vector3::zero();
+                vertex.tangent   = G3D::Vector4(0.0f, 0.0f, 0.0f, 0.0f);
+                vertex.texCoord0 = (index.texCoord >= 0) ? parser.texCoord0Array[index.texCoord] : G3D::Point2(0.0f, 0.0f);
+
+                flat.hasTexCoord0 |= index.texCoord >= 0;
+
+                int added = (int)flat.vertices.size();
+                flat.vertices.push_back(vertex);
+                computeNormal.push_back(index.normal < 0);
+                vertexIndices[key] = added;
+                return added;
+            };
+
+            // faces are convex polygons, which we split into fans of triangles
+            for (int f = 0; f < objMesh.faceArray.size(); ++f) {
+                const G3D::ParseOBJ::Face& face = objMesh.faceArray[f];
+                if (face.size() < 3) {
+                    continue;
+                }
+
+                int first    = vertexIndex(face[0]);
+                int previous = vertexIndex(face[1]);
+                for (int corner = 2; corner < face.size(); ++corner) {
+                    int current = vertexIndex(face[corner]);
+                    flat.indices.push_back(first);
+                    flat.indices.push_back(previous);
+                    flat.indices.push_back(current);
+                    previous = current;
+                }
+            }
+
+            if (flat.indices.empty()) {
+                continue;
+            }
+
+            //
+            // Area-weighted face normals for the vertices the file gave none, and
+            // tangents along the texture's u axis, with the handedness of v in w, so
+            // that G3D::ArticulatedModel::cleanGeometry(...) has nothing left to compute.
+            //
+            std::vector<G3D::Vector3> tangents(flat.vertices.size(), G3D::Vector3::zero());
+            std::vector<G3D::Vector3> bitangents(flat.vertices.size(), G3D::Vector3::zero());
+
+            for (std::size_t i = 0; i < flat.indices.size(); i += 3) {
+                const G3D::CPUVertexArray::Vertex& a = flat.vertices[flat.indices[i]];
+                const G3D::CPUVertexArray::Vertex& b = flat.vertices[flat.indices[i + 1]];
+                const G3D::CPUVertexArray::Vertex& c = flat.vertices[flat.indices[i + 2]];
+
+                G3D::Vector3 edge1      = b.position - a.position;
+                G3D::Vector3 edge2      = c.position - a.position;
+                G3D::Vector3 faceNormal = edge1.cross(edge2);
+
+                for (int corner = 0; corner < 3; ++corner) {
+                    int v = flat.indices[i + corner];
+                    if (computeNormal[v]) {
+                        flat.vertices[v].normal += faceNormal;
+                    }
+                }
+
+                G3D::Vector2 st1         = b.texCoord0 - a.texCoord0;
+                G3D::Vector2 st2         = c.texCoord0 - a.texCoord0;
+                float        determinant = st1.x * st2.y - st2.x * st1.y;
+                if (std::fabs(determinant) < 1e-12f) {
+                    continue;
+                }
+
+                G3D::Vector3 tangent   = (edge1 * st2.y - edge2 * st1.y) / determinant;
+                G3D::Vector3 bitangent = (edge2 * st1.x - edge1 * st2.x) / determinant;
+                for (int corner = 0; corner < 3; ++corner) {
+                    tangents[flat.indices[i + corner]]   += tangent;
+                    bitangents[flat.indices[i + corner]] += bitangent;
+                }
+            }
+
+            for (std::size_t v = 0; v < flat.vertices.size(); ++v) {
+                G3D::CPUVertexArray::Vertex& vertex = flat.vertices[v];
+                vertex.normal = vertex.normal.directionOrZero();
+
+                G3D::Vector3 tangent = (tangents[v] - vertex.normal * vertex.normal.dot(tangents[v])).directionOrZero();
+                if (tangent.isZero()) {
+                    tangent = anyPerpendicular(vertex.normal);
+                }
+
+                float handedness = (vertex.normal.cross(tangent).dot(bitangents[v]) < 0.0f) ? -1.0f : 1.0f;
+                vertex.tangent   = G3D::Vector4(tangent, handedness);
+            }
+
+            meshes.push_back(std::move(flat));
+        }
+    }
+
+    if (meshes.empty()) {
+        error = "Model has no faces";
+        return false;
+    }
+
+    //
+    // The materials come from the libraries as loadMaterials(...) finds them, rather
+    // than from the parser, so a model is the same whether it was cached or not.
+    //
+    setMaterials(libraries, meshes);
+    return true;
+}
+
+void loadMaterials(const std::string& path, std::vector<FlatMesh>& meshes) {
+    std::vector<G3D::String> names;
+
+    for (const FlatMesh& mesh : meshes) {
+        if (!mesh.materialLibrary.empty() && std::find(names.begin(), names.end(), mesh.materialLibrary) == names.end()) {
+            names.push_back(mesh.materialLibrary);
+        }
+    }
+
+    setMaterials(parseMaterialLibraries(G3D::FilePath::parent(path.c_str()), names), meshes);
+}
+
+}
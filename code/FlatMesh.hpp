@@ -0,0 +1,52 @@
+#ifndef FLAT_MESH_HPP
+#define FLAT_MESH_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <G3D/G3D.h>
+#include <GLG3D/GLG3D.h>
+
+namespace mojo
+{
+
+//
+// A mesh of an OBJ model, triangulated, with the corners of its faces merged into
+// vertices and their normals and tangents computed, so that G3D only has to upload
+// it. Its material is referred to by the .mtl file that defines it, as named in the
+// OBJ file, and its name in there, which is all the MeshCache stores; material is
+// the parsed material, or null if there is none.
+//
+struct FlatMesh
+{
+    G3D::String                              name;
+    G3D::String                              materialLibrary;
+    G3D::String                              materialName;
+    std::shared_ptr<G3D::ParseMTL::Material> material;
+    bool                                     hasTexCoord0;
+    std::vector<G3D::CPUVertexArray::Vertex> vertices;
+    std::vector<int>                         indices;
+};
+
+//
+// Parses OBJ text with G3D::ParseOBJ into meshes, with their materials. path is the
+// OBJ file's, which the .mtl files are found relative to. progress(...) is called
+// with the fraction done before each mesh; if it returns false, parsing stops.
+// Returns false if parsing stopped, or with error set if the text cannot be parsed,
+// is larger than INT_MAX bytes, or has no faces. Doesn't need the OpenGL context.
+//
+bool parseOBJ(const char* data, std::size_t size, const std::string& path, std::vector<FlatMesh>& meshes, std::string& error, const std::function<bool (float)>& progress);
+
+//
+// Sets the material of each mesh from its materialLibrary and materialName, e.g.,
+// after the MeshCache loaded them, parsing each .mtl file once, so that edits to the
+// .mtl files show even though the meshes were cached. path is the OBJ file's.
+//
+void loadMaterials(const std::string& path, std::vector<FlatMesh>& meshes);
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+std::shared_ptr<FrameArena> FrameArena::s_current;
+
+std::shared_ptr<FrameArena> FrameArena::create(std::size_t blockSize) {
+    return std::shared_ptr<FrameArena>(new FrameArena(blockSize));
+}
+
+FrameArena::FrameArena(std::size_t blockSize) :
+    m_blockSize         (blockSize),
+    m_currentBlock      (0),
+    m_offset            (0),
+    m_bytesAllocated    (0),
+    m_peakBytesAllocated(0),
+    m_heapAllocations   (0) {
+
+    MOJO_RELEASE_ASSERT(blockSize >= kAlignment);
+}
+
+FrameArena::~FrameArena() {
+    for (const Block& block : m_blocks) {
+        std::free(block.data);
+    }
+}
+
+void* FrameArena::alloc(std::size_t size) {
+    size = (std::max<std::size_t>(size, 1) + kAlignment - 1) & ~(kAlignment - 1);
+
+    //
+    // Bump the offset within the current block, and move on to the next block when it
+    // is full. The blocks are kept across resets, so we only go to the heap when the
+    // frame needs more than all blocks together, or one larger allocation.
+    //
+    while (m_currentBlock < m_blocks.size()) {
+        Block& block = m_blocks[m_currentBlock];
+
+        if (m_offset + size <= block.size) {
+            void* p           = block.data + m_offset;
+            m_offset         += size;
+            m_bytesAllocated += size;
+            return p;
+        }
+
+        ++m_currentBlock;
+        m_offset = 0;
+    }
+
+    Block block;
+    block.size = std::max(m_blockSize, size);
+    block.data = (unsigned char*)std::malloc(block.size);
+
+    if (block.data == NULL) {
+        throw std::bad_alloc();
+    }
+
+    ++m_heapAllocations;
+    m_blocks.push_back(block);
+
+    m_offset          = size;
+    m_bytesAllocated += size;
+    return block.data;
+}
+
+void FrameArena::free(void*) {
+}
+
+bool FrameArena::isThreadsafe() const {
+    return false;
+}
+
+void FrameArena::reset() {
+    m_peakBytesAllocated = std::max(m_peakBytesAllocated, m_bytesAllocated);
+
+    //
+    // If the frame spilled over into several blocks, we replace them with a single one
+    // that is large enough for all of it, so the next frames bump through one block.
+    //
+    if (m_blocks.size() > 1) {
+        std::size_t size = 0;
+        for (const Block& block : m_blocks) {
+            size += block.size;
+            std::free(block.data);
+        }
+
+        Block block;
+        block.size = size;
+        block.data = (unsigned char*)std::malloc(block.size);
+
+        if (block.data == NULL) {
+            throw std::bad_alloc();
+        }
+
+        ++m_heapAllocations;
+        m_blocks.assign(1, block);
+    }
+
+    m_currentBlock   = 0;
+    m_offset         = 0;
+    m_bytesAllocated = 0;
+}
+
+std::size_t FrameArena::bytesAllocated() const {
+    return m_bytesAllocated;
+}
+
+std::size_t FrameArena::peakBytesAllocated() const {
+    return std::max(m_peakBytesAllocated, m_bytesAllocated);
+}
+
+std::size_t FrameArena::capacity() const {
+    std::size_t size = 0;
+    for (const Block& block : m_blocks) {
+        size += block.size;
+    }
+    return size;
+}
+
+std::uint64_t FrameArena::heapAllocations() const {
+    return m_heapAllocations;
+}
+
+FrameArena* FrameArena::current() {
+    return s_current.get();
+}
+
+void FrameArena::setCurrent(const std::shared_ptr<FrameArena>& frameArena) {
+    s_current = frameArena;
+}
+
+std::shared_ptr<G3D::MemoryManager> FrameArena::memoryManager() {
+    if (s_current) {
+        return s_current;
+    }
+
+    return G3D::MemoryManager::create();
+}
+
+}
@@ -0,0 +1,84 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <G3D/MemoryManager.h>
+
+namespace mojo
+{
+
+//
+// FrameArena is a bump allocator for containers that only live for one frame, e.g.,
+// the surfaces a GLG3D::GApp poses for a single draw. It is a G3D::MemoryManager, so
+// a G3D::Array draws from it after
+//
+//     array.clearAndSetMemoryManager(mojo::FrameArena::memoryManager());
+//
+// free(...) does nothing; all memory is reclaimed at once by reset(), which G3DWidget
+// calls at the end of its update(). Memory comes from blocks that are kept across
+// resets, so once the blocks have grown to the size of a frame, a frame no longer
+// allocates from the heap at all. heapAllocations() counts the blocks allocated.
+//
+// Like FrameProfiler, the arena of the G3DWidget that is updating is current for the
+// duration of its update(). Without a current arena, memoryManager() returns G3D's
+// default memory manager, so code using it also runs outside a G3DWidget.
+//
+// Nothing allocated from the arena may outlive the frame, and the arena must only be
+// used from the thread of its G3DWidget. Arrays that outlive the frame, e.g., the
+// posed surface arrays of a GLG3D::GApp, which are members that are fastClear()ed
+// every frame, keep their capacity and don't allocate once they have grown, so they
+// don't come from the arena.
+//
+class FrameArena : public G3D::MemoryManager
+{
+public:
+    static const std::size_t kDefaultBlockSize = 256 * 1024;
+    static const std::size_t kAlignment        = 16;
+
+    static std::shared_ptr<FrameArena> create(std::size_t blockSize = kDefaultBlockSize);
+
+    virtual ~FrameArena();
+
+    virtual void* alloc(std::size_t size) override;
+    virtual void free(void* ptr) override;
+    virtual bool isThreadsafe() const override;
+
+    void reset();
+
+    std::size_t bytesAllocated() const;
+    std::size_t peakBytesAllocated() const;
+    std::size_t capacity() const;
+    std::uint64_t heapAllocations() const;
+
+    static FrameArena* current();
+    static void setCurrent(const std::shared_ptr<FrameArena>& frameArena);
+
+    static std::shared_ptr<G3D::MemoryManager> memoryManager();
+
+private:
+    struct Block
+    {
+        unsigned char* data;
+        std::size_t    size;
+    };
+
+    FrameArena(std::size_t blockSize);
+
+    std::size_t                        m_blockSize;
+    std::vector<Block>                 m_blocks;
+    std::size_t                        m_currentBlock;
+    std::size_t                        m_offset;
+    std::size_t                        m_bytesAllocated;
+    std::size_t                        m_peakBytesAllocated;
+    std::uint64_t                      m_heapAllocations;
+
+    static std::shared_ptr<FrameArena> s_current;
+};
+
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include "FrameLatencyLimiter.hpp"
+
+#include <chrono>
+
+#include <GLG3D/glheaders.h>
+#include <GLG3D/GApp.h>
+#include <GLG3D/GLCaps.h>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+FrameLatencyLimiter::FrameLatencyLimiter(int maxFramesInFlight) :
+    m_maxFramesInFlight   (maxFramesInFlight),
+    m_initialized         (false),
+    m_supported           (false),
+    m_frameCount          (0),
+    m_completedFrames     (0),
+    m_framesInFlight      (0),
+    m_lastWaitMilliseconds(0.0f) {
+
+    MOJO_RELEASE_ASSERT(maxFramesInFlight >= 1 && maxFramesInFlight <= kMaxFramesInFlightCap);
+}
+
+FrameLatencyLimiter::~FrameLatencyLimiter() {
+}
+
+void FrameLatencyLimiter::cleanup() {
+    for (const Fence& fence : m_fences) {
+        glDeleteSync((GLsync)fence.sync);
+    }
+
+    m_fences.clear();
+    m_framesInFlight = 0;
+    m_initialized    = false;
+    m_supported      = false;
+}
+
+void FrameLatencyLimiter::setMaxFramesInFlight(int maxFramesInFlight) {
+    MOJO_RELEASE_ASSERT(maxFramesInFlight >= 1 && maxFramesInFlight <= kMaxFramesInFlightCap);
+    m_maxFramesInFlight = maxFramesInFlight;
+}
+
+int FrameLatencyLimiter::maxFramesInFlight() const {
+    return m_maxFramesInFlight;
+}
+
+void FrameLatencyLimiter::waitForFrameSlot(IdleFunction idle, void* arg) {
+    typedef std::chrono::steady_clock Clock;
+
+    if (!m_initialized) {
+        m_initialized = true;
+        m_supported   = G3D::GLCaps::supports("GL_ARB_sync");
+    }
+
+    if (!m_supported) {
+        return;
+    }
+
+    retireCompletedFrames();
+
+    int framesInFlight = (int)m_fences.size();
+    m_framesInFlight   = framesInFlight;
+    m_queueDepthHistory.push((float)framesInFlight);
+
+    Clock::time_point begin = Clock::now();
+
+    //
+    // With an idle function, we wait in short slices and call it in between, so input
+    // that arrives while we wait is processed before the frame starts. Without one, we
+    // just block on the oldest fence. Fences signal in submission order, so the oldest
+    // one is always the next to retire.
+    //
+    while ((int)m_fences.size() >= m_maxFramesInFlight) {
+        GLuint64 timeout = kBlockingWaitNanoseconds;
+        if (idle != NULL) {
+            timeout = kIdleWaitNanoseconds;
+        }
+
+        GLenum result = glClientWaitSync((GLsync)m_fences.front().sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+
+        if (result == GL_TIMEOUT_EXPIRED) {
+            if (idle != NULL) {
+                idle(arg);
+            }
+        } else if (result == GL_WAIT_FAILED) {
+
+            // we give up on a fence we cannot wait for, rather than wait forever
+            retireFrontFence();
+        } else {
+            retireCompletedFrames();
+        }
+    }
+
+    float milliseconds     = std::chrono::duration<float, std::milli>(Clock::now() - begin).count();
+    m_lastWaitMilliseconds = milliseconds;
+    m_waitHistory.push(milliseconds);
+}
+
+std::uint64_t FrameLatencyLimiter::endFrame() {
+    ++m_frameCount;
+
+    if (!m_supported) {
+        m_completedFrames = m_frameCount;
+        return m_frameCount;
+    }
+
+    Fence fence;
+    fence.sync  = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fence.frame = m_frameCount;
+    m_fences.push_back(fence);
+
+    return m_frameCount;
+}
+
+void FrameLatencyLimiter::retireCompletedFrames() {
+    while (!m_fences.empty()) {
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv((GLsync)m_fences.front().sync, GL_SYNC_STATUS, sizeof(status), NULL, &status);
+
+        if (status != GL_SIGNALED) {
+            return;
+        }
+
+        retireFrontFence();
+    }
+}
+
+void FrameLatencyLimiter::retireFrontFence() {
+    glDeleteSync((GLsync)m_fences.front().sync);
+    m_completedFrames = m_fences.front().frame;
+    m_fences.pop_front();
+}
+
+int FrameLatencyLimiter::framesInFlight() const {
+    return m_framesInFlight.load(std::memory_order_relaxed);
+}
+
+std::uint64_t FrameLatencyLimiter::completedFrames() const {
+    return m_completedFrames.load(std::memory_order_acquire);
+}
+
+float FrameLatencyLimiter::lastWaitMilliseconds() const {
+    return m_lastWaitMilliseconds.load(std::memory_order_relaxed);
+}
+
+SampleStatistics FrameLatencyLimiter::queueDepthStatistics() const {
+    return m_queueDepthHistory.statistics();
+}
+
+SampleStatistics FrameLatencyLimiter::waitStatistics() const {
+    return m_waitHistory.statistics();
+}
+
+void FrameLatencyLimiter::drawOverlay() const {
+
+    // see FrameProfiler::drawOverlay(...)
+    if (G3D::GApp::current() == NULL) {
+        return;
+    }
+
+    G3D::screenPrintf("  frames in flight    %d (max %d), waited %.2f ms",
+        framesInFlight(), maxFramesInFlight(), lastWaitMilliseconds());
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef FRAME_LATENCY_LIMITER_HPP
+#define FRAME_LATENCY_LIMITER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+
+#include "SampleRing.hpp"
+
+namespace mojo
+{
+
+//
+// FrameLatencyLimiter bounds how many frames the CPU can queue ahead of the GPU. Even
+// with a swap interval of 1, drivers let the CPU run several frames ahead, and every
+// queued frame adds a frame of latency between input and the frame that shows it.
+// After each swap we insert a GL fence, and before the next frame starts we wait until
+// fewer than maxFramesInFlight() of these fences are unsignaled.
+//
+// While waiting, an optional idle function is called between short waits, which lets
+// the caller process input that arrives while we wait, so the frame samples input as
+// late as possible.
+//
+// All methods except the statistics accessors must be called with the OpenGL context
+// current. The statistics are kept in lock-free rings and can be read from any thread.
+//
+class FrameLatencyLimiter
+{
+public:
+    static const int kHistorySize          = 256;
+    static const int kMaxFramesInFlightCap = 8;
+
+    typedef void (*IdleFunction)(void* arg);
+
+    FrameLatencyLimiter(int maxFramesInFlight = 2);
+    ~FrameLatencyLimiter();
+
+    void cleanup();
+
+    void setMaxFramesInFlight(int maxFramesInFlight);
+    int maxFramesInFlight() const;
+
+    //
+    // Called before a frame starts. Blocks until fewer than maxFramesInFlight() frames
+    // are in flight, calling idle(arg) between waits if it is not NULL.
+    //
+    void waitForFrameSlot(IdleFunction idle = NULL, void* arg = NULL);
+
+    //
+    // Called right after the swap. Returns the number of the frame the fence belongs to.
+    //
+    std::uint64_t endFrame();
+
+    //
+    // The queue depth measured by the last waitForFrameSlot(...), before it waited.
+    //
+    int framesInFlight() const;
+    std::uint64_t completedFrames() const;
+    float lastWaitMilliseconds() const;
+
+    SampleStatistics queueDepthStatistics() const;
+    SampleStatistics waitStatistics() const;
+
+    //
+    // Adds the queue depth and the last wait to the frame profiler overlay.
+    //
+    void drawOverlay() const;
+
+private:
+    static const std::uint64_t kIdleWaitNanoseconds     = 500000;
+    static const std::uint64_t kBlockingWaitNanoseconds = 100000000;
+
+    void retireCompletedFrames();
+    void retireFrontFence();
+
+    struct Fence
+    {
+        void*         sync;
+        std::uint64_t frame;
+    };
+
+    int                        m_maxFramesInFlight;
+    bool                       m_initialized;
+    bool                       m_supported;
+    std::deque<Fence>          m_fences;
+    std::uint64_t              m_frameCount;
+    std::atomic<std::uint64_t> m_completedFrames;
+    std::atomic<int>           m_framesInFlight;
+    std::atomic<float>         m_lastWaitMilliseconds;
+    SampleRing<kHistorySize>   m_queueDepthHistory;
+    SampleRing<kHistorySize>   m_waitHistory;
+};
+
+}
+
+#endif
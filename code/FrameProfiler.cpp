@@ -0,0 +1,155 @@
+#include "FrameProfiler.hpp"
+
+#include <GLG3D/GApp.h>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+FrameProfiler* FrameProfiler::s_current = NULL;
+
+FrameProfiler::FrameProfiler() :
+    m_gpuTimer      (ZONE_COUNT, kGPUFramesInFlight),
+    m_overlayEnabled(false),
+    m_renderScale   (1.0f),
+    m_frameCount    (0) {
+
+    for (int i = 0; i < ZONE_COUNT; ++i) {
+        m_lastCPUMilliseconds[i] = 0.0f;
+    }
+}
+
+FrameProfiler::~FrameProfiler() {
+    if (s_current == this) {
+        s_current = NULL;
+    }
+}
+
+void FrameProfiler::cleanup() {
+    m_gpuTimer.cleanup();
+}
+
+void FrameProfiler::beginFrame() {
+    m_gpuTimer.beginFrame();
+}
+
+void FrameProfiler::endFrame() {
+    m_gpuTimer.endFrame();
+    m_frameCount.fetch_add(1, std::memory_order_release);
+}
+
+void FrameProfiler::beginZone(Zone zone) {
+    MOJO_ASSERT(zone >= 0 && zone < ZONE_COUNT);
+
+    m_gpuTimer.beginZone(zone);
+    m_zoneBegin[zone] = Clock::now();
+}
+
+void FrameProfiler::endZone(Zone zone) {
+    MOJO_ASSERT(zone >= 0 && zone < ZONE_COUNT);
+
+    float milliseconds = std::chrono::duration<float, std::milli>(Clock::now() - m_zoneBegin[zone]).count();
+    m_lastCPUMilliseconds[zone] = milliseconds;
+    m_cpuHistory[zone].push(milliseconds);
+    m_gpuTimer.endZone(zone);
+}
+
+void FrameProfiler::setOverlayEnabled(bool enabled) {
+    m_overlayEnabled = enabled;
+}
+
+bool FrameProfiler::overlayEnabled() const {
+    return m_overlayEnabled;
+}
+
+void FrameProfiler::drawOverlay(const char* title) const {
+
+    //
+    // screenPrintf(...) draws into the debug text of the current GLG3D::GApp, so
+    // there is nothing to draw into when a G3DWidget is running a plain loop body.
+    //
+    if (G3D::GApp::current() == NULL) {
+        return;
+    }
+
+    G3D::screenPrintf("%s (ms)            CPU mean   p50   p99   max    GPU mean   p50   p99   max    render scale %.3f", title, renderScale());
+
+    for (int i = 0; i < ZONE_COUNT; ++i) {
+        Zone             zone = (Zone)i;
+        SampleStatistics cpu  = cpuStatistics(zone);
+        SampleStatistics gpu  = gpuStatistics(zone);
+
+        if (cpu.count == 0) {
+            continue;
+        }
+
+        G3D::screenPrintf("  %-16s    %8.2f %5.2f %5.2f %5.2f    %8.2f %5.2f %5.2f %5.2f",
+            zoneName(zone),
+            cpu.mean, cpu.p50, cpu.p99, cpu.max,
+            gpu.mean, gpu.p50, gpu.p99, gpu.max);
+    }
+}
+
+void FrameProfiler::setRenderScale(float renderScale) {
+    m_renderScale.store(renderScale, std::memory_order_relaxed);
+}
+
+float FrameProfiler::renderScale() const {
+    return m_renderScale.load(std::memory_order_relaxed);
+}
+
+std::uint64_t FrameProfiler::frameCount() const {
+    return m_frameCount.load(std::memory_order_acquire);
+}
+
+float FrameProfiler::lastCPUMilliseconds(Zone zone) const {
+    MOJO_ASSERT(zone >= 0 && zone < ZONE_COUNT);
+    return m_lastCPUMilliseconds[zone];
+}
+
+float FrameProfiler::lastGPUMilliseconds(Zone zone) const {
+    MOJO_ASSERT(zone >= 0 && zone < ZONE_COUNT);
+    return m_gpuTimer.lastMilliseconds(zone);
+}
+
+SampleStatistics FrameProfiler::cpuStatistics(Zone zone) const {
+    MOJO_ASSERT(zone >= 0 && zone < ZONE_COUNT);
+    return m_cpuHistory[zone].statistics();
+}
+
+SampleStatistics FrameProfiler::gpuStatistics(Zone zone) const {
+    MOJO_ASSERT(zone >= 0 && zone < ZONE_COUNT);
+    return m_gpuTimer.statistics(zone);
+}
+
+int FrameProfiler::cpuSamples(Zone zone, float* samples) const {
+    MOJO_ASSERT(zone >= 0 && zone < ZONE_COUNT);
+    return m_cpuHistory[zone].snapshot(samples);
+}
+
+const char* FrameProfiler::zoneName(Zone zone) {
+    switch(zone) {
+    case ZONE_UPDATE:       return "update";
+    case ZONE_FOCUS_CHECK:  return "focusCheck";
+    case ZONE_MAKE_CURRENT: return "makeCurrent";
+    case ZONE_FRAME_WAIT:   return "frameWait";
+    case ZONE_LOOP_BODY:    return "executeLoopBody";
+    case ZONE_SIMULATION:   return "onSimulation";
+    case ZONE_POSE:         return "onPose";
+    case ZONE_GRAPHICS_3D:  return "onGraphics3D";
+    case ZONE_GRAPHICS_2D:  return "onGraphics2D";
+    case ZONE_SWAP_BUFFERS: return "swapBuffers";
+    default:                return "unknown";
+    }
+}
+
+FrameProfiler* FrameProfiler::current() {
+    return s_current;
+}
+
+void FrameProfiler::setCurrent(FrameProfiler* frameProfiler) {
+    s_current = frameProfiler;
+}
+
+}
@@ -0,0 +1,127 @@
+#ifndef FRAME_PROFILER_HPP
+#define FRAME_PROFILER_HPP
+
+#include <chrono>
+
+#include "SampleRing.hpp"
+#include "GPUTimer.hpp"
+
+namespace mojo
+{
+
+//
+// FrameProfiler times the zones of a single G3DWidget's update() on both the CPU
+// and the GPU. Each G3DWidget owns a FrameProfiler and makes it current for the
+// duration of its update(), so GLG3D::GApp callbacks can add their own zones with
+// MOJO_PROFILE_ZONE(...) without knowing which G3DWidget they are running in.
+// Zones outside beginFrame() and endFrame() are timed on the CPU only.
+//
+// The per-zone history is kept in lock-free rings, so the statistics accessors can
+// be called from any thread.
+//
+class FrameProfiler
+{
+public:
+    enum Zone
+    {
+        ZONE_UPDATE,
+        ZONE_FOCUS_CHECK,
+        ZONE_MAKE_CURRENT,
+        ZONE_FRAME_WAIT,
+        ZONE_LOOP_BODY,
+        ZONE_SIMULATION,
+        ZONE_POSE,
+        ZONE_GRAPHICS_3D,
+        ZONE_GRAPHICS_2D,
+        ZONE_SWAP_BUFFERS,
+        ZONE_COUNT
+    };
+
+    static const int kHistorySize       = 256;
+    static const int kGPUFramesInFlight = 4;
+
+    class ScopedZone
+    {
+    public:
+        ScopedZone(FrameProfiler* frameProfiler, Zone zone);
+        ~ScopedZone();
+
+    private:
+        FrameProfiler* m_frameProfiler;
+        Zone           m_zone;
+    };
+
+    FrameProfiler();
+    ~FrameProfiler();
+
+    void cleanup();
+
+    void beginFrame();
+    void endFrame();
+
+    void beginZone(Zone zone);
+    void endZone(Zone zone);
+
+    void setOverlayEnabled(bool enabled);
+    bool overlayEnabled() const;
+    void drawOverlay(const char* title) const;
+
+    void setRenderScale(float renderScale);
+    float renderScale() const;
+
+    std::uint64_t frameCount() const;
+    float lastCPUMilliseconds(Zone zone) const;
+    float lastGPUMilliseconds(Zone zone) const;
+
+    SampleStatistics cpuStatistics(Zone zone) const;
+    SampleStatistics gpuStatistics(Zone zone) const;
+
+    //
+    // Copies the CPU history of the zone, oldest first, into samples, which must have
+    // room for kHistorySize samples. Returns the number of samples copied.
+    //
+    int cpuSamples(Zone zone, float* samples) const;
+
+    static const char* zoneName(Zone zone);
+
+    static FrameProfiler* current();
+    static void setCurrent(FrameProfiler* frameProfiler);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point          m_zoneBegin[ZONE_COUNT];
+    float                      m_lastCPUMilliseconds[ZONE_COUNT];
+    SampleRing<kHistorySize>   m_cpuHistory[ZONE_COUNT];
+    GPUTimer                   m_gpuTimer;
+    bool                       m_overlayEnabled;
+    std::atomic<float>         m_renderScale;
+    std::atomic<std::uint64_t> m_frameCount;
+
+    static FrameProfiler*      s_current;
+};
+
+inline FrameProfiler::ScopedZone::ScopedZone(FrameProfiler* frameProfiler, Zone zone) :
+    m_frameProfiler(frameProfiler),
+    m_zone         (zone)
+{
+    if (m_frameProfiler != NULL) {
+        m_frameProfiler->beginZone(m_zone);
+    }
+}
+
+inline FrameProfiler::ScopedZone::~ScopedZone()
+{
+    if (m_frameProfiler != NULL) {
+        m_frameProfiler->endZone(m_zone);
+    }
+}
+
+}
+
+#define MOJO_PROFILE_ZONE_CONCATENATE_HELPER(a, b) a ## b
+#define MOJO_PROFILE_ZONE_CONCATENATE(a, b) MOJO_PROFILE_ZONE_CONCATENATE_HELPER(a, b)
+
+#define MOJO_PROFILE_ZONE(zone) mojo::FrameProfiler::ScopedZone MOJO_PROFILE_ZONE_CONCATENATE(profileZone, __LINE__)(mojo::FrameProfiler::current(), zone)
+
+#endif
@@ -2,14 +2,19 @@
 
 #include "G3DWidget.hpp"
 
+#include <algorithm>
+
+#include <QtCore/QEventLoop>
 #include <QtCore/QUrl>
 #include <QtCore/QMimeData>
 #include <QtGui/QResizeEvent>
 #include <QtGui/QMouseEvent>
+#include <QtGui/QWheelEvent>
 #include <QtGui/QDragEnterEvent>
 #include <QtGui/QDropEvent>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QClipboard>
+#include <QtGui/QWindow>
 #include <QtWidgets/QApplication>
 
 #include <GLG3D/GLCaps.h>
@@ -18,23 +23,36 @@
 
 #include "Assert.hpp"
 #include "Printf.hpp"
+#include "G3DWidgetEventTranslation.hpp"
+#include "G3DWidgetInputSampling.hpp"
+#include "IngestPipeline.hpp"
+#include "SharedFrameRing.hpp"
 #include "G3DWidgetOpenGLContext.hpp"
 
 namespace mojo
 {
 
+
 G3DWidget::G3DWidget(
     std::shared_ptr<G3DWidgetOpenGLContext> g3dWidgetOpenGLContext,
     std::shared_ptr<G3D::RenderDevice>      renderDevice,
     QWidget* parent) :
-    QWidget                 (parent),
-    m_g3dWidgetOpenGLContext(g3dWidgetOpenGLContext),
-    m_initialized           (false),
-    m_mousePressEventButtons(Qt::NoButton),
-    m_mouseVisible          (true),
-    m_previouslyActive      (false),
-    m_devicePixelRatio      (1.0f),
-    m_GApp                  (NULL) {
+    QWidget                  (parent),
+    m_g3dWidgetOpenGLContext (g3dWidgetOpenGLContext),
+    m_initialized            (false),
+    m_mousePressEventButtons (Qt::NoButton),
+    m_mouseVisible           (true),
+    m_previouslyActive       (false),
+    m_devicePixelRatio       (1.0f),
+    m_GApp                   (NULL),
+    m_frameArena             (FrameArena::create()),
+    m_lateInputSampling      (false),
+    m_remoteWindowActive     (false),
+    m_remoteFocus            (false),
+    m_sharedFrameFramebuffer (0),
+    m_sharedFrameRenderbuffer(0),
+    m_sharedFrameWidth       (0),
+    m_sharedFrameHeight      (0) {
 
     MOJO_RELEASE_ASSERT(g3dWidgetOpenGLContext);
     MOJO_RELEASE_ASSERT(renderDevice);
@@ -97,11 +115,45 @@ void G3DWidget::initialize() {
 void G3DWidget::update() {
     MOJO_RELEASE_ASSERT(m_initialized);
 
+    FrameProfiler::setCurrent(&m_frameProfiler);
+    FrameArena::setCurrent(m_frameArena);
+
     G3D::GApp::setCurrent(m_GApp);
+
+    //
+    // GPU zones can only be recorded once our OpenGL context is current, so the frame
+    // begins right after we make it current, and every zone of the frame, the update
+    // zone included, begins after that. Making the context current is timed on the
+    // CPU only, before the frame.
+    //
+    m_frameProfiler.beginZone(FrameProfiler::ZONE_MAKE_CURRENT);
     OSWindow::makeCurrent();
+    m_frameProfiler.endZone(FrameProfiler::ZONE_MAKE_CURRENT);
+
+    m_frameProfiler.beginFrame();
+    m_frameProfiler.beginZone(FrameProfiler::ZONE_UPDATE);
+
+    //
+    // Wait until few enough of our frames are queued on the GPU. Processing input
+    // events while we wait can run Qt code that makes another G3DWidget current,
+    // e.g., a resize, so we make ourselves current again afterwards.
+    //
+    m_frameProfiler.beginZone(FrameProfiler::ZONE_FRAME_WAIT);
+    if (m_lateInputSampling) {
+        m_frameLatencyLimiter.waitForFrameSlot(&G3DWidget::processInputEvents, this);
+        processInputEvents(this);
+        OSWindow::makeCurrent();
+        releaseHeldBackEvents();
+    } else {
+        m_frameLatencyLimiter.waitForFrameSlot();
+    }
+    m_frameProfiler.endZone(FrameProfiler::ZONE_FRAME_WAIT);
+
+    m_inputLatencyTracker.framesCompleted(m_frameLatencyLimiter.completedFrames());
 
     // construct a G3D::GEventType::FOCUS event
-    bool currentlyActive = QApplication::activeWindow() != NULL;
+    m_frameProfiler.beginZone(FrameProfiler::ZONE_FOCUS_CHECK);
+    bool currentlyActive = windowActive();
     if (currentlyActive != m_previouslyActive) {
         G3D::GEvent e;
         e.type           = G3D::GEventType::FOCUS;
@@ -111,11 +163,33 @@ void G3DWidget::update() {
 
         fireEvent(e);
     }
+    m_frameProfiler.endZone(FrameProfiler::ZONE_FOCUS_CHECK);
+
+    if (m_frameProfiler.overlayEnabled()) {
+        m_frameProfiler.drawOverlay(className().c_str());
+        m_frameLatencyLimiter.drawOverlay();
+        m_inputLatencyTracker.drawOverlay();
+    }
+
+    // the loop body consumes every input we have received so far
+    m_inputLatencyTracker.frameStarted();
 
+    m_frameProfiler.beginZone(FrameProfiler::ZONE_LOOP_BODY);
     executeLoopBody();
+    m_frameProfiler.endZone(FrameProfiler::ZONE_LOOP_BODY);
 
     // swap buffers explicitly
+    m_frameProfiler.beginZone(FrameProfiler::ZONE_SWAP_BUFFERS);
     m_renderDevice->swapBuffers();
+    m_frameProfiler.endZone(FrameProfiler::ZONE_SWAP_BUFFERS);
+
+    m_frameProfiler.endZone(FrameProfiler::ZONE_UPDATE);
+    m_frameProfiler.endFrame();
+    FrameProfiler::setCurrent(NULL);
+
+    // whatever this frame allocated from the arena is gone now
+    FrameArena::setCurrent(std::shared_ptr<FrameArena>());
+    m_frameArena->reset();
 }
 
 void G3DWidget::terminate() {
@@ -127,6 +201,21 @@ void G3DWidget::terminate() {
     }
 
     m_joy.clear();
+
+    // release the GPU timer queries while our OpenGL context is still alive
+    m_g3dWidgetOpenGLContext->makeCurrent();
+    m_frameProfiler.cleanup();
+    m_frameLatencyLimiter.cleanup();
+
+    if (m_sharedFrameFramebuffer != 0) {
+        glDeleteFramebuffers(1, &m_sharedFrameFramebuffer);
+        glDeleteRenderbuffers(1, &m_sharedFrameRenderbuffer);
+
+        m_sharedFrameFramebuffer  = 0;
+        m_sharedFrameRenderbuffer = 0;
+        m_sharedFrameWidth        = 0;
+        m_sharedFrameHeight       = 0;
+    }
 }
 
 QPaintEngine* G3DWidget::paintEngine() const {
@@ -188,7 +277,19 @@ void G3DWidget::reallyMakeCurrent() const {
 
 void G3DWidget::swapGLBuffers() {
     MOJO_RELEASE_ASSERT(m_initialized);
+
+    // the back buffer is undefined after the swap, so we read it back before
+    if (m_sharedFrameRing) {
+        writeSharedFrame();
+    }
+
     m_g3dWidgetOpenGLContext->flushBuffer();
+
+    // the fence follows the swap, so it signals once the GPU is done with this frame
+    std::uint64_t frame = m_frameLatencyLimiter.endFrame();
+
+    m_inputLatencyTracker.frameSwapped(frame);
+    m_inputLatencyTracker.framesCompleted(m_frameLatencyLimiter.completedFrames());
 }
 
 void G3DWidget::getSettings(G3D::OSWindow::Settings& settings) const {
@@ -226,7 +327,7 @@ int G3DWidget::height() const {
 
 bool G3DWidget::hasFocus() const {
     MOJO_RELEASE_ASSERT(m_initialized);
-    return QApplication::activeWindow() != NULL;
+    return windowActive();
 }
 
 void G3DWidget::getRelativeMouseState(G3D::Vector2& position, G3D::uint8& mouseButtons) const {
@@ -359,6 +460,330 @@ void G3DWidget::setGammaRamp(const G3D::Array<G3D::uint16>& gammaRamp) {
     MOJO_ASSERT(success);
 }
 
+FrameProfiler& G3DWidget::frameProfiler() {
+    return m_frameProfiler;
+}
+
+const FrameProfiler& G3DWidget::frameProfiler() const {
+    return m_frameProfiler;
+}
+
+FrameArena& G3DWidget::frameArena() {
+    return *m_frameArena;
+}
+
+const FrameArena& G3DWidget::frameArena() const {
+    return *m_frameArena;
+}
+
+FrameLatencyLimiter& G3DWidget::frameLatencyLimiter() {
+    return m_frameLatencyLimiter;
+}
+
+const FrameLatencyLimiter& G3DWidget::frameLatencyLimiter() const {
+    return m_frameLatencyLimiter;
+}
+
+void G3DWidget::setLateInputSampling(bool enabled) {
+    m_lateInputSampling = enabled;
+}
+
+InputLatencyTracker& G3DWidget::inputLatencyTracker() {
+    return m_inputLatencyTracker;
+}
+
+const InputLatencyTracker& G3DWidget::inputLatencyTracker() const {
+    return m_inputLatencyTracker;
+}
+
+bool G3DWidget::lateInputSampling() const {
+    return m_lateInputSampling;
+}
+
+//
+// Late input sampling only dispatches the input events waiting in the native event
+// queue, see G3DWidgetInputSampling.hpp, so timers, socket notifiers and posted events,
+// e.g., queued slot calls and paint requests, wait for the event loop after the frame.
+//
+// Input can still cause other events, e.g., a click that resizes or closes a window,
+// so while we dispatch it we are installed as an event filter on the application, and
+// only let input and focus events through. The others are held back and repeated after
+// the frame, see releaseHeldBackEvents(); timer events are dropped, their timers fire
+// again once their interval has passed. Events we cannot repeat are delivered.
+//
+void G3DWidget::processInputEvents(void* arg) {
+    G3DWidget* g3dWidget = (G3DWidget*)arg;
+
+    qApp->installEventFilter(g3dWidget);
+    dispatchPendingInputEvents();
+    qApp->removeEventFilter(g3dWidget);
+}
+
+bool G3DWidget::eventFilter(QObject* watched, QEvent* e) {
+    switch (e->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove:
+    case QEvent::NonClientAreaMouseButtonPress:
+    case QEvent::NonClientAreaMouseButtonRelease:
+    case QEvent::NonClientAreaMouseButtonDblClick:
+    case QEvent::NonClientAreaMouseMove:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::ShortcutOverride:
+    case QEvent::InputMethod:
+    case QEvent::InputMethodQuery:
+    case QEvent::TabletPress:
+    case QEvent::TabletMove:
+    case QEvent::TabletRelease:
+    case QEvent::TabletEnterProximity:
+    case QEvent::TabletLeaveProximity:
+    case QEvent::DragEnter:
+    case QEvent::DragMove:
+    case QEvent::DragLeave:
+    case QEvent::Drop:
+    case QEvent::FocusIn:
+    case QEvent::FocusOut:
+    case QEvent::FocusAboutToChange:
+    case QEvent::Enter:
+    case QEvent::Leave:
+    case QEvent::HoverEnter:
+    case QEvent::HoverLeave:
+    case QEvent::HoverMove:
+    case QEvent::WindowActivate:
+    case QEvent::WindowDeactivate:
+    case QEvent::ActivationChange:
+    case QEvent::ApplicationStateChange:
+        return false;
+
+    case QEvent::Timer:
+        return true;
+
+    case QEvent::Close:
+        if (watched->isWidgetType()) {
+            QWidget* widget = (QWidget*)watched;
+            if (!m_heldBackCloses.contains(widget)) {
+                m_heldBackCloses.append(widget);
+            }
+            e->ignore();
+            return true;
+        }
+        return false;
+
+    case QEvent::Paint:
+    case QEvent::UpdateRequest:
+    case QEvent::UpdateLater:
+    case QEvent::Expose:
+        if (!m_heldBackUpdates.contains(watched)) {
+            m_heldBackUpdates.append(watched);
+        }
+        return true;
+
+    case QEvent::DeferredDelete:
+        if (!m_heldBackDeletes.contains(watched)) {
+            m_heldBackDeletes.append(watched);
+        }
+        return true;
+
+    default: {
+        QEvent* copy = copyEvent(e);
+        if (copy == NULL) {
+            return false;
+        }
+
+        m_heldBackEvents.append(qMakePair(QPointer<QObject>(watched), copy));
+        return true;
+    }
+    }
+}
+
+//
+// Copies the events that input commonly causes besides input, so they can be held
+// back, or returns NULL.
+//
+QEvent* G3DWidget::copyEvent(const QEvent* e) {
+    switch (e->type()) {
+    case QEvent::Resize:
+        return new QResizeEvent(*(const QResizeEvent*)e);
+
+    case QEvent::Move:
+        return new QMoveEvent(*(const QMoveEvent*)e);
+
+    case QEvent::WindowStateChange:
+        return new QWindowStateChangeEvent(*(const QWindowStateChangeEvent*)e);
+
+    case QEvent::ContextMenu:
+        return new QContextMenuEvent(*(const QContextMenuEvent*)e);
+
+    case QEvent::Shortcut:
+        return new QShortcutEvent(*(const QShortcutEvent*)e);
+
+    case QEvent::LayoutRequest:
+    case QEvent::PolishRequest:
+        return new QEvent(e->type());
+
+    default:
+        return NULL;
+    }
+}
+
+//
+// Posts what processInputEvents(...) held back, so it happens after the frame.
+//
+void G3DWidget::releaseHeldBackEvents() {
+    for (const QPointer<QWidget>& widget : m_heldBackCloses) {
+        if (widget) {
+            QMetaObject::invokeMethod(widget, "close", Qt::QueuedConnection);
+        }
+    }
+    m_heldBackCloses.clear();
+
+    // a window's contents are painted by the widgets in it
+    for (const QPointer<QObject>& object : m_heldBackUpdates) {
+        if (!object) {
+            continue;
+        }
+
+        if (object->isWidgetType()) {
+            ((QWidget*)object.data())->update();
+        } else if (object->isWindowType()) {
+            for (QWidget* widget : QApplication::topLevelWidgets()) {
+                if (widget->windowHandle() == object.data()) {
+                    widget->update();
+                }
+            }
+        }
+    }
+    m_heldBackUpdates.clear();
+
+    for (const QPointer<QObject>& object : m_heldBackDeletes) {
+        if (object) {
+            object->deleteLater();
+        }
+    }
+    m_heldBackDeletes.clear();
+
+    for (const HeldBackEvent& heldBackEvent : m_heldBackEvents) {
+        if (heldBackEvent.first) {
+            QCoreApplication::postEvent(heldBackEvent.first, heldBackEvent.second);
+        } else {
+            delete heldBackEvent.second;
+        }
+    }
+    m_heldBackEvents.clear();
+}
+
+void G3DWidget::setIngestPipeline(std::shared_ptr<IngestPipeline> ingestPipeline) {
+    m_ingestPipeline = ingestPipeline;
+}
+
+void G3DWidget::setSharedFrameRing(std::shared_ptr<SharedFrameRing> sharedFrameRing) {
+    m_sharedFrameRing = sharedFrameRing;
+}
+
+void G3DWidget::setRemoteWindowActive(bool active) {
+    m_remoteWindowActive = active;
+}
+
+void G3DWidget::setRemoteFocus(bool focus) {
+    m_remoteFocus = focus;
+}
+
+void G3DWidget::setDevicePixelRatio(qreal devicePixelRatio) {
+    if (devicePixelRatio == m_devicePixelRatio) {
+        return;
+    }
+
+    m_devicePixelRatio = devicePixelRatio;
+
+    // our size in device pixels changed, even if resize(...) won't be called
+    if (m_initialized && m_renderDevice != NULL) {
+        OSWindow::makeCurrent();
+        handleResize(width(), height());
+    }
+}
+
+bool G3DWidget::windowActive() const {
+    if (m_sharedFrameRing) {
+        return m_remoteWindowActive && m_remoteFocus;
+    }
+
+    return QApplication::activeWindow() != NULL;
+}
+
+void G3DWidget::writeSharedFrame() {
+    int frameWidth  = std::min(width(),  m_sharedFrameRing->maxWidth());
+    int frameHeight = std::min(height(), m_sharedFrameRing->maxHeight());
+
+    if (frameWidth <= 0 || frameHeight <= 0) {
+        return;
+    }
+
+    //
+    // glReadPixels(...) returns the bottom row first, and the RemoteG3DWidget draws
+    // the top row first, so we flip the frame with a blit into a renderbuffer of our
+    // own and read that straight into the shared memory. The GPU does the flip, and
+    // the readback stays the only copy the frame makes on its way to the other
+    // process. Flipping blits need a framebuffer without multisampling, which is what
+    // the RenderProcess asks for. G3D::RenderDevice tracks the GL state it sets, so
+    // we restore what we change.
+    //
+    GLint readFramebuffer, drawFramebuffer, renderbuffer, readBuffer, packAlignment;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+    glGetIntegerv(GL_RENDERBUFFER_BINDING,     &renderbuffer);
+    glGetIntegerv(GL_READ_BUFFER,              &readBuffer);
+    glGetIntegerv(GL_PACK_ALIGNMENT,           &packAlignment);
+
+    GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+
+    if (m_sharedFrameFramebuffer == 0) {
+        glGenFramebuffers(1, &m_sharedFrameFramebuffer);
+        glGenRenderbuffers(1, &m_sharedFrameRenderbuffer);
+    }
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_sharedFrameFramebuffer);
+
+    if (frameWidth != m_sharedFrameWidth || frameHeight != m_sharedFrameHeight) {
+        glBindRenderbuffer(GL_RENDERBUFFER, m_sharedFrameRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, frameWidth, frameHeight);
+        glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_sharedFrameRenderbuffer);
+
+        m_sharedFrameWidth  = frameWidth;
+        m_sharedFrameHeight = frameHeight;
+    }
+
+    // a frame larger than the ring keeps its top left corner, as the window would
+    int top = height();
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glReadBuffer(GL_BACK);
+    glDisable(GL_SCISSOR_TEST);
+    glBlitFramebuffer(0, top - frameHeight, frameWidth, top, 0, frameHeight, frameWidth, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_sharedFrameFramebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    glReadPixels(0, 0, frameWidth, frameHeight, GL_RGBA, GL_UNSIGNED_BYTE, m_sharedFrameRing->beginWrite(frameWidth, frameHeight));
+
+    glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+
+    if (scissorTest) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glReadBuffer(readBuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+
+    m_sharedFrameRing->endWrite();
+}
+
 void G3DWidget::paintEvent(QPaintEvent*) {
 }
 
@@ -390,13 +815,8 @@ void G3DWidget::leaveEvent(QEvent*) {
 void G3DWidget::mouseMoveEvent(QMouseEvent* mouseEvent) {
     if (m_initialized) {
         G3D::GEvent e;
-        e.motion.type  = G3D::GEventType::MOUSE_MOTION;
-        e.motion.which = 0;
-        e.motion.state = getG3DMouseButtonPressedFlags(mouseEvent->buttons());
-        e.motion.x     = mouseEvent->x() * m_devicePixelRatio;
-        e.motion.y     = mouseEvent->y() * m_devicePixelRatio;
-        e.motion.xrel  = (mouseEvent->pos() - m_mousePrevPos).x() * m_devicePixelRatio;
-        e.motion.yrel  = (mouseEvent->pos() - m_mousePrevPos).y() * m_devicePixelRatio;
+        makeMouseMotionEvent(mouseEvent, m_mousePrevPos, m_devicePixelRatio, e);
+        m_inputLatencyTracker.inputReceived(InputLatencyTracker::INPUT_MOUSE_MOTION, mouseEvent->timestamp());
 
         m_mousePrevPos = mouseEvent->pos();
 
@@ -407,12 +827,8 @@ void G3DWidget::mouseMoveEvent(QMouseEvent* mouseEvent) {
 void G3DWidget::mousePressEvent(QMouseEvent* mouseEvent) {
     if (m_initialized) {
         G3D::GEvent e;
-        e.button.type   = G3D::GEventType::MOUSE_BUTTON_DOWN;
-        e.button.which  = 0;
-        e.button.state  = G3D::GButtonState::PRESSED;
-        e.button.x      = mouseEvent->x() * m_devicePixelRatio;
-        e.button.y      = mouseEvent->y() * m_devicePixelRatio;
-        e.button.button = getG3DMouseButtonPressedIndex(mouseEvent->buttons());
+        makeMouseButtonDownEvent(mouseEvent, m_devicePixelRatio, e);
+        m_inputLatencyTracker.inputReceived(InputLatencyTracker::INPUT_MOUSE_BUTTON, mouseEvent->timestamp());
 
         m_mousePressEventButtons = mouseEvent->buttons();
 
@@ -423,12 +839,8 @@ void G3DWidget::mousePressEvent(QMouseEvent* mouseEvent) {
 void G3DWidget::mouseReleaseEvent(QMouseEvent* mouseEvent) {
     if (m_initialized) {
         G3D::GEvent e;
-        e.button.type   = G3D::GEventType::MOUSE_BUTTON_UP;
-        e.button.which  = 0;
-        e.button.state  = G3D::GButtonState::RELEASED;
-        e.button.x      = mouseEvent->x() * m_devicePixelRatio;
-        e.button.y      = mouseEvent->y() * m_devicePixelRatio;
-        e.button.button = getG3DMouseButtonPressedIndex(m_mousePressEventButtons);
+        makeMouseButtonUpEvent(mouseEvent, m_mousePressEventButtons, m_devicePixelRatio, e);
+        m_inputLatencyTracker.inputReceived(InputLatencyTracker::INPUT_MOUSE_BUTTON, mouseEvent->timestamp());
 
         m_mousePressEventButtons = Qt::NoButton;
 
@@ -441,6 +853,18 @@ void G3DWidget::mouseReleaseEvent(QMouseEvent* mouseEvent) {
     }
 }
 
+void G3DWidget::wheelEvent(QWheelEvent* wheelEvent) {
+    if (m_initialized) {
+        G3D::GEvent e;
+        bool        notch = makeMouseScrollEvent(wheelEvent, m_pendingWheelDelta, e);
+        m_inputLatencyTracker.inputReceived(InputLatencyTracker::INPUT_MOUSE_WHEEL, wheelEvent->timestamp());
+
+        if (notch) {
+            fireEvent(e);
+        }
+    }
+}
+
 void G3DWidget::dragEnterEvent(QDragEnterEvent* dragEnterEvent) {
     if (m_initialized) {
         if (dragEnterEvent->mimeData()->hasUrls()) {
@@ -451,17 +875,29 @@ void G3DWidget::dragEnterEvent(QDragEnterEvent* dragEnterEvent) {
 
 void G3DWidget::dropEvent(QDropEvent* dropEvent) {
     if (m_initialized) {
+        QPoint position = dropEvent->pos() * m_devicePixelRatio;
+
         m_dropFileList.clear();
         Q_FOREACH(QUrl url, dropEvent->mimeData()->urls()) {
-            m_dropFileList.append(G3D::String(url.toLocalFile().toLatin1()));
+            QString path = url.toLocalFile();
+
+            if (m_ingestPipeline && IngestPipeline::canIngest(path)) {
+                m_ingestPipeline->enqueue(path, this, position);
+            } else {
+                m_dropFileList.append(G3D::String(path.toUtf8().constData()));
+            }
         }
 
         dropEvent->acceptProposedAction();
 
+        if (m_dropFileList.size() == 0) {
+            return;
+        }
+
         G3D::GEvent e;
         e.drop.type = G3D::GEventType::FILE_DROP;
-        e.drop.x    = dropEvent->pos().x() * m_devicePixelRatio;
-        e.drop.y    = dropEvent->pos().y() * m_devicePixelRatio;
+        e.drop.x    = position.x();
+        e.drop.y    = position.y();
 
         fireEvent(e);
     }
@@ -469,43 +905,28 @@ void G3DWidget::dropEvent(QDropEvent* dropEvent) {
 
 void G3DWidget::keyPressEvent(QKeyEvent* k) {
     G3D::GEvent e;
-    e.key.which = 0; //All keyboard events map to 0 currently
-    e.key.type  = k->isAutoRepeat() ? G3D::GEventType::KEY_REPEAT : G3D::GEventType::KEY_DOWN;
-    e.key.state = G3D::GButtonState::PRESSED;
-
-    keyEvent(k, e);
+    makeKeyDownEvent(k, e);
+    m_inputLatencyTracker.inputReceived(InputLatencyTracker::INPUT_KEY, k->timestamp());
     fireEvent(e);
 
-    if(k->key() >= Qt::Key_Exclam && k->key() <= Qt::Key_AsciiTilde) {
-        G3D::GEvent e;
-        e.type = G3D::GEventType::CHAR_INPUT;
-
-        if (k->text().toLatin1().length()) {
-            e.character.unicode = k->text().toLatin1().at(0);
-        } else {
-            e.character.unicode = 0;
-        }
-
-        fireEvent(e);
+    G3D::GEvent c;
+    if (makeCharInputEvent(k, c)) {
+        fireEvent(c);
     }
 }
 
 void G3DWidget::keyReleaseEvent(QKeyEvent* k) {
     if (!k->isAutoRepeat()) {
         G3D::GEvent e;
-        e.key.which = 0; //All keyboard events map to 0 currently
-        e.key.type  = G3D::GEventType::KEY_UP;
-        e.key.state = G3D::GButtonState::RELEASED;
-
-        keyEvent(k, e);
-
+        makeKeyUpEvent(k, e);
+        m_inputLatencyTracker.inputReceived(InputLatencyTracker::INPUT_KEY, k->timestamp());
         fireEvent(e);
     }
 }
 
 G3D::String G3DWidget::_clipboardText() const {
     MOJO_RELEASE_ASSERT(m_initialized);
-    return G3D::String(QApplication::clipboard()->text().toLatin1());
+    return G3D::String(QApplication::clipboard()->text().toUtf8().constData());
 }
 
 void G3DWidget::_setClipboardText(const G3D::String& text) const {
@@ -513,117 +934,4 @@ void G3DWidget::_setClipboardText(const G3D::String& text) const {
     QApplication::clipboard()->setText(text.c_str());
 }
 
-G3D::uint8 G3DWidget::getG3DMouseButtonPressedFlags(Qt::MouseButtons qtMouseButtons) const {
-    G3D::uint8 g3dMouseButtonPressedFlags = 0;
-
-    if (qtMouseButtons & Qt::LeftButton)
-        g3dMouseButtonPressedFlags |= 1 << 0;
-    if (qtMouseButtons & Qt::RightButton)
-        g3dMouseButtonPressedFlags |= 1 << 2;
-    if (qtMouseButtons & Qt::MiddleButton)
-        g3dMouseButtonPressedFlags |= 1 << 1;
-    if (qtMouseButtons & Qt::XButton1)
-        g3dMouseButtonPressedFlags |= 1 << 3;
-    if (qtMouseButtons & Qt::XButton2)
-        g3dMouseButtonPressedFlags |= 1 << 4;
-
-    return g3dMouseButtonPressedFlags;
-}
-
-G3D::uint8 G3DWidget::getG3DMouseButtonPressedIndex(Qt::MouseButtons qtMouseButtons) const {
-    if (qtMouseButtons & Qt::LeftButton)
-        return 0;
-    if (qtMouseButtons & Qt::RightButton)
-        return 2;
-    if (qtMouseButtons & Qt::MiddleButton)
-        return 1;
-    if (qtMouseButtons & Qt::XButton1)
-        return 3;
-    if (qtMouseButtons & Qt::XButton2)
-        return 4;
-
-    MOJO_ASSERT(0 && "No mouse buttons have been pressed.");
-    return 255;
-}
-
-void G3DWidget::keyEvent(QKeyEvent* keyEvent, G3D::GEvent& e) {
-
-    switch(keyEvent->key()) {
-    case Qt::Key_Escape:        e.key.keysym.sym = G3D::GKey::ESCAPE;     break;
-    case Qt::Key_Enter:         e.key.keysym.sym = G3D::GKey::RETURN;     break;
-    case Qt::Key_Return:        e.key.keysym.sym = G3D::GKey::RETURN;     break;
-    case Qt::Key_Tab:           e.key.keysym.sym = G3D::GKey::TAB;        break;
-    case Qt::Key_Backspace:     e.key.keysym.sym = G3D::GKey::BACKSPACE;  break;
-    case Qt::Key_Insert:        e.key.keysym.sym = G3D::GKey::INSERT;     break;
-    case Qt::Key_Delete:        e.key.keysym.sym = G3D::GKey::DELETE;     break;
-    case Qt::Key_Right:         e.key.keysym.sym = G3D::GKey::RIGHT;      break;
-    case Qt::Key_Left:          e.key.keysym.sym = G3D::GKey::LEFT;       break;
-    case Qt::Key_Down:          e.key.keysym.sym = G3D::GKey::DOWN;       break;
-    case Qt::Key_Up:            e.key.keysym.sym = G3D::GKey::UP;         break;
-    case Qt::Key_PageUp:        e.key.keysym.sym = G3D::GKey::PAGEUP;     break;
-    case Qt::Key_PageDown:      e.key.keysym.sym = G3D::GKey::PAGEDOWN;   break;
-    case Qt::Key_Home:          e.key.keysym.sym = G3D::GKey::HOME;       break;
-    case Qt::Key_End:           e.key.keysym.sym = G3D::GKey::END;        break;
-    case Qt::Key_CapsLock:      e.key.keysym.sym = G3D::GKey::CAPSLOCK;   break;
-    case Qt::Key_ScrollLock:    e.key.keysym.sym = G3D::GKey::SCROLLOCK;  break;
-    case Qt::Key_NumLock:       e.key.keysym.sym = G3D::GKey::NUMLOCK;    break;
-    case Qt::Key_Print:         e.key.keysym.sym = G3D::GKey::PRINT;      break;
-    case Qt::Key_Pause:         e.key.keysym.sym = G3D::GKey::PAUSE;      break;
-    case Qt::Key_Shift:         e.key.keysym.sym = G3D::GKey::LSHIFT;     break;
-    case Qt::Key_Control:       e.key.keysym.sym = G3D::GKey::LCTRL;      break;
-    case Qt::Key_Meta:          e.key.keysym.sym = G3D::GKey::LCTRL;      break;
-    case Qt::Key_Alt:           e.key.keysym.sym = G3D::GKey::LALT;       break;
-    case Qt::Key_Super_L:       e.key.keysym.sym = G3D::GKey::LSUPER;     break;
-    case Qt::Key_Super_R:       e.key.keysym.sym = G3D::GKey::RSUPER;     break;
-    case Qt::Key_Menu:          e.key.keysym.sym = G3D::GKey::MENU;       break;
-    default:
-        if(keyEvent->key() >= Qt::Key_A && keyEvent->key() <= Qt::Key_Z) {
-            e.key.keysym.sym = (G3D::GKey::Value)(keyEvent->key() + 'a' - 'A');
-        } else if(keyEvent->key() >= Qt::Key_Exclam && keyEvent->key() <= Qt::Key_AsciiTilde) {
-            e.key.keysym.sym = (G3D::GKey::Value)keyEvent->key();
-        } else if (keyEvent->key() >= Qt::Key_F1 && keyEvent->key() <= Qt::Key_F15) {
-            e.key.keysym.sym = (G3D::GKey::Value)(keyEvent->key() - Qt::Key_F1 + G3D::GKey::F1);
-        } else {
-            MOJO_ASSERT(0 && "Unsupported key.");
-        }
-    }
-
-    if (keyEvent->modifiers() & Qt::KeypadModifier) {
-        switch(keyEvent->key()) {
-        case Qt::Key_Right:         e.key.keysym.sym = G3D::GKey::RIGHT;       break;
-        case Qt::Key_Left:          e.key.keysym.sym = G3D::GKey::LEFT;        break;
-        case Qt::Key_Down:          e.key.keysym.sym = G3D::GKey::DOWN;        break;
-        case Qt::Key_Up:            e.key.keysym.sym = G3D::GKey::UP;          break;
-        case Qt::Key_Period:        e.key.keysym.sym = G3D::GKey::KP_PERIOD;   break;
-        case Qt::Key_Slash:         e.key.keysym.sym = G3D::GKey::KP_DIVIDE;   break;
-        case Qt::Key_Asterisk:      e.key.keysym.sym = G3D::GKey::KP_MULTIPLY; break;
-        case Qt::Key_Minus:         e.key.keysym.sym = G3D::GKey::KP_MINUS;    break;
-        case Qt::Key_Plus:          e.key.keysym.sym = G3D::GKey::KP_PLUS;     break;
-        case Qt::Key_Enter:         e.key.keysym.sym = G3D::GKey::KP_ENTER;    break;
-        case Qt::Key_Equal:         e.key.keysym.sym = G3D::GKey::KP_EQUALS;   break;
-        default:
-            if (keyEvent->key() >= Qt::Key_0 && keyEvent->key() <= Qt::Key_9) {
-                e.key.keysym.sym = (G3D::GKey::Value)((keyEvent->key() - Qt::Key_0) + G3D::GKey::KP0);
-            }
-        }
-    }
-
-    G3D::GKeyMod::Value mod = (G3D::GKeyMod::Value)0;
-    if (keyEvent->modifiers() & Qt::ShiftModifier) {
-        mod = (G3D::GKeyMod::Value)(mod | G3D::GKeyMod::LSHIFT);
-    }
-    if (keyEvent->modifiers() & Qt::ControlModifier) {
-        mod = (G3D::GKeyMod::Value)(mod | G3D::GKeyMod::LCTRL);
-    }
-    if (keyEvent->modifiers() & Qt::AltModifier) {
-        mod = (G3D::GKeyMod::Value)(mod | G3D::GKeyMod::LALT);
-    }
-    e.key.keysym.mod = mod;
-
-    //TODO: Properly set e.key.keysym.unicode
-    e.key.keysym.unicode = keyEvent->key();
-
-    //TODO: Properly set e.key.keysym.scancode
-    e.key.keysym.scancode = keyEvent->key();
-}
 }
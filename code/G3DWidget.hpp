@@ -3,6 +3,9 @@
 
 #include <memory>
 
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QPointer>
 #include <QtWidgets/QWidget>
 
 #include <GLG3D/OSWindow.h>
@@ -12,6 +15,11 @@
 #undef main
 #endif
 
+#include "FrameProfiler.hpp"
+#include "FrameArena.hpp"
+#include "FrameLatencyLimiter.hpp"
+#include "InputLatencyTracker.hpp"
+
 namespace G3D
 {
 class GApp;
@@ -22,6 +30,8 @@ namespace mojo
 {
 
 class G3DWidgetOpenGLContext;
+class IngestPipeline;
+class SharedFrameRing;
 
 class G3DWidget : public QWidget, public G3D::OSWindow
 {
@@ -86,7 +96,62 @@ public:
     virtual void setClientPosition(int, int);    
     virtual void setGammaRamp(const G3D::Array<G3D::uint16>& gammaRamp);
 
+    FrameProfiler& frameProfiler();
+    const FrameProfiler& frameProfiler() const;
+
+    //
+    // Current for the duration of update(), and reset at its end; see FrameArena.hpp.
+    //
+    FrameArena& frameArena();
+    const FrameArena& frameArena() const;
+
+    //
+    // Bounds how many of this G3DWidget's frames can be queued on the GPU, see
+    // FrameLatencyLimiter.hpp. Its framesInFlight() is the measured queue depth.
+    //
+    FrameLatencyLimiter& frameLatencyLimiter();
+    const FrameLatencyLimiter& frameLatencyLimiter() const;
+
+    //
+    // The age of the input each frame consumed, at its swap and once the GPU has
+    // finished it, per input type.
+    //
+    InputLatencyTracker& inputLatencyTracker();
+    const InputLatencyTracker& inputLatencyTracker() const;
+
+    //
+    // When enabled, pending input events are processed while update() waits for a
+    // frame slot, so each frame starts with the latest input. Only input is processed
+    // then, without running the event loop: timers, queued slot calls, paint requests
+    // and the like wait until after the frame, and so do the resizes and requests to
+    // close a window that input causes, so nothing can update or tear down a
+    // G3DWidget in the middle of a frame.
+    //
+    void setLateInputSampling(bool enabled);
+    bool lateInputSampling() const;
+
+    //
+    // When set, dropped files that the pipeline can load are handed to it instead of
+    // being reported to the GLG3D::GApp with a G3D::GEventType::FILE_DROP event, so
+    // they load in the background. Other files are reported as before.
+    //
+    void setIngestPipeline(std::shared_ptr<IngestPipeline> ingestPipeline);
+
+    //
+    // When set, every frame is read back into the ring before it is swapped, top row
+    // first, so a RemoteG3DWidget in another process can show it, see
+    // RenderProcess.hpp. Such a G3DWidget is never in the active window of its own
+    // process, so it has focus while the RemoteG3DWidget does, as set by
+    // setRemoteWindowActive(...) and setRemoteFocus(...), and it renders at the
+    // device pixel ratio of the RemoteG3DWidget's screen rather than its own.
+    //
+    void setSharedFrameRing(std::shared_ptr<SharedFrameRing> sharedFrameRing);
+    void setRemoteWindowActive(bool active);
+    void setRemoteFocus(bool focus);
+    void setDevicePixelRatio(qreal devicePixelRatio);
+
 protected:
+    virtual bool eventFilter(QObject* watched, QEvent* e);
     virtual void paintEvent(QPaintEvent*);
     virtual void resizeEvent(QResizeEvent* e);
     virtual void enterEvent(QEvent*);
@@ -94,6 +159,7 @@ protected:
     virtual void mousePressEvent(QMouseEvent* e);
     virtual void mouseReleaseEvent(QMouseEvent* e);
     virtual void mouseMoveEvent(QMouseEvent* e);
+    virtual void wheelEvent(QWheelEvent* e);
     virtual void dragEnterEvent(QDragEnterEvent* e);
     virtual void dropEvent(QDropEvent* e);
     virtual void keyPressEvent(QKeyEvent* e);
@@ -103,21 +169,44 @@ protected:
     virtual void _setClipboardText(const G3D::String&) const;
 
 private:
-    G3D::uint8 getG3DMouseButtonPressedFlags(Qt::MouseButtons mouseButtons) const;
-    G3D::uint8 getG3DMouseButtonPressedIndex(Qt::MouseButtons mouseButtons) const;
+    // an event to post to its receiver after the frame
+    typedef QPair<QPointer<QObject>, QEvent*> HeldBackEvent;
+
+    static void processInputEvents(void* arg);
+    static QEvent* copyEvent(const QEvent* e);
+    void releaseHeldBackEvents();
 
-    void keyEvent(QKeyEvent* keyEvent, G3D::GEvent& e);
+    bool windowActive() const;
+    void writeSharedFrame();
 
     std::shared_ptr<G3DWidgetOpenGLContext> m_g3dWidgetOpenGLContext;
     bool                                    m_initialized;
     QPoint                                  m_mousePrevPos;
     Qt::MouseButtons                        m_mousePressEventButtons;
+    QPoint                                  m_pendingWheelDelta;
     bool                                    m_mouseVisible;
     G3D::Array<SDL_Joystick*>               m_joy;
     G3D::Array<G3D::String>                 m_dropFileList;
     bool                                    m_previouslyActive;
     qreal                                   m_devicePixelRatio;
     G3D::GApp*                              m_GApp;
+    FrameProfiler                           m_frameProfiler;
+    std::shared_ptr<FrameArena>             m_frameArena;
+    FrameLatencyLimiter                     m_frameLatencyLimiter;
+    InputLatencyTracker                     m_inputLatencyTracker;
+    bool                                    m_lateInputSampling;
+    std::shared_ptr<IngestPipeline>         m_ingestPipeline;
+    std::shared_ptr<SharedFrameRing>        m_sharedFrameRing;
+    bool                                    m_remoteWindowActive;
+    bool                                    m_remoteFocus;
+    unsigned int                            m_sharedFrameFramebuffer;
+    unsigned int                            m_sharedFrameRenderbuffer;
+    int                                     m_sharedFrameWidth;
+    int                                     m_sharedFrameHeight;
+    QList<QPointer<QWidget> >               m_heldBackCloses;
+    QList<QPointer<QObject> >               m_heldBackUpdates;
+    QList<QPointer<QObject> >               m_heldBackDeletes;
+    QList<HeldBackEvent>                    m_heldBackEvents;
 };
 
 }
@@ -4,7 +4,10 @@
 #
 #-------------------------------------------------
 
-QT += core widgets webkitwidgets
+QT += core widgets network webkitwidgets
+
+# late input sampling dispatches native input through Qt's platform interface
+QT += gui-private
 
 TARGET = G3DWidgetDemo
 
@@ -20,6 +23,35 @@ QMAKE_CXXFLAGS         += -msse4.1 -Wno-unknown-pragmas
 QMAKE_OBJECTIVE_CFLAGS_WARN_ON  = ""
 QMAKE_OBJECTIVE_CFLAGS         += -msse4.1 -Wno-unknown-pragmas
 
+#
+# Optimized builds, see build_pgo.sh:
+#
+#   qmake CONFIG+=ltcg                     link time optimization (qmake's own option)
+#   qmake CONFIG+=pgo_generate             instrumented build that writes .profraw files
+#   qmake CONFIG+=pgo_use PGO_PROFILE=...  build using a profile merged by llvm-profdata
+#
+pgo_generate {
+    QMAKE_CXXFLAGS         += -fprofile-instr-generate
+    QMAKE_OBJECTIVE_CFLAGS += -fprofile-instr-generate
+    QMAKE_LFLAGS           += -fprofile-instr-generate
+}
+
+pgo_use {
+    isEmpty(PGO_PROFILE):PGO_PROFILE = $$OUT_PWD/G3DWidgetDemo.profdata
+
+    QMAKE_CXXFLAGS         += -fprofile-instr-use=$$PGO_PROFILE -Wno-profile-instr-out-of-date -Wno-profile-instr-unprofiled
+    QMAKE_OBJECTIVE_CFLAGS += -fprofile-instr-use=$$PGO_PROFILE -Wno-profile-instr-out-of-date -Wno-profile-instr-unprofiled
+    QMAKE_LFLAGS           += -fprofile-instr-use=$$PGO_PROFILE
+}
+
+#
+# In debug builds, PixelShaderApp reloads its shaders from here when they are edited,
+# see ShaderWatcher.hpp. Release builds don't depend on the source tree.
+#
+CONFIG(debug, debug|release) {
+    DEFINES += MOJO_SHADER_SOURCE_DIR=\\\"$$PWD/../shaders\\\"
+}
+
 INCLUDEPATH +=              \
     /opt/local/include      \
     ${G3D10DATA}/../include \
@@ -42,27 +74,79 @@ LIBS +=                      \
 CONFIG(debug,   release|debug):LIBS += -lG3Dd -lGLG3Dd -lassimpd -lcivetwebd -lenetd -lglewd -lglfwd -lnfdd -lzipd
 CONFIG(release, release|debug):LIBS += -lG3D  -lGLG3D  -lassimp  -lcivetweb  -lenet  -lglew  -lglfw  -lnfd  -lzip
 
-HEADERS +=                     \
-    Assert.hpp                 \
-    Printf.hpp                 \
-    ToString.hpp               \
-    QtUtil.hpp                 \
-    G3DWidgetOpenGLContext.hpp \
-    G3DWidget.hpp              \
-    PixelShaderApp.hpp         \
-    StarterApp.hpp             \
-    MainWindow.hpp             \
-
-SOURCES +=             \
-    Printf.cpp         \
-    G3DWidget.cpp      \
-    PixelShaderApp.cpp \
-    StarterApp.cpp     \
-    MainWindow.cpp     \
-    Main.cpp           \
+HEADERS +=                          \
+    Assert.hpp                      \
+    Log.hpp                         \
+    Printf.hpp                      \
+    ToString.hpp                    \
+    QtUtil.hpp                      \
+    SampleRing.hpp                  \
+    GPUTimer.hpp                    \
+    FrameLatencyLimiter.hpp         \
+    InputLatencyTracker.hpp         \
+    FrameArena.hpp                  \
+    FrameProfiler.hpp               \
+    DynamicResolutionController.hpp \
+    FixedStepSimulation.hpp         \
+    CachedGUILayer.hpp              \
+    RenderTargetSetup.hpp           \
+    G3DWidgetOpenGLContext.hpp      \
+    G3DWidgetInputSampling.hpp      \
+    G3DWidgetEventTranslation.hpp   \
+    FlatMesh.hpp                    \
+    IngestPipeline.hpp              \
+    ShaderWatcher.hpp               \
+    ContentHash.hpp                 \
+    TextureCache.hpp                \
+    MeshCache.hpp                   \
+    VideoTextureSource.hpp          \
+    G3DWidget.hpp                   \
+    G3DWidgetScheduler.hpp          \
+    TelemetryServer.hpp             \
+    SharedFrameRing.hpp             \
+    RemoteInputMessage.hpp          \
+    RenderProcess.hpp               \
+    RemoteG3DWidget.hpp             \
+    TrainingWorkload.hpp            \
+    PixelShaderApp.hpp              \
+    StarterApp.hpp                  \
+    MainWindow.hpp                  \
+
+SOURCES +=                          \
+    Assert.cpp                      \
+    Log.cpp                         \
+    Printf.cpp                      \
+    GPUTimer.cpp                    \
+    FrameLatencyLimiter.cpp         \
+    InputLatencyTracker.cpp         \
+    FrameArena.cpp                  \
+    FrameProfiler.cpp               \
+    DynamicResolutionController.cpp \
+    CachedGUILayer.cpp              \
+    RenderTargetSetup.cpp           \
+    G3DWidgetEventTranslation.cpp   \
+    FlatMesh.cpp                    \
+    IngestPipeline.cpp              \
+    ShaderWatcher.cpp               \
+    ContentHash.cpp                 \
+    TextureCache.cpp                \
+    MeshCache.cpp                   \
+    VideoTextureSource.cpp          \
+    G3DWidget.cpp                   \
+    G3DWidgetScheduler.cpp          \
+    TelemetryServer.cpp             \
+    SharedFrameRing.cpp             \
+    RenderProcess.cpp               \
+    RemoteG3DWidget.cpp             \
+    PixelShaderApp.cpp              \
+    StarterApp.cpp                  \
+    TrainingWorkload.cpp            \
+    MainWindow.cpp                  \
+    Main.cpp                        \
 
 OBJECTIVE_SOURCES +=          \
     G3DWidgetOpenGLContext.mm \
+    G3DWidgetInputSampling.mm \
 
 FORMS += \
     MainWindow.ui
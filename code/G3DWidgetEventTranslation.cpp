@@ -0,0 +1,209 @@
+#include "G3DWidgetEventTranslation.hpp"
+
+#include <QtGui/QKeyEvent>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QWheelEvent>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+G3D::uint8 getG3DMouseButtonPressedFlags(Qt::MouseButtons qtMouseButtons) {
+    G3D::uint8 g3dMouseButtonPressedFlags = 0;
+
+    if (qtMouseButtons & Qt::LeftButton)
+        g3dMouseButtonPressedFlags |= 1 << 0;
+    if (qtMouseButtons & Qt::RightButton)
+        g3dMouseButtonPressedFlags |= 1 << 2;
+    if (qtMouseButtons & Qt::MiddleButton)
+        g3dMouseButtonPressedFlags |= 1 << 1;
+    if (qtMouseButtons & Qt::XButton1)
+        g3dMouseButtonPressedFlags |= 1 << 3;
+    if (qtMouseButtons & Qt::XButton2)
+        g3dMouseButtonPressedFlags |= 1 << 4;
+
+    return g3dMouseButtonPressedFlags;
+}
+
+G3D::uint8 getG3DMouseButtonPressedIndex(Qt::MouseButtons qtMouseButtons) {
+    if (qtMouseButtons & Qt::LeftButton)
+        return 0;
+    if (qtMouseButtons & Qt::RightButton)
+        return 2;
+    if (qtMouseButtons & Qt::MiddleButton)
+        return 1;
+    if (qtMouseButtons & Qt::XButton1)
+        return 3;
+    if (qtMouseButtons & Qt::XButton2)
+        return 4;
+
+    MOJO_ASSERT(0 && "No mouse buttons have been pressed.");
+    return 255;
+}
+
+void makeMouseMotionEvent(const QMouseEvent* mouseEvent, const QPoint& previousPosition, qreal devicePixelRatio, G3D::GEvent& e) {
+    e.motion.type  = G3D::GEventType::MOUSE_MOTION;
+    e.motion.which = 0;
+    e.motion.state = getG3DMouseButtonPressedFlags(mouseEvent->buttons());
+    e.motion.x     = mouseEvent->x() * devicePixelRatio;
+    e.motion.y     = mouseEvent->y() * devicePixelRatio;
+    e.motion.xrel  = (mouseEvent->pos() - previousPosition).x() * devicePixelRatio;
+    e.motion.yrel  = (mouseEvent->pos() - previousPosition).y() * devicePixelRatio;
+}
+
+void makeMouseButtonDownEvent(const QMouseEvent* mouseEvent, qreal devicePixelRatio, G3D::GEvent& e) {
+    e.button.type   = G3D::GEventType::MOUSE_BUTTON_DOWN;
+    e.button.which  = 0;
+    e.button.state  = G3D::GButtonState::PRESSED;
+    e.button.x      = mouseEvent->x() * devicePixelRatio;
+    e.button.y      = mouseEvent->y() * devicePixelRatio;
+    e.button.button = getG3DMouseButtonPressedIndex(mouseEvent->buttons());
+}
+
+void makeMouseButtonUpEvent(const QMouseEvent* mouseEvent, Qt::MouseButtons pressedButtons, qreal devicePixelRatio, G3D::GEvent& e) {
+    e.button.type   = G3D::GEventType::MOUSE_BUTTON_UP;
+    e.button.which  = 0;
+    e.button.state  = G3D::GButtonState::RELEASED;
+    e.button.x      = mouseEvent->x() * devicePixelRatio;
+    e.button.y      = mouseEvent->y() * devicePixelRatio;
+    e.button.button = getG3DMouseButtonPressedIndex(pressedButtons);
+}
+
+bool makeMouseScrollEvent(const QWheelEvent* wheelEvent, QPoint& pendingDelta, G3D::GEvent& e) {
+
+    // Qt reports eighths of a degree, and a notch is 15 degrees
+    static const int kNotch = 120;
+
+    pendingDelta += wheelEvent->angleDelta();
+
+    int dx = pendingDelta.x() / kNotch;
+    int dy = pendingDelta.y() / kNotch;
+
+    if (dx == 0 && dy == 0) {
+        return false;
+    }
+
+    pendingDelta -= QPoint(dx, dy) * kNotch;
+
+    e.scroll2d.type  = G3D::GEventType::MOUSE_SCROLL_2D;
+    e.scroll2d.which = 0;
+    e.scroll2d.dx    = dx;
+    e.scroll2d.dy    = dy;
+    return true;
+}
+
+void makeKeyDownEvent(const QKeyEvent* keyEvent, G3D::GEvent& e) {
+    e.key.which = 0; //All keyboard events map to 0 currently
+    e.key.type  = keyEvent->isAutoRepeat() ? G3D::GEventType::KEY_REPEAT : G3D::GEventType::KEY_DOWN;
+    e.key.state = G3D::GButtonState::PRESSED;
+
+    translateKeyEvent(keyEvent, e);
+}
+
+void makeKeyUpEvent(const QKeyEvent* keyEvent, G3D::GEvent& e) {
+    e.key.which = 0; //All keyboard events map to 0 currently
+    e.key.type  = G3D::GEventType::KEY_UP;
+    e.key.state = G3D::GButtonState::RELEASED;
+
+    translateKeyEvent(keyEvent, e);
+}
+
+bool makeCharInputEvent(const QKeyEvent* keyEvent, G3D::GEvent& e) {
+    if (keyEvent->key() < Qt::Key_Exclam || keyEvent->key() > Qt::Key_AsciiTilde) {
+        return false;
+    }
+
+    e.type = G3D::GEventType::CHAR_INPUT;
+
+    if (keyEvent->text().toLatin1().length()) {
+        e.character.unicode = keyEvent->text().toLatin1().at(0);
+    } else {
+        e.character.unicode = 0;
+    }
+
+    return true;
+}
+
+void translateKeyEvent(const QKeyEvent* keyEvent, G3D::GEvent& e) {
+
+    switch(keyEvent->key()) {
+    case Qt::Key_Escape:        e.key.keysym.sym = G3D::GKey::ESCAPE;     break;
+    case Qt::Key_Enter:         e.key.keysym.sym = G3D::GKey::RETURN;     break;
+    case Qt::Key_Return:        e.key.keysym.sym = G3D::GKey::RETURN;     break;
+    case Qt::Key_Tab:           e.key.keysym.sym = G3D::GKey::TAB;        break;
+    case Qt::Key_Backspace:     e.key.keysym.sym = G3D::GKey::BACKSPACE;  break;
+    case Qt::Key_Insert:        e.key.keysym.sym = G3D::GKey::INSERT;     break;
+    case Qt::Key_Delete:        e.key.keysym.sym = G3D::GKey::DELETE;     break;
+    case Qt::Key_Right:         e.key.keysym.sym = G3D::GKey::RIGHT;      break;
+    case Qt::Key_Left:          e.key.keysym.sym = G3D::GKey::LEFT;       break;
+    case Qt::Key_Down:          e.key.keysym.sym = G3D::GKey::DOWN;       break;
+    case Qt::Key_Up:            e.key.keysym.sym = G3D::GKey::UP;         break;
+    case Qt::Key_PageUp:        e.key.keysym.sym = G3D::GKey::PAGEUP;     break;
+    case Qt::Key_PageDown:      e.key.keysym.sym = G3D::GKey::PAGEDOWN;   break;
+    case Qt::Key_Home:          e.key.keysym.sym = G3D::GKey::HOME;       break;
+    case Qt::Key_End:           e.key.keysym.sym = G3D::GKey::END;        break;
+    case Qt::Key_CapsLock:      e.key.keysym.sym = G3D::GKey::CAPSLOCK;   break;
+    case Qt::Key_ScrollLock:    e.key.keysym.sym = G3D::GKey::SCROLLOCK;  break;
+    case Qt::Key_NumLock:       e.key.keysym.sym = G3D::GKey::NUMLOCK;    break;
+    case Qt::Key_Print:         e.key.keysym.sym = G3D::GKey::PRINT;      break;
+    case Qt::Key_Pause:         e.key.keysym.sym = G3D::GKey::PAUSE;      break;
+    case Qt::Key_Shift:         e.key.keysym.sym = G3D::GKey::LSHIFT;     break;
+    case Qt::Key_Control:       e.key.keysym.sym = G3D::GKey::LCTRL;      break;
+    case Qt::Key_Meta:          e.key.keysym.sym = G3D::GKey::LCTRL;      break;
+    case Qt::Key_Alt:           e.key.keysym.sym = G3D::GKey::LALT;       break;
+    case Qt::Key_Super_L:       e.key.keysym.sym = G3D::GKey::LSUPER;     break;
+    case Qt::Key_Super_R:       e.key.keysym.sym = G3D::GKey::RSUPER;     break;
+    case Qt::Key_Menu:          e.key.keysym.sym = G3D::GKey::MENU;       break;
+    default:
+        if(keyEvent->key() >= Qt::Key_A && keyEvent->key() <= Qt::Key_Z) {
+            e.key.keysym.sym = (G3D::GKey::Value)(keyEvent->key() + 'a' - 'A');
+        } else if(keyEvent->key() >= Qt::Key_Exclam && keyEvent->key() <= Qt::Key_AsciiTilde) {
+            e.key.keysym.sym = (G3D::GKey::Value)keyEvent->key();
+        } else if (keyEvent->key() >= Qt::Key_F1 && keyEvent->key() <= Qt::Key_F15) {
+            e.key.keysym.sym = (G3D::GKey::Value)(keyEvent->key() - Qt::Key_F1 + G3D::GKey::F1);
+        } else {
+            MOJO_ASSERT(0 && "Unsupported key.");
+        }
+    }
+
+    if (keyEvent->modifiers() & Qt::KeypadModifier) {
+        switch(keyEvent->key()) {
+        case Qt::Key_Right:         e.key.keysym.sym = G3D::GKey::RIGHT;       break;
+        case Qt::Key_Left:          e.key.keysym.sym = G3D::GKey::LEFT;        break;
+        case Qt::Key_Down:          e.key.keysym.sym = G3D::GKey::DOWN;        break;
+        case Qt::Key_Up:            e.key.keysym.sym = G3D::GKey::UP;          break;
+        case Qt::Key_Period:        e.key.keysym.sym = G3D::GKey::KP_PERIOD;   break;
+        case Qt::Key_Slash:         e.key.keysym.sym = G3D::GKey::KP_DIVIDE;   break;
+        case Qt::Key_Asterisk:      e.key.keysym.sym = G3D::GKey::KP_MULTIPLY; break;
+        case Qt::Key_Minus:         e.key.keysym.sym = G3D::GKey::KP_MINUS;    break;
+        case Qt::Key_Plus:          e.key.keysym.sym = G3D::GKey::KP_PLUS;     break;
+        case Qt::Key_Enter:         e.key.keysym.sym = G3D::GKey::KP_ENTER;    break;
+        case Qt::Key_Equal:         e.key.keysym.sym = G3D::GKey::KP_EQUALS;   break;
+        default:
+            if (keyEvent->key() >= Qt::Key_0 && keyEvent->key() <= Qt::Key_9) {
+                e.key.keysym.sym = (G3D::GKey::Value)((keyEvent->key() - Qt::Key_0) + G3D::GKey::KP0);
+            }
+        }
+    }
+
+    G3D::GKeyMod::Value mod = (G3D::GKeyMod::Value)0;
+    if (keyEvent->modifiers() & Qt::ShiftModifier) {
+        mod = (G3D::GKeyMod::Value)(mod | G3D::GKeyMod::LSHIFT);
+    }
+    if (keyEvent->modifiers() & Qt::ControlModifier) {
+        mod = (G3D::GKeyMod::Value)(mod | G3D::GKeyMod::LCTRL);
+    }
+    if (keyEvent->modifiers() & Qt::AltModifier) {
+        mod = (G3D::GKeyMod::Value)(mod | G3D::GKeyMod::LALT);
+    }
+    e.key.keysym.mod = mod;
+
+    //TODO: Properly set e.key.keysym.unicode
+    e.key.keysym.unicode = keyEvent->key();
+
+    //TODO: Properly set e.key.keysym.scancode
+    e.key.keysym.scancode = keyEvent->key();
+}
+
+}
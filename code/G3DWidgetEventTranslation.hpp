@@ -0,0 +1,51 @@
+#ifndef G3D_WIDGET_EVENT_TRANSLATION_HPP
+#define G3D_WIDGET_EVENT_TRANSLATION_HPP
+
+#include <QtCore/Qt>
+#include <QtCore/QPoint>
+
+#include <GLG3D/GEvent.h>
+
+class QKeyEvent;
+class QMouseEvent;
+class QWheelEvent;
+
+namespace mojo
+{
+
+//
+// Translation of Qt input events into G3D::GEvents. These are free functions that
+// don't touch the G3DWidget, its OpenGL context or the G3D::RenderDevice, so that
+// benchmarks/EventTranslationBenchmark can measure exactly the code that runs for
+// every input event.
+//
+G3D::uint8 getG3DMouseButtonPressedFlags(Qt::MouseButtons qtMouseButtons);
+G3D::uint8 getG3DMouseButtonPressedIndex(Qt::MouseButtons qtMouseButtons);
+
+void makeMouseMotionEvent(const QMouseEvent* mouseEvent, const QPoint& previousPosition, qreal devicePixelRatio, G3D::GEvent& e);
+void makeMouseButtonDownEvent(const QMouseEvent* mouseEvent, qreal devicePixelRatio, G3D::GEvent& e);
+void makeMouseButtonUpEvent(const QMouseEvent* mouseEvent, Qt::MouseButtons pressedButtons, qreal devicePixelRatio, G3D::GEvent& e);
+
+//
+// Adds the wheel event's rotation to pendingDelta, and returns false while it adds
+// up to less than a notch of a mouse wheel. Trackpads report fractions of a notch,
+// which G3D::GEventType::MOUSE_SCROLL_2D events cannot carry.
+//
+bool makeMouseScrollEvent(const QWheelEvent* wheelEvent, QPoint& pendingDelta, G3D::GEvent& e);
+
+void makeKeyDownEvent(const QKeyEvent* keyEvent, G3D::GEvent& e);
+void makeKeyUpEvent(const QKeyEvent* keyEvent, G3D::GEvent& e);
+
+//
+// Returns false if the key doesn't produce a G3D::GEventType::CHAR_INPUT event.
+//
+bool makeCharInputEvent(const QKeyEvent* keyEvent, G3D::GEvent& e);
+
+//
+// Fills in e.key.keysym from the Qt key code and modifiers.
+//
+void translateKeyEvent(const QKeyEvent* keyEvent, G3D::GEvent& e);
+
+}
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef G3D_WIDGET_INPUT_SAMPLING_H
+#define G3D_WIDGET_INPUT_SAMPLING_H
+
+namespace mojo
+{
+
+//
+// Dispatches the mouse, keyboard and tablet events waiting in the native event queue,
+// and nothing else. Unlike QCoreApplication::processEvents(...), it doesn't run the
+// event loop, so no timers, socket notifiers or posted events, e.g., queued slot calls,
+// paint and layout requests, run; they stay queued for the event loop.
+//
+// Events that would start a nested event loop, i.e., a mouse button press outside the
+// content of its window, which can start a window move or resize, and key presses with
+// the command key, which can trigger a menu, are left in the queue, and so is everything
+// behind them.
+//
+void dispatchPendingInputEvents();
+
+}
+
+#endif
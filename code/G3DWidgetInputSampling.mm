@@ -0,0 +1,70 @@
+// needs to be imported before G3D
+#import <Cocoa/Cocoa.h>
+
+#import "G3DWidgetInputSampling.hpp"
+
+#include <QtCore/QEventLoop>
+#include <qpa/qwindowsysteminterface.h>
+
+namespace mojo
+{
+
+//
+// Qt's run loop sources, its timers, socket notifiers and posted events, are not
+// registered for this mode, so fetching events in it only reads the native event queue.
+//
+static NSString* const kInputSamplingRunLoopMode = @"mojo.G3DWidget.inputSampling";
+
+static const NSEventMask kInputEventMask =
+    NSLeftMouseDownMask    | NSLeftMouseUpMask    | NSLeftMouseDraggedMask  |
+    NSRightMouseDownMask   | NSRightMouseUpMask   | NSRightMouseDraggedMask |
+    NSOtherMouseDownMask   | NSOtherMouseUpMask   | NSOtherMouseDraggedMask |
+    NSMouseMovedMask       | NSMouseEnteredMask   | NSMouseExitedMask       |
+    NSScrollWheelMask      | NSKeyDownMask        | NSKeyUpMask             |
+    NSFlagsChangedMask     | NSTabletPointMask    | NSTabletProximityMask;
+
+static bool startsEventLoop(NSEvent* event) {
+    switch ([event type]) {
+    case NSLeftMouseDown:
+    case NSRightMouseDown:
+    case NSOtherMouseDown: {
+        NSWindow* window = [event window];
+        if (window == nil) {
+            return true;
+        }
+
+        NSView* contentView = [window contentView];
+        NSPoint location    = [contentView convertPoint:[event locationInWindow] fromView:nil];
+        return !NSPointInRect(location, [contentView bounds]);
+    }
+
+    case NSKeyDown:
+        return ([event modifierFlags] & NSCommandKeyMask) != 0;
+
+    default:
+        return false;
+    }
+}
+
+void dispatchPendingInputEvents() {
+    @autoreleasepool {
+        for (;;) {
+            NSEvent* event = [NSApp nextEventMatchingMask:kInputEventMask untilDate:[NSDate distantPast] inMode:kInputSamplingRunLoopMode dequeue:YES];
+            if (event == nil) {
+                break;
+            }
+
+            if (startsEventLoop(event)) {
+                [NSApp postEvent:event atStart:YES];
+                break;
+            }
+
+            [NSApp sendEvent:event];
+        }
+    }
+
+    // Qt queues the events it translated, and would send them from its event loop
+    QWindowSystemInterface::sendWindowSystemEvents(QEventLoop::AllEvents);
+}
+
+}
@@ -0,0 +1,159 @@
+#include "G3DWidgetScheduler.hpp"
+
+#include <algorithm>
+
+#include "Assert.hpp"
+#include "G3DWidget.hpp"
+
+namespace mojo
+{
+
+const float G3DWidgetScheduler::kCostSmoothing = 0.2f;
+
+G3DWidgetScheduler::G3DWidgetScheduler(double budgetMilliseconds) :
+    m_budgetMilliseconds(budgetMilliseconds) {
+
+    MOJO_RELEASE_ASSERT(budgetMilliseconds > 0.0);
+}
+
+void G3DWidgetScheduler::add(G3DWidget* g3dWidget, int priority, double targetRate) {
+    MOJO_RELEASE_ASSERT(g3dWidget  != NULL);
+    MOJO_RELEASE_ASSERT(targetRate >= 0.0);
+
+    Entry entry;
+    entry.g3dWidget             = g3dWidget;
+    entry.priority              = priority;
+    entry.targetRate            = targetRate;
+    entry.due                   = Clock::now();
+    entry.estimatedMilliseconds = 0.0f;
+    entry.consecutiveSkips      = 0;
+    entry.skippedFrames         = 0;
+    entry.chosen                = false;
+
+    m_entries.push_back(entry);
+    m_ranking.push_back((int)m_ranking.size());
+}
+
+void G3DWidgetScheduler::setPriority(G3DWidget* g3dWidget, int priority) {
+    entry(g3dWidget).priority = priority;
+}
+
+void G3DWidgetScheduler::setTargetRate(G3DWidget* g3dWidget, double targetRate) {
+    MOJO_RELEASE_ASSERT(targetRate >= 0.0);
+    entry(g3dWidget).targetRate = targetRate;
+}
+
+void G3DWidgetScheduler::setBudgetMilliseconds(double budgetMilliseconds) {
+    MOJO_RELEASE_ASSERT(budgetMilliseconds > 0.0);
+    m_budgetMilliseconds = budgetMilliseconds;
+}
+
+double G3DWidgetScheduler::budgetMilliseconds() const {
+    return m_budgetMilliseconds;
+}
+
+void G3DWidgetScheduler::tick() {
+    Clock::time_point now = Clock::now();
+
+    //
+    // Rank the due G3DWidgets, highest effective priority first, and the most overdue
+    // first among equals. G3DWidgets that aren't due sort last and are never chosen.
+    //
+    int numDue = 0;
+    for (Entry& entry : m_entries) {
+        entry.chosen = false;
+        if (entry.due <= now) {
+            ++numDue;
+        }
+    }
+
+    if (numDue == 0) {
+        return;
+    }
+
+    std::sort(m_ranking.begin(), m_ranking.end(), [this, now](int a, int b) {
+        const Entry& entryA = m_entries[a];
+        const Entry& entryB = m_entries[b];
+
+        bool dueA = entryA.due <= now;
+        bool dueB = entryB.due <= now;
+        if (dueA != dueB) {
+            return dueA;
+        }
+
+        //
+        // G3DWidget::hasFocus() reports whether the window is active, as G3D::OSWindow
+        // expects, which is the same for every G3DWidget in it. QWidget::hasFocus()
+        // tells us which one of them has the keyboard focus.
+        //
+        int priorityA = entryA.priority + entryA.consecutiveSkips + (entryA.g3dWidget->QWidget::hasFocus() ? kFocusPriorityBoost : 0);
+        int priorityB = entryB.priority + entryB.consecutiveSkips + (entryB.g3dWidget->QWidget::hasFocus() ? kFocusPriorityBoost : 0);
+        if (priorityA != priorityB) {
+            return priorityA > priorityB;
+        }
+
+        return entryA.due < entryB.due;
+    });
+
+    float estimatedMilliseconds = 0.0f;
+    for (int i = 0; i < numDue; ++i) {
+        Entry& entry = m_entries[m_ranking[i]];
+
+        if (i == 0 || estimatedMilliseconds + entry.estimatedMilliseconds <= m_budgetMilliseconds) {
+            entry.chosen           = true;
+            estimatedMilliseconds += entry.estimatedMilliseconds;
+        } else {
+            ++entry.consecutiveSkips;
+            ++entry.skippedFrames;
+        }
+    }
+
+    for (Entry& entry : m_entries) {
+        if (!entry.chosen) {
+            continue;
+        }
+
+        entry.g3dWidget->update();
+
+        float milliseconds           = entry.g3dWidget->frameProfiler().lastCPUMilliseconds(FrameProfiler::ZONE_UPDATE);
+        entry.estimatedMilliseconds += kCostSmoothing * (milliseconds - entry.estimatedMilliseconds);
+        entry.consecutiveSkips       = 0;
+
+        //
+        // We schedule the next update one period after this one was due, so the rate
+        // holds on average, but never in the past, so a late G3DWidget doesn't try to
+        // catch up with a burst of updates.
+        //
+        if (entry.targetRate > 0.0) {
+            Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / entry.targetRate));
+            entry.due              = std::max(entry.due + period, now);
+        } else {
+            entry.due = now;
+        }
+    }
+}
+
+std::uint64_t G3DWidgetScheduler::skippedFrames(const G3DWidget* g3dWidget) const {
+    return entry(g3dWidget).skippedFrames;
+}
+
+float G3DWidgetScheduler::estimatedMilliseconds(const G3DWidget* g3dWidget) const {
+    return entry(g3dWidget).estimatedMilliseconds;
+}
+
+G3DWidgetScheduler::Entry& G3DWidgetScheduler::entry(const G3DWidget* g3dWidget) {
+    for (Entry& entry : m_entries) {
+        if (entry.g3dWidget == g3dWidget) {
+            return entry;
+        }
+    }
+
+    MOJO_RELEASE_ASSERT(false);
+    return m_entries.front();
+}
+
+const G3DWidgetScheduler::Entry& G3DWidgetScheduler::entry(const G3DWidget* g3dWidget) const {
+    return const_cast<G3DWidgetScheduler*>(this)->entry(g3dWidget);
+}
+
+}
@@ -0,0 +1,81 @@
+#ifndef G3D_WIDGET_SCHEDULER_HPP
+#define G3D_WIDGET_SCHEDULER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace mojo
+{
+
+class G3DWidget;
+
+//
+// G3DWidgetScheduler decides which G3DWidgets to update on each tick of a shared
+// timer, so that an expensive G3DWidget doesn't make every other one stutter with it.
+// Each G3DWidget has a priority and a target rate, and each tick has a time budget.
+//
+// On every tick, the G3DWidgets whose target rate says they are due are ranked by
+// priority, plus a boost for the G3DWidget with the keyboard focus, plus one for every
+// tick they have been skipped in a row, so low-priority G3DWidgets degrade gracefully
+// rather than starve. We then take them in that order while their estimated costs fit
+// in the budget, and always take at least the first. The estimates are smoothed from
+// the update zone of each G3DWidget's FrameProfiler.
+//
+// The chosen G3DWidgets are updated in the order they were added, so a G3DWidget that
+// renders a view of another one's scene can be added after it.
+//
+class G3DWidgetScheduler
+{
+public:
+    static const int kFocusPriorityBoost = 2;
+
+    G3DWidgetScheduler(double budgetMilliseconds);
+
+    //
+    // A target rate of 0 means every tick.
+    //
+    void add(G3DWidget* g3dWidget, int priority, double targetRate);
+
+    void setPriority(G3DWidget* g3dWidget, int priority);
+    void setTargetRate(G3DWidget* g3dWidget, double targetRate);
+
+    void setBudgetMilliseconds(double budgetMilliseconds);
+    double budgetMilliseconds() const;
+
+    void tick();
+
+    //
+    // The number of ticks on which the G3DWidget was due but didn't fit in the budget.
+    //
+    std::uint64_t skippedFrames(const G3DWidget* g3dWidget) const;
+    float estimatedMilliseconds(const G3DWidget* g3dWidget) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const float kCostSmoothing;
+
+    struct Entry
+    {
+        G3DWidget*        g3dWidget;
+        int               priority;
+        double            targetRate;
+        Clock::time_point due;
+        float             estimatedMilliseconds;
+        int               consecutiveSkips;
+        std::uint64_t     skippedFrames;
+        bool              chosen;
+    };
+
+    Entry& entry(const G3DWidget* g3dWidget);
+    const Entry& entry(const G3DWidget* g3dWidget) const;
+
+    double             m_budgetMilliseconds;
+    std::vector<Entry> m_entries;
+    std::vector<int>   m_ranking;
+};
+
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include "GPUTimer.hpp"
+
+#include <GLG3D/glheaders.h>
+#include <GLG3D/GLCaps.h>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+GPUTimer::GPUTimer(int numZones, int numFramesInFlight) :
+    m_numZones         (numZones),
+    m_numFramesInFlight(numFramesInFlight),
+    m_initialized      (false),
+    m_supported        (false),
+    m_inFrame          (false),
+    m_currentSlot      (0),
+    m_discardedFrames  (0),
+    m_resolvedFrames   (0),
+    m_slots            (numFramesInFlight),
+    m_lastMilliseconds (numZones, 0.0f),
+    m_history          (numZones) {
+
+    MOJO_RELEASE_ASSERT(numZones          > 0);
+    MOJO_RELEASE_ASSERT(numFramesInFlight > 1);
+}
+
+GPUTimer::~GPUTimer() {
+}
+
+void GPUTimer::setResultFunction(const ResultFunction& function) {
+    m_resultFunction = function;
+}
+
+void GPUTimer::initialize() {
+    m_initialized = true;
+    m_supported   = G3D::GLCaps::supports("GL_ARB_timer_query");
+
+    if (!m_supported) {
+        return;
+    }
+
+    for (int i = 0; i < m_numFramesInFlight; ++i) {
+        FrameSlot& slot = m_slots[i];
+        slot.queries.resize(2 * m_numZones);
+        slot.used.assign(m_numZones, false);
+        slot.pending = false;
+        glGenQueries((GLsizei)slot.queries.size(), &slot.queries[0]);
+    }
+}
+
+void GPUTimer::cleanup() {
+    if (m_initialized && m_supported) {
+        for (int i = 0; i < m_numFramesInFlight; ++i) {
+            glDeleteQueries((GLsizei)m_slots[i].queries.size(), &m_slots[i].queries[0]);
+            m_slots[i].queries.clear();
+        }
+    }
+
+    m_initialized = false;
+    m_supported   = false;
+}
+
+void GPUTimer::clearStatistics() {
+    for (int zone = 0; zone < m_numZones; ++zone) {
+        m_lastMilliseconds[zone] = 0.0f;
+        m_history[zone].clear();
+    }
+
+    //
+    // Results still in flight were recorded under the old conditions, so we make
+    // sure they never reach the freshly cleared history.
+    //
+    for (int i = 0; i < m_numFramesInFlight; ++i) {
+        m_slots[i].pending = false;
+    }
+}
+
+void GPUTimer::beginFrame() {
+    MOJO_ASSERT(!m_inFrame);
+
+    if (!m_initialized) {
+        initialize();
+    }
+
+    if (!m_supported) {
+        return;
+    }
+
+    //
+    // Resolve every pending slot whose results are ready, oldest first. Timestamp
+    // queries complete in submission order, so we can stop at the first slot that
+    // is not ready yet.
+    //
+    int nextSlot = (m_currentSlot + 1) % m_numFramesInFlight;
+    for (int i = 0; i < m_numFramesInFlight; ++i) {
+        FrameSlot& slot = m_slots[(nextSlot + i) % m_numFramesInFlight];
+        if (slot.pending && !resolve(slot)) {
+            break;
+        }
+    }
+
+    m_currentSlot = nextSlot;
+
+    FrameSlot& slot = m_slots[m_currentSlot];
+    if (slot.pending) {
+        slot.pending = false;
+        ++m_discardedFrames;
+    }
+
+    slot.used.assign(m_numZones, false);
+    m_inFrame = true;
+}
+
+void GPUTimer::endFrame() {
+    if (!m_supported) {
+        return;
+    }
+
+    MOJO_ASSERT(m_inFrame);
+
+    m_slots[m_currentSlot].pending = true;
+    m_inFrame                      = false;
+}
+
+void GPUTimer::beginZone(int zone) {
+    MOJO_ASSERT(zone >= 0 && zone < m_numZones);
+
+    if (m_supported && m_inFrame) {
+        FrameSlot& slot = m_slots[m_currentSlot];
+        slot.used[zone] = true;
+        glQueryCounter(slot.queries[2 * zone + 0], GL_TIMESTAMP);
+    }
+}
+
+void GPUTimer::endZone(int zone) {
+    MOJO_ASSERT(zone >= 0 && zone < m_numZones);
+
+    if (m_supported && m_inFrame) {
+        FrameSlot& slot = m_slots[m_currentSlot];
+        if (slot.used[zone]) {
+            glQueryCounter(slot.queries[2 * zone + 1], GL_TIMESTAMP);
+        }
+    }
+}
+
+bool GPUTimer::resolve(FrameSlot& slot) {
+
+    //
+    // A slot is ready once the end timestamp of every zone it used is available.
+    // Zones can end in any order, so we check all of them rather than just one.
+    //
+    for (int zone = 0; zone < m_numZones; ++zone) {
+        if (slot.used[zone]) {
+            GLint available = 0;
+            glGetQueryObjectiv(slot.queries[2 * zone + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                return false;
+            }
+        }
+    }
+
+    //
+    // Zones the frame did not use read as 0, so a pass that stopped running doesn't
+    // keep reporting the time it took when it last ran.
+    //
+    for (int zone = 0; zone < m_numZones; ++zone) {
+        m_lastMilliseconds[zone] = 0.0f;
+
+        if (slot.used[zone]) {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(slot.queries[2 * zone + 0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(slot.queries[2 * zone + 1], GL_QUERY_RESULT, &end);
+
+            float milliseconds = (end > begin) ? (float)((end - begin) / 1000000.0) : 0.0f;
+            m_lastMilliseconds[zone] = milliseconds;
+            m_history[zone].push(milliseconds);
+
+            if (m_resultFunction) {
+                m_resultFunction(zone, milliseconds);
+            }
+        }
+    }
+
+    slot.pending = false;
+    ++m_resolvedFrames;
+    return true;
+}
+
+bool GPUTimer::supported() const {
+    return m_supported;
+}
+
+int GPUTimer::numZones() const {
+    return m_numZones;
+}
+
+int GPUTimer::discardedFrames() const {
+    return m_discardedFrames;
+}
+
+int GPUTimer::resolvedFrames() const {
+    return m_resolvedFrames;
+}
+
+float GPUTimer::lastMilliseconds(int zone) const {
+    MOJO_ASSERT(zone >= 0 && zone < m_numZones);
+    return m_lastMilliseconds[zone];
+}
+
+SampleStatistics GPUTimer::statistics(int zone) const {
+    MOJO_ASSERT(zone >= 0 && zone < m_numZones);
+    return m_history[zone].statistics();
+}
+
+}
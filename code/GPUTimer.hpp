@@ -0,0 +1,94 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include <functional>
+#include <vector>
+
+#include "SampleRing.hpp"
+
+namespace mojo
+{
+
+//
+// GPUTimer measures the GPU time spent in a fixed set of zones using GL timestamp
+// queries. Timestamps (rather than GL_TIME_ELAPSED queries) allow zones to nest.
+// Each frame records its queries into one of numFramesInFlight slots, and results
+// are only read back from a slot once GL reports them as available, so reading
+// results never stalls the pipeline. If a slot is still pending when we need to
+// reuse it, its results are discarded rather than waited on.
+//
+// All methods must be called with the OpenGL context current.
+//
+class GPUTimer
+{
+public:
+    static const int kHistorySize = 256;
+
+    typedef std::function<void (int zone, float milliseconds)> ResultFunction;
+
+    GPUTimer(int numZones, int numFramesInFlight);
+    ~GPUTimer();
+
+    //
+    // Called with the time of each zone a frame used as soon as that frame's results
+    // are read back, oldest frame first. statistics(...) only covers the most recent
+    // kHistorySize frames; this lets a caller keep every sample.
+    //
+    void setResultFunction(const ResultFunction& function);
+
+    void cleanup();
+    void clearStatistics();
+
+    void beginFrame();
+    void endFrame();
+
+    void beginZone(int zone);
+    void endZone(int zone);
+
+    bool  supported() const;
+    int   numZones() const;
+    int   discardedFrames() const;
+
+    //
+    // The number of frames whose results have been read back so far. Callers that act
+    // on lastMilliseconds(...) once per frame can compare it against the previous
+    // value, so they don't count the same frame twice while results are in flight.
+    //
+    int   resolvedFrames() const;
+
+    //
+    // The time of zone in the most recently resolved frame, or 0 if that frame did
+    // not use it.
+    //
+    float lastMilliseconds(int zone) const;
+
+    SampleStatistics statistics(int zone) const;
+
+private:
+    struct FrameSlot
+    {
+        std::vector<unsigned int> queries;
+        std::vector<bool>         used;
+        bool                      pending;
+    };
+
+    void initialize();
+    bool resolve(FrameSlot& slot);
+
+    int                                   m_numZones;
+    int                                   m_numFramesInFlight;
+    bool                                  m_initialized;
+    bool                                  m_supported;
+    bool                                  m_inFrame;
+    int                                   m_currentSlot;
+    int                                   m_discardedFrames;
+    int                                   m_resolvedFrames;
+    std::vector<FrameSlot>                m_slots;
+    std::vector<float>                    m_lastMilliseconds;
+    std::vector<SampleRing<kHistorySize>> m_history;
+    ResultFunction                        m_resultFunction;
+};
+
+}
+
+#endif
@@ -0,0 +1,542 @@
+#include "IngestPipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <map>
+#include <utility>
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtGui/QImageReader>
+
+#include <GLG3D/glheaders.h>
+
+#include "Assert.hpp"
+#include "MeshCache.hpp"
+#include "Printf.hpp"
+
+namespace mojo
+{
+
+namespace
+{
+
+const char* const kModelSuffixes[] = { "obj", "ply", "off", "ifs", "3ds", "fbx", "dae", "stl", "bsp", "md2", "md3" };
+
+bool isImage(const QString& path) {
+    return QImageReader::supportedImageFormats().contains(QFileInfo(path).suffix().toLower().toUtf8());
+}
+
+bool isOBJ(const QString& path) {
+    return QFileInfo(path).suffix().toLower() == "obj";
+}
+
+bool isModel(const QString& path) {
+    QString suffix = QFileInfo(path).suffix().toLower();
+
+    for (const char* modelSuffix : kModelSuffixes) {
+        if (suffix == modelSuffix) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+// Uploads rows [firstRow, firstRow + rows) of an RGBA8888 image into the texture.
+// G3D::RenderDevice tracks the GL state it sets, so we restore what we change.
+//
+void uploadRows(const G3D::Texture& texture, const QImage& image, int firstRow, int rows) {
+    GLint pixelBuffer, boundTexture, alignment, rowLength;
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &pixelBuffer);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D,          &boundTexture);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT,            &alignment);
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH,           &rowLength);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, texture.openGLID());
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, image.width(), rows, GL_RGBA, GL_UNSIGNED_BYTE, image.constScanLine(firstRow));
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  alignment);
+    glBindTexture(GL_TEXTURE_2D, boundTexture);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+}
+
+}
+
+IngestJob::IngestJob(const QString& path, Type type, QObject* target, const QPoint& position) :
+    m_path          (path),
+    m_type          (type),
+    m_target        (target),
+    m_position      (position),
+    m_state         (STATE_QUEUED),
+    m_progress      (0.0f),
+    m_cancelled     (false),
+    m_uploadedRows  (0),
+    m_parsed        (false),
+    m_uploadedMeshes(0) {
+}
+
+const QString& IngestJob::path() const {
+    return m_path;
+}
+
+IngestJob::Type IngestJob::type() const {
+    return m_type;
+}
+
+QObject* IngestJob::target() const {
+    return m_target;
+}
+
+const QPoint& IngestJob::position() const {
+    return m_position;
+}
+
+IngestJob::State IngestJob::state() const {
+    return (State)m_state.load(std::memory_order_acquire);
+}
+
+float IngestJob::progress() const {
+    return m_progress.load(std::memory_order_relaxed);
+}
+
+void IngestJob::cancel() {
+    m_cancelled = true;
+}
+
+bool IngestJob::cancelled() const {
+    return m_cancelled;
+}
+
+QString IngestJob::error() const {
+    return state() == STATE_FAILED ? m_error : QString();
+}
+
+std::shared_ptr<G3D::Texture> IngestJob::texture() const {
+    return state() == STATE_DONE ? m_texture : std::shared_ptr<G3D::Texture>();
+}
+
+std::shared_ptr<G3D::ArticulatedModel> IngestJob::model() const {
+    return state() == STATE_DONE ? m_model : std::shared_ptr<G3D::ArticulatedModel>();
+}
+
+IngestPipeline::IngestPipeline(int numWorkers, QObject* parent) :
+    QObject  (parent),
+    m_running(true) {
+
+    MOJO_RELEASE_ASSERT(numWorkers > 0);
+
+    qRegisterMetaType<std::shared_ptr<mojo::IngestJob> >();
+
+    for (int i = 0; i < numWorkers; ++i) {
+        m_workers.push_back(std::thread(&IngestPipeline::run, this));
+    }
+}
+
+IngestPipeline::~IngestPipeline() {
+    cancelAll();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    m_workAvailable.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void IngestPipeline::setMeshCache(const std::shared_ptr<MeshCache>& meshCache) {
+    m_meshCache = meshCache;
+}
+
+bool IngestPipeline::canIngest(const QString& path) {
+    return isImage(path) || isModel(path);
+}
+
+std::shared_ptr<IngestJob> IngestPipeline::enqueue(const QString& path, QObject* target, const QPoint& position) {
+    MOJO_RELEASE_ASSERT(canIngest(path));
+
+    std::shared_ptr<IngestJob> job = std::make_shared<IngestJob>(path, isImage(path) ? IngestJob::TYPE_TEXTURE : IngestJob::TYPE_MODEL, target, position);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_decodeQueue.push_back(job);
+        m_jobs.push_back(job);
+    }
+
+    m_workAvailable.notify_one();
+    return job;
+}
+
+void IngestPipeline::cancelAll() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (const std::shared_ptr<IngestJob>& job : m_jobs) {
+        job->cancel();
+    }
+}
+
+int IngestPipeline::pendingJobs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (int)m_jobs.size();
+}
+
+void IngestPipeline::uploadSlices(double budgetMilliseconds) {
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point begin = Clock::now();
+
+    //
+    // We always do at least one slice, so uploads make progress however small the
+    // budget, and stop as soon as the budget is used up. A slice is kRowsPerSlice rows
+    // of an image, one mesh of an OBJ model, or all of another model.
+    //
+    do {
+        std::shared_ptr<IngestJob> job;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_uploadQueue.empty()) {
+                return;
+            }
+            job = m_uploadQueue.front();
+        }
+
+        if (job->cancelled()) {
+            finish(job, IngestJob::STATE_CANCELLED);
+        } else if (job->state() == IngestJob::STATE_FAILED) {
+            finish(job, IngestJob::STATE_FAILED);
+        } else if (uploadSlice(*job)) {
+            finish(job, job->m_error.isEmpty() ? IngestJob::STATE_DONE : IngestJob::STATE_FAILED);
+        }
+    } while (std::chrono::duration<double, std::milli>(Clock::now() - begin).count() < budgetMilliseconds);
+}
+
+void IngestPipeline::discardUploads() {
+    for (;;) {
+        std::shared_ptr<IngestJob> job;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_uploadQueue.empty()) {
+                return;
+            }
+            job = m_uploadQueue.front();
+        }
+
+        finish(job, IngestJob::STATE_CANCELLED);
+    }
+}
+
+void IngestPipeline::run() {
+    for (;;) {
+        std::shared_ptr<IngestJob> job;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workAvailable.wait(lock, [this] { return !m_running || !m_decodeQueue.empty(); });
+
+            if (!m_running) {
+                return;
+            }
+
+            job = m_decodeQueue.front();
+            m_decodeQueue.pop_front();
+        }
+
+        if (!job->cancelled()) {
+            job->m_state = IngestJob::STATE_DECODING;
+            decode(*job);
+        }
+
+        if (job->m_error.isEmpty() && !job->cancelled()) {
+            job->m_state = IngestJob::STATE_UPLOADING;
+        } else if (!job->m_error.isEmpty()) {
+            job->m_state = IngestJob::STATE_FAILED;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uploadQueue.push_back(job);
+    }
+}
+
+void IngestPipeline::decode(IngestJob& job) {
+    QFile file(job.m_path);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        job.m_error = file.errorString();
+        return;
+    }
+
+    qint64 size    = file.size();
+    uchar* mapping = file.map(0, size);
+
+    if (mapping == NULL) {
+        job.m_error = file.errorString();
+        return;
+    }
+
+    if (job.m_type == IngestJob::TYPE_TEXTURE) {
+        // QImage can neither read nor hold more than INT_MAX bytes
+        if (size > INT_MAX) {
+            job.m_error = "Image is too large";
+        } else if (!job.m_image.loadFromData(mapping, (int)size)) {
+            job.m_error = "Cannot decode image";
+        } else {
+            job.m_image = job.m_image.convertToFormat(QImage::Format_RGBA8888);
+        }
+    } else if (isOBJ(job.m_path)) {
+        parseModel(job, mapping, size);
+    } else {
+
+        //
+        // Touch every page, so that the file is in memory by the time G3D opens it on
+        // the render thread.
+        //
+        static const qint64 kPageSize = 4096;
+
+        volatile uchar sum = 0;
+        for (qint64 offset = 0; offset < size && !job.cancelled(); offset += kPageSize) {
+            sum += mapping[offset];
+
+            if ((offset / kPageSize) % 256 == 0) {
+                job.m_progress = 0.5f * offset / size;
+            }
+        }
+    }
+
+    file.unmap(mapping);
+    job.m_progress = 0.5f;
+}
+
+void IngestPipeline::parseModel(IngestJob& job, const uchar* data, qint64 size) {
+    std::string path  = job.m_path.toUtf8().constData();
+    std::string error;
+
+    auto progress = [&job](float fraction) {
+        job.m_progress = 0.5f * fraction;
+        return !job.cancelled();
+    };
+
+    bool parsed = m_meshCache ?
+        m_meshCache->createMeshes(path, (const char*)data, (std::size_t)size, job.m_meshes, error, progress) :
+        parseOBJ((const char*)data, (std::size_t)size, path, job.m_meshes, error, progress);
+
+    if (!parsed) {
+        job.m_error = QString::fromStdString(error);
+        return;
+    }
+
+    // uploadModelSlice(...) adds at least one mesh, which a damaged cache entry may not have
+    if (job.m_meshes.empty()) {
+        job.m_error = "Model has no faces";
+        return;
+    }
+
+    //
+    // Meshes that use the same material share it. Diffuse maps are decoded here, like
+    // dropped images, and materials without one keep their diffuse color.
+    //
+    std::map<const G3D::ParseMTL::Material*, int> materialIndices;
+
+    for (const FlatMesh& mesh : job.m_meshes) {
+        const G3D::ParseMTL::Material* material = mesh.material.get();
+
+        std::map<const G3D::ParseMTL::Material*, int>::const_iterator found = materialIndices.find(material);
+        if (found != materialIndices.end()) {
+            job.m_meshMaterials.push_back(found->second);
+            continue;
+        }
+
+        IngestJob::DecodedMaterial decoded;
+        decoded.diffuse      = material ? material->Kd : G3D::Color3(0.8f, 0.8f, 0.8f);
+        decoded.uploadedRows = 0;
+
+        if (material && !material->map_Kd.empty()) {
+            G3D::String filename = G3D::FilePath::concat(material->basePath, material->map_Kd);
+            decoded.image        = QImage(QString::fromUtf8(filename.c_str()));
+
+            if (decoded.image.isNull()) {
+                mojo::printf("Cannot decode ", filename.c_str(), ", using its material's diffuse color instead");
+            } else {
+                decoded.image = decoded.image.convertToFormat(QImage::Format_RGBA8888);
+            }
+        }
+
+        int index = (int)job.m_materials.size();
+        job.m_materials.push_back(std::move(decoded));
+        job.m_meshMaterials.push_back(index);
+        materialIndices[material] = index;
+    }
+
+    job.m_parsed = true;
+}
+
+bool IngestPipeline::uploadModelSlice(IngestJob& job) {
+
+    //
+    // The diffuse maps go first, kRowsPerSlice rows at a time, then one mesh per slice,
+    // including its geometry's upload to the GPU.
+    //
+    for (IngestJob::DecodedMaterial& material : job.m_materials) {
+        if (material.image.isNull()) {
+            continue;
+        }
+
+        if (!material.texture) {
+            material.texture = G3D::Texture::createEmpty(
+                job.m_path.toUtf8().constData(),
+                material.image.width(),
+                material.image.height(),
+                G3D::ImageFormat::RGBA8(),
+                G3D::Texture::DIM_2D,
+                false);
+        }
+
+        int rows = std::min(kRowsPerSlice, material.image.height() - material.uploadedRows);
+        uploadRows(*material.texture, material.image, material.uploadedRows, rows);
+
+        material.uploadedRows += rows;
+        if (material.uploadedRows == material.image.height()) {
+            material.image = QImage();
+        }
+
+        return false;
+    }
+
+    if (!job.m_model) {
+        job.m_model = G3D::ArticulatedModel::createEmpty(QFileInfo(job.m_path).baseName().toUtf8().constData());
+        job.m_model->addPart("root");
+    }
+
+    int                         numMeshes = (int)job.m_meshes.size();
+    FlatMesh&                   decoded   = job.m_meshes[job.m_uploadedMeshes];
+    IngestJob::DecodedMaterial& material  = job.m_materials[job.m_meshMaterials[job.m_uploadedMeshes]];
+
+    if (!material.material) {
+        material.material = material.texture ? G3D::UniversalMaterial::createDiffuse(material.texture) : G3D::UniversalMaterial::createDiffuse(material.diffuse);
+    }
+
+    G3D::ArticulatedModel::Geometry* geometry       = job.m_model->addGeometry(decoded.name);
+    G3D::CPUVertexArray&             cpuVertexArray = geometry->cpuVertexArray;
+    cpuVertexArray.hasTangent   = true;
+    cpuVertexArray.hasTexCoord0 = decoded.hasTexCoord0;
+    cpuVertexArray.vertex.resize((int)decoded.vertices.size());
+    std::copy(decoded.vertices.begin(), decoded.vertices.end(), cpuVertexArray.vertex.getCArray());
+
+    G3D::ArticulatedModel::Mesh* mesh = job.m_model->addMesh(decoded.name, job.m_model->rootArray()[0], geometry);
+    mesh->primitive = G3D::PrimitiveType::TRIANGLES;
+    mesh->material  = material.material;
+    mesh->cpuIndexArray.resize((int)decoded.indices.size());
+    std::memcpy(mesh->cpuIndexArray.getCArray(), &decoded.indices[0], decoded.indices.size() * sizeof(int));
+
+    //
+    // The normals and tangents were computed on the worker, and its vertices merged,
+    // so all G3D::ArticulatedModel::cleanGeometry(...) would have left to do is the
+    // bounds and the GPU arrays. It does them for every mesh at once, in one slice
+    // however large the model, so we do them for this mesh alone.
+    //
+    mesh->computeBounds(cpuVertexArray);
+    geometry->computeBounds(G3D::Array<G3D::ArticulatedModel::Mesh*>(mesh));
+    geometry->copyToGPU();
+    mesh->copyToGPU();
+
+    // the model has its own copy now
+    std::vector<G3D::CPUVertexArray::Vertex>().swap(decoded.vertices);
+    std::vector<int>().swap(decoded.indices);
+
+    ++job.m_uploadedMeshes;
+    job.m_progress = 0.5f + 0.5f * job.m_uploadedMeshes / numMeshes;
+
+    if (job.m_uploadedMeshes < numMeshes) {
+        return false;
+    }
+
+    job.m_materials.clear();
+    job.m_meshes.clear();
+    job.m_meshMaterials.clear();
+    return true;
+}
+
+bool IngestPipeline::uploadSlice(IngestJob& job) {
+    if (job.m_type == IngestJob::TYPE_MODEL && job.m_parsed) {
+        return uploadModelSlice(job);
+    }
+
+    if (job.m_type == IngestJob::TYPE_MODEL) {
+        G3D::ArticulatedModel::Specification specification;
+        specification.filename = job.m_path.toUtf8().constData();
+
+        try {
+            job.m_model = G3D::ArticulatedModel::create(specification);
+        } catch (...) {
+            job.m_error = "Cannot load model";
+        }
+
+        return true;
+    }
+
+    const QImage& image = job.m_image;
+
+    if (!job.m_texture) {
+        job.m_texture = G3D::Texture::createEmpty(
+            job.m_path.toUtf8().constData(),
+            image.width(),
+            image.height(),
+            G3D::ImageFormat::RGBA8(),
+            G3D::Texture::DIM_2D,
+            false);
+    }
+
+    int rows = std::min(kRowsPerSlice, image.height() - job.m_uploadedRows);
+    uploadRows(*job.m_texture, image, job.m_uploadedRows, rows);
+
+    job.m_uploadedRows += rows;
+    job.m_progress      = 0.5f + 0.5f * job.m_uploadedRows / image.height();
+
+    if (job.m_uploadedRows < image.height()) {
+        return false;
+    }
+
+    job.m_image = QImage();
+    return true;
+}
+
+void IngestPipeline::finish(const std::shared_ptr<IngestJob>& job, IngestJob::State state) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uploadQueue.pop_front();
+        m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), job));
+    }
+
+    if (state != IngestJob::STATE_DONE) {
+        job->m_texture.reset();
+        job->m_model.reset();
+        job->m_image = QImage();
+        job->m_materials.clear();
+        job->m_meshes.clear();
+        job->m_meshMaterials.clear();
+    }
+
+    job->m_progress = 1.0f;
+    job->m_state    = state;
+
+    if (state == IngestJob::STATE_FAILED) {
+        mojo::printf("Cannot ingest ", job->m_path.toUtf8().constData(), ": ", job->m_error.toUtf8().constData());
+    }
+
+    emit jobFinished(job);
+}
+
+}
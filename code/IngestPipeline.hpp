@@ -0,0 +1,196 @@
+#ifndef INGEST_PIPELINE_HPP
+#define INGEST_PIPELINE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QtCore/QObject>
+#include <QtCore/QPoint>
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+#include <G3D/G3D.h>
+#include <GLG3D/GLG3D.h>
+
+#include "FlatMesh.hpp"
+
+namespace mojo
+{
+
+class MeshCache;
+
+//
+// The state of one file going through an IngestPipeline. All accessors can be called
+// from any thread; texture() and model() are only set once the job is STATE_DONE.
+//
+class IngestJob
+{
+public:
+    enum Type
+    {
+        TYPE_TEXTURE,
+        TYPE_MODEL
+    };
+
+    enum State
+    {
+        STATE_QUEUED,
+        STATE_DECODING,
+        STATE_UPLOADING,
+        STATE_DONE,
+        STATE_FAILED,
+        STATE_CANCELLED
+    };
+
+    IngestJob(const QString& path, Type type, QObject* target, const QPoint& position);
+
+    const QString& path() const;
+    Type type() const;
+    State state() const;
+
+    //
+    // Where the file was dropped, e.g., a G3DWidget, and the position on it in pixels,
+    // so the result can be placed there when the job is done.
+    //
+    QObject* target() const;
+    const QPoint& position() const;
+
+    //
+    // From 0 to 1. Decoding on a worker thread covers the first half, uploading on the
+    // render thread the second half.
+    //
+    float progress() const;
+
+    //
+    // Stops the job at its next step. A cancelled job is still reported by
+    // IngestPipeline::jobFinished(...), with STATE_CANCELLED.
+    //
+    void cancel();
+    bool cancelled() const;
+
+    QString error() const;
+
+    std::shared_ptr<G3D::Texture>          texture() const;
+    std::shared_ptr<G3D::ArticulatedModel> model() const;
+
+private:
+    friend class IngestPipeline;
+
+    //
+    // A material of a model parsed on a worker thread, with its diffuse map decoded.
+    // The render thread uploads the map and creates the G3D::UniversalMaterial.
+    //
+    struct DecodedMaterial
+    {
+        G3D::Color3                             diffuse;
+        QImage                                  image;
+        int                                     uploadedRows;
+        std::shared_ptr<G3D::Texture>           texture;
+        std::shared_ptr<G3D::UniversalMaterial> material;
+    };
+
+    QString                                m_path;
+    Type                                   m_type;
+    QObject*                               m_target;
+    QPoint                                 m_position;
+    std::atomic<int>                       m_state;
+    std::atomic<float>                     m_progress;
+    std::atomic<bool>                      m_cancelled;
+
+    // written by the thread that owns the current state, read after it has changed
+    QString                                m_error;
+    QImage                                 m_image;
+    int                                    m_uploadedRows;
+    bool                                   m_parsed;
+    std::vector<DecodedMaterial>           m_materials;
+    std::vector<FlatMesh>                  m_meshes;
+    std::vector<int>                       m_meshMaterials;
+    int                                    m_uploadedMeshes;
+    std::shared_ptr<G3D::Texture>          m_texture;
+    std::shared_ptr<G3D::ArticulatedModel> m_model;
+};
+
+//
+// Loads dropped files without stalling the render thread. Worker threads memory map
+// each file and decode it; the render thread then only uploads the decoded data to
+// the GPU, in slices, for at most a given budget per frame (uploadSlices(...)). When
+// a job is done, failed or was cancelled, jobFinished(...) is emitted from the render
+// thread with the job, which carries the ready G3D::Texture or G3D::ArticulatedModel.
+//
+// Images are decoded completely on the workers. OBJ models are parsed on the workers
+// with parseOBJ(...) into flat vertex and index arrays, or read from the MeshCache if
+// one was set, and their diffuse maps are decoded there too; the render thread
+// uploads the maps a slice at a time, then adds one mesh per slice to the
+// G3D::ArticulatedModel and uploads its geometry.
+//
+// Other model formats can only be read by G3D::ArticulatedModel::create(...), which
+// needs the OpenGL context for their materials, so for those the workers just read
+// the file into the page cache, and create(...) runs as a single upload step.
+//
+class IngestPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    IngestPipeline(int numWorkers = 2, QObject* parent = 0);
+    virtual ~IngestPipeline();
+
+    //
+    // OBJ models are looked up in, and added to, the cache. Call before enqueue(...).
+    //
+    void setMeshCache(const std::shared_ptr<MeshCache>& meshCache);
+
+    static bool canIngest(const QString& path);
+
+    std::shared_ptr<IngestJob> enqueue(const QString& path, QObject* target = NULL, const QPoint& position = QPoint());
+
+    void cancelAll();
+
+    //
+    // Called on the render thread, with the OpenGL context current, once per frame.
+    //
+    void uploadSlices(double budgetMilliseconds);
+
+    //
+    // Finishes every job that is waiting to be uploaded as cancelled, releasing the
+    // OpenGL resources of those that were partly uploaded. Called on the render
+    // thread, with the OpenGL context current, before G3D::RenderDevice::cleanup().
+    // Jobs that are still decoding hold no OpenGL resources.
+    //
+    void discardUploads();
+
+    int pendingJobs() const;
+
+signals:
+    void jobFinished(std::shared_ptr<mojo::IngestJob> job);
+
+private:
+    static const int kRowsPerSlice = 64;
+
+    void run();
+    void decode(IngestJob& job);
+    void parseModel(IngestJob& job, const uchar* data, qint64 size);
+    bool uploadSlice(IngestJob& job);
+    bool uploadModelSlice(IngestJob& job);
+    void finish(const std::shared_ptr<IngestJob>& job, IngestJob::State state);
+
+    std::vector<std::thread>                m_workers;
+    mutable std::mutex                      m_mutex;
+    std::condition_variable                 m_workAvailable;
+    std::deque<std::shared_ptr<IngestJob> > m_decodeQueue;
+    std::deque<std::shared_ptr<IngestJob> > m_uploadQueue;
+    std::vector<std::shared_ptr<IngestJob> > m_jobs;
+    bool                                    m_running;
+    std::shared_ptr<MeshCache>              m_meshCache;
+};
+
+}
+
+Q_DECLARE_METATYPE(std::shared_ptr<mojo::IngestJob>)
+
+#endif
@@ -0,0 +1,190 @@
+#include "InputLatencyTracker.hpp"
+
+#include <GLG3D/GApp.h>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+InputLatencyTracker::FrameInputs::FrameInputs() {
+    clear();
+}
+
+void InputLatencyTracker::FrameInputs::clear() {
+    for (int i = 0; i < INPUT_TYPE_COUNT; ++i) {
+        consumed[i] = false;
+    }
+
+    frame = 0;
+}
+
+void InputLatencyTracker::FrameInputs::merge(const FrameInputs& inputs) {
+    for (int i = 0; i < INPUT_TYPE_COUNT; ++i) {
+        if (inputs.consumed[i] && (!consumed[i] || inputs.oldestReceived[i] < oldestReceived[i])) {
+            consumed[i]       = true;
+            oldestReceived[i] = inputs.oldestReceived[i];
+        }
+    }
+}
+
+InputLatencyTracker::InputLatencyTracker() :
+    m_pendingBegin(0),
+    m_pendingCount(0) {
+
+    for (int i = 0; i < INPUT_TYPE_COUNT; ++i) {
+        m_inputCounts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void InputLatencyTracker::inputReceived(InputType type, unsigned long qtTimestamp) {
+    MOJO_ASSERT(type >= 0 && type < INPUT_TYPE_COUNT);
+
+    Clock::time_point received = Clock::now();
+
+    if (!m_received.consumed[type]) {
+        m_received.consumed[type]       = true;
+        m_received.oldestReceived[type] = received;
+    }
+
+    m_inputCounts[type].fetch_add(1, std::memory_order_relaxed);
+
+    // events we synthesize ourselves, e.g., for a TrainingWorkload, have no timestamp
+    if (qtTimestamp == 0) {
+        return;
+    }
+
+    //
+    // The unsigned difference wraps like X11 timestamps do, and a timestamp from the
+    // future, i.e., from another clock, comes out implausibly large.
+    //
+    std::uint32_t receivedMilliseconds = (std::uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(received.time_since_epoch()).count();
+    std::uint32_t dispatchMilliseconds = receivedMilliseconds - (std::uint32_t)qtTimestamp;
+
+    if (dispatchMilliseconds <= kMaxDispatchMilliseconds) {
+        m_history[type][STAGE_DISPATCH].push((float)dispatchMilliseconds);
+    }
+}
+
+void InputLatencyTracker::frameStarted() {
+
+    // inputs of a frame that never swapped are consumed by this one
+    m_consumed.merge(m_received);
+    m_received.clear();
+}
+
+void InputLatencyTracker::frameSwapped(std::uint64_t frame) {
+    Clock::time_point swapped = Clock::now();
+
+    for (int i = 0; i < INPUT_TYPE_COUNT; ++i) {
+        if (m_consumed.consumed[i]) {
+            push((InputType)i, STAGE_SWAP, swapped - m_consumed.oldestReceived[i]);
+        }
+    }
+
+    //
+    // If more frames are pending than can be in flight, fences were lost, e.g.,
+    // because the context was cleaned up, and we forget the oldest frame.
+    //
+    if (m_pendingCount == kMaxPendingFrames) {
+        m_pendingBegin = (m_pendingBegin + 1) % kMaxPendingFrames;
+        --m_pendingCount;
+    }
+
+    FrameInputs& pending = m_pending[(m_pendingBegin + m_pendingCount) % kMaxPendingFrames];
+    pending       = m_consumed;
+    pending.frame = frame;
+    ++m_pendingCount;
+
+    m_consumed.clear();
+}
+
+void InputLatencyTracker::framesCompleted(std::uint64_t completedFrames) {
+    Clock::time_point completed = Clock::now();
+
+    while (m_pendingCount > 0 && m_pending[m_pendingBegin].frame <= completedFrames) {
+        const FrameInputs& pending = m_pending[m_pendingBegin];
+
+        for (int i = 0; i < INPUT_TYPE_COUNT; ++i) {
+            if (pending.consumed[i]) {
+                push((InputType)i, STAGE_PRESENT, completed - pending.oldestReceived[i]);
+            }
+        }
+
+        m_pendingBegin = (m_pendingBegin + 1) % kMaxPendingFrames;
+        --m_pendingCount;
+    }
+}
+
+void InputLatencyTracker::clearStatistics() {
+    for (int type = 0; type < INPUT_TYPE_COUNT; ++type) {
+        m_inputCounts[type].store(0, std::memory_order_relaxed);
+
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+            m_history[type][stage].clear();
+        }
+    }
+}
+
+std::uint64_t InputLatencyTracker::inputCount(InputType type) const {
+    MOJO_ASSERT(type >= 0 && type < INPUT_TYPE_COUNT);
+    return m_inputCounts[type].load(std::memory_order_relaxed);
+}
+
+SampleStatistics InputLatencyTracker::statistics(InputType type, Stage stage) const {
+    MOJO_ASSERT(type  >= 0 && type  < INPUT_TYPE_COUNT);
+    MOJO_ASSERT(stage >= 0 && stage < STAGE_COUNT);
+    return m_history[type][stage].statistics();
+}
+
+void InputLatencyTracker::drawOverlay() const {
+
+    // see FrameProfiler::drawOverlay(...)
+    if (G3D::GApp::current() == NULL) {
+        return;
+    }
+
+    G3D::screenPrintf("input latency (ms)       dispatch p50   p99    swap p50   p99    present p50   p99   max");
+
+    for (int i = 0; i < INPUT_TYPE_COUNT; ++i) {
+        InputType        type     = (InputType)i;
+        SampleStatistics dispatch = statistics(type, STAGE_DISPATCH);
+        SampleStatistics swap     = statistics(type, STAGE_SWAP);
+        SampleStatistics present  = statistics(type, STAGE_PRESENT);
+
+        if (present.count == 0 && swap.count == 0) {
+            continue;
+        }
+
+        G3D::screenPrintf("  %-16s             %5.2f %5.2f       %5.2f %5.2f          %5.2f %5.2f %5.2f",
+            inputTypeName(type),
+            dispatch.p50, dispatch.p99,
+            swap.p50, swap.p99,
+            present.p50, present.p99, present.max);
+    }
+}
+
+const char* InputLatencyTracker::inputTypeName(InputType type) {
+    switch(type) {
+    case INPUT_MOUSE_MOTION: return "mouseMotion";
+    case INPUT_MOUSE_BUTTON: return "mouseButton";
+    case INPUT_MOUSE_WHEEL:  return "mouseWheel";
+    case INPUT_KEY:          return "key";
+    default:                 return "unknown";
+    }
+}
+
+const char* InputLatencyTracker::stageName(Stage stage) {
+    switch(stage) {
+    case STAGE_DISPATCH: return "dispatch";
+    case STAGE_SWAP:     return "swap";
+    case STAGE_PRESENT:  return "present";
+    default:             return "unknown";
+    }
+}
+
+void InputLatencyTracker::push(InputType type, Stage stage, Clock::duration duration) {
+    m_history[type][stage].push(std::chrono::duration<float, std::milli>(duration).count());
+}
+
+}
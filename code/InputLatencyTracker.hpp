@@ -0,0 +1,114 @@
+#ifndef INPUT_LATENCY_TRACKER_HPP
+#define INPUT_LATENCY_TRACKER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "SampleRing.hpp"
+#include "FrameLatencyLimiter.hpp"
+
+namespace mojo
+{
+
+//
+// InputLatencyTracker measures how old the input a frame consumed is by the time the
+// frame is presented. A G3DWidget reports every input event it fires, with the Qt
+// event timestamp, and the tracker stamps it with a monotonic receive time. Inputs
+// received before a frame starts are consumed by that frame. For each frame and input
+// type, we follow the oldest input it consumed through the frame's swap and the GL
+// fence that signals after the swap (see FrameLatencyLimiter.hpp).
+//
+// The stages are measured from the receive time:
+//
+//   STAGE_DISPATCH  from the Qt event timestamp to the receive time
+//   STAGE_SWAP      from the receive time to the return of swapGLBuffers()
+//   STAGE_PRESENT   from the receive time to when we saw the fence signal
+//
+// Qt timestamps input events in milliseconds on the clock of the window system,
+// which on macOS and on Linux is the monotonic clock std::chrono::steady_clock reads,
+// truncated to 32 bits on X11. So STAGE_DISPATCH is the difference of the two, modulo
+// 2^32 milliseconds. An event whose difference is negative or implausibly large came
+// from another clock, e.g., a synthesized event, and gets no STAGE_DISPATCH sample
+// rather than a meaningless one. We see the fence signal when we poll it at the start
+// of a later frame, so STAGE_PRESENT is an upper bound, which is tight when the frame
+// waited for a frame slot.
+//
+// All methods except the statistics accessors must be called on the thread of the
+// G3DWidget. The statistics are kept in lock-free rings and can be read from any
+// thread.
+//
+class InputLatencyTracker
+{
+public:
+    enum InputType
+    {
+        INPUT_MOUSE_MOTION,
+        INPUT_MOUSE_BUTTON,
+        INPUT_MOUSE_WHEEL,
+        INPUT_KEY,
+        INPUT_TYPE_COUNT
+    };
+
+    enum Stage
+    {
+        STAGE_DISPATCH,
+        STAGE_SWAP,
+        STAGE_PRESENT,
+        STAGE_COUNT
+    };
+
+    static const int kHistorySize = 256;
+
+    // a dispatch takes longer than this only if the timestamp is on another clock
+    static const std::uint32_t kMaxDispatchMilliseconds = 10000;
+
+    InputLatencyTracker();
+
+    void inputReceived(InputType type, unsigned long qtTimestamp);
+
+    void frameStarted();
+    void frameSwapped(std::uint64_t frame);
+    void framesCompleted(std::uint64_t completedFrames);
+
+    void clearStatistics();
+
+    std::uint64_t inputCount(InputType type) const;
+    SampleStatistics statistics(InputType type, Stage stage) const;
+
+    void drawOverlay() const;
+
+    static const char* inputTypeName(InputType type);
+    static const char* stageName(Stage stage);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct FrameInputs
+    {
+        FrameInputs();
+        void clear();
+        void merge(const FrameInputs& inputs);
+
+        bool              consumed[INPUT_TYPE_COUNT];
+        Clock::time_point oldestReceived[INPUT_TYPE_COUNT];
+        std::uint64_t     frame;
+    };
+
+    // a completed frame is one whose fence signaled, so we can't have more pending
+    static const int kMaxPendingFrames = FrameLatencyLimiter::kMaxFramesInFlightCap + 1;
+
+    void push(InputType type, Stage stage, Clock::duration duration);
+
+    FrameInputs                m_received;
+    FrameInputs                m_consumed;
+    FrameInputs                m_pending[kMaxPendingFrames];
+    int                        m_pendingBegin;
+    int                        m_pendingCount;
+    std::atomic<std::uint64_t> m_inputCounts[INPUT_TYPE_COUNT];
+    SampleRing<kHistorySize>   m_history[INPUT_TYPE_COUNT][STAGE_COUNT];
+};
+
+}
+
+#endif
@@ -0,0 +1,378 @@
+#include "Log.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <signal.h>
+
+namespace mojo
+{
+
+namespace
+{
+
+//
+// A single-producer single-consumer byte ring. The owning thread is the only writer
+// and whoever holds the drain lock is the only reader. A line is published with a
+// single release store of m_head after it has been copied in completely, so readers
+// only ever see whole lines and lines from different threads never interleave.
+//
+class LogRing
+{
+public:
+    static const std::size_t kCapacity = 64 * 1024;
+
+    LogRing() :
+        m_head(0),
+        m_tail(0),
+        m_next(NULL) {
+    }
+
+    bool tryWrite(const char* data, std::size_t size) {
+        std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        std::uint64_t tail = m_tail.load(std::memory_order_acquire);
+
+        if (kCapacity - (std::size_t)(head - tail) < size + 1) {
+            return false;
+        }
+
+        copyIn(head,        data, size);
+        copyIn(head + size, "\n", 1);
+
+        m_head.store(head + size + 1, std::memory_order_release);
+        return true;
+    }
+
+    void drain(std::FILE* file) {
+        std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        std::uint64_t head = m_head.load(std::memory_order_acquire);
+
+        if (head == tail) {
+            return;
+        }
+
+        std::size_t begin = (std::size_t)(tail % kCapacity);
+        std::size_t size  = (std::size_t)(head - tail);
+        std::size_t first = size < kCapacity - begin ? size : kCapacity - begin;
+
+        std::fwrite(m_data + begin, 1, first, file);
+        std::fwrite(m_data,         1, size - first, file);
+
+        m_tail.store(head, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    LogRing* next() const {
+        return m_next;
+    }
+
+    void setNext(LogRing* next) {
+        m_next = next;
+    }
+
+private:
+    void copyIn(std::uint64_t position, const char* data, std::size_t size) {
+        std::size_t begin = (std::size_t)(position % kCapacity);
+        std::size_t first = size < kCapacity - begin ? size : kCapacity - begin;
+
+        std::memcpy(m_data + begin, data,         first);
+        std::memcpy(m_data,         data + first, size - first);
+    }
+
+    char                       m_data[kCapacity];
+    std::atomic<std::uint64_t> m_head;
+    std::atomic<std::uint64_t> m_tail;
+    LogRing*                   m_next;
+};
+
+//
+// Owns the list of rings and the background thread that drains them. The Logger is
+// created on first use and never destroyed, so threads that are still running while
+// static objects are destroyed at exit can keep logging. What is left is drained by
+// an atexit(...) handler on a normal exit, including exit(...) from an assert.
+//
+// Rings are pushed onto the front of an intrusive list and never removed, so the
+// drain can walk the list without a lock. A ring whose thread has exited stays in the
+// list; it is small and so is the number of threads that log.
+//
+// With LOG_OVERFLOW_BLOCK, a thread whose ring is full wakes the drain thread and
+// sleeps until the next flush(), which signals m_drained, rather than spinning.
+//
+class Logger
+{
+public:
+    static const int kFlushIntervalMilliseconds = 5;
+
+    Logger();
+
+    void write(const char* data, std::size_t size);
+    void flush();
+    bool tryFlush();
+
+    void setOverflowPolicy(LogOverflowPolicy policy);
+    LogOverflowPolicy overflowPolicy() const;
+    std::uint64_t droppedLines() const;
+
+private:
+    LogRing* threadRing();
+    void drainAll();
+    void run();
+
+    std::atomic<LogRing*>          m_rings;
+    std::atomic_flag               m_drainLock;
+    std::atomic<int>               m_overflowPolicy;
+    std::atomic<std::uint64_t>     m_droppedLines;
+
+    std::mutex                     m_wakeMutex;
+    std::condition_variable        m_wake;
+    std::thread                    m_thread;
+
+    // counts the calls to flush(), so that a blocked writer can wait for the next one
+    std::mutex                     m_drainedMutex;
+    std::condition_variable        m_drained;
+    std::uint64_t                  m_drainedCount;
+};
+
+// std::chrono::milliseconds(...) takes it by reference, so it needs a definition
+const int Logger::kFlushIntervalMilliseconds;
+
+const int kFatalSignals[]  = { SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV };
+const int kFatalSignalCount = sizeof(kFatalSignals) / sizeof(kFatalSignals[0]);
+
+std::terminate_handler s_previousTerminateHandler = NULL;
+struct sigaction       s_previousSignalActions[kFatalSignalCount];
+
+Logger& logger() {
+    static Logger* logger = new Logger();
+    return *logger;
+}
+
+void flushLogOnExit() {
+    logger().flush();
+}
+
+//
+// We don't know which lock the crashing thread holds, so we only try to take the drain
+// lock and give up rather than deadlock; stdio isn't async-signal-safe either, but
+// losing the log is what happens without this, so it's worth the attempt.
+//
+// Afterwards the handler that was installed before ours is put back and the signal is
+// passed on to it, so crash reporters and debuggers' handlers still see it. With no
+// handler of its own, the signal is raised again and gets its default action.
+//
+void flushLogOnSignal(int signal, siginfo_t* info, void* context) {
+    logger().tryFlush();
+
+    for (int i = 0; i < kFatalSignalCount; ++i) {
+        if (kFatalSignals[i] != signal) {
+            continue;
+        }
+
+        const struct sigaction& previous = s_previousSignalActions[i];
+        sigaction(signal, &previous, NULL);
+
+        if (previous.sa_flags & SA_SIGINFO) {
+            previous.sa_sigaction(signal, info, context);
+        } else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {
+            previous.sa_handler(signal);
+        } else {
+            raise(signal);
+        }
+
+        return;
+    }
+}
+
+void flushLogOnTerminate() {
+    logger().tryFlush();
+
+    if (s_previousTerminateHandler != NULL) {
+        s_previousTerminateHandler();
+    }
+
+    std::abort();
+}
+
+Logger::Logger() :
+    m_rings         (NULL),
+    m_overflowPolicy(LOG_OVERFLOW_DROP),
+    m_droppedLines  (0),
+    m_drainedCount  (0) {
+
+    m_drainLock.clear();
+
+    const char* policy = std::getenv("MOJO_LOG_OVERFLOW");
+    if (policy != NULL && std::strcmp(policy, "block") == 0) {
+        m_overflowPolicy = LOG_OVERFLOW_BLOCK;
+    }
+
+    s_previousTerminateHandler = std::set_terminate(&flushLogOnTerminate);
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_sigaction = &flushLogOnSignal;
+    action.sa_flags     = SA_SIGINFO;
+
+    for (int i = 0; i < kFatalSignalCount; ++i) {
+        sigaction(kFatalSignals[i], &action, &s_previousSignalActions[i]);
+    }
+
+    std::atexit(&flushLogOnExit);
+
+    m_thread = std::thread(&Logger::run, this);
+}
+
+void Logger::write(const char* data, std::size_t size) {
+
+    //
+    // A line that can never fit is cut so that it still shows up, with a newline.
+    //
+    if (size > LogRing::kCapacity - 1) {
+        size = LogRing::kCapacity - 1;
+    }
+
+    LogRing* ring = threadRing();
+    if (ring->tryWrite(data, size)) {
+        return;
+    }
+
+    if (m_overflowPolicy.load(std::memory_order_relaxed) == LOG_OVERFLOW_DROP) {
+        m_droppedLines.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    //
+    // The count is read under the lock that flush() increments it under, so a flush
+    // that happens after the write failed always wakes us. The drain thread flushes
+    // every kFlushIntervalMilliseconds anyway, even if it misses the notification.
+    //
+    std::unique_lock<std::mutex> lock(m_drainedMutex);
+
+    while (!ring->tryWrite(data, size)) {
+        std::uint64_t drainedCount = m_drainedCount;
+
+        m_wake.notify_one();
+        m_drained.wait(lock, [this, drainedCount] { return m_drainedCount != drainedCount; });
+    }
+}
+
+void Logger::flush() {
+    while (m_drainLock.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    drainAll();
+    m_drainLock.clear(std::memory_order_release);
+
+    // tryFlush() doesn't signal, since it runs in signal handlers, which must not lock
+    {
+        std::lock_guard<std::mutex> lock(m_drainedMutex);
+        ++m_drainedCount;
+    }
+    m_drained.notify_all();
+}
+
+bool Logger::tryFlush() {
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        if (!m_drainLock.test_and_set(std::memory_order_acquire)) {
+            drainAll();
+            m_drainLock.clear(std::memory_order_release);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Logger::setOverflowPolicy(LogOverflowPolicy policy) {
+    m_overflowPolicy.store(policy, std::memory_order_relaxed);
+}
+
+LogOverflowPolicy Logger::overflowPolicy() const {
+    return (LogOverflowPolicy)m_overflowPolicy.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Logger::droppedLines() const {
+    return m_droppedLines.load(std::memory_order_relaxed);
+}
+
+LogRing* Logger::threadRing() {
+    static thread_local LogRing* ring = NULL;
+
+    if (ring == NULL) {
+        ring = new LogRing();
+
+        LogRing* head = m_rings.load(std::memory_order_relaxed);
+        do {
+            ring->setNext(head);
+        } while (!m_rings.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    return ring;
+}
+
+//
+// Each ring's pending lines are copied into stdio's buffer and written with a single
+// fflush(...), so a burst of lines costs one write to stdout rather than one per line.
+//
+void Logger::drainAll() {
+    bool wrote = false;
+
+    for (LogRing* ring = m_rings.load(std::memory_order_acquire); ring != NULL; ring = ring->next()) {
+        if (!ring->empty()) {
+            ring->drain(stdout);
+            wrote = true;
+        }
+    }
+
+    if (wrote) {
+        std::fflush(stdout);
+    }
+}
+
+void Logger::run() {
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+
+    for (;;) {
+        m_wake.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMilliseconds));
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+}
+
+void logLine(const char* data, std::size_t size) {
+    logger().write(data, size);
+}
+
+void flushLog() {
+    logger().flush();
+}
+
+void setLogOverflowPolicy(LogOverflowPolicy policy) {
+    logger().setOverflowPolicy(policy);
+}
+
+LogOverflowPolicy logOverflowPolicy() {
+    return logger().overflowPolicy();
+}
+
+std::uint64_t droppedLogLines() {
+    return logger().droppedLines();
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mojo
+{
+
+//
+// The log backend behind mojo::printf. Each thread that logs gets its own lock-free
+// ring buffer, so emitting a line costs a memcpy into that ring. A background thread
+// drains all rings in batches and writes them to stdout, so a slow consumer of stdout,
+// e.g., a pipe to a log collector, never stalls the thread that logged.
+//
+// When a ring is full, the overflow policy decides whether the line is dropped
+// (counted by droppedLogLines()) or whether the logging thread waits for the
+// background thread to make room. The default is LOG_OVERFLOW_DROP; setting the
+// MOJO_LOG_OVERFLOW environment variable to "block" changes it at startup.
+//
+enum LogOverflowPolicy
+{
+    LOG_OVERFLOW_DROP,
+    LOG_OVERFLOW_BLOCK
+};
+
+void logLine(const char* data, std::size_t size);
+
+//
+// Writes everything logged so far to stdout before returning. Called on asserts,
+// and on exit and fatal signals, so the last lines before a crash are not lost.
+//
+void flushLog();
+
+void setLogOverflowPolicy(LogOverflowPolicy policy);
+LogOverflowPolicy logOverflowPolicy();
+
+std::uint64_t droppedLogLines();
+
+}
+
+#endif
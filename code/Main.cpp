@@ -1,10 +1,97 @@
+#include <cstdlib>
+#include <cstring>
+
 #include <QtWidgets/QApplication>
+#include <QtWidgets/QDockWidget>
+#include <QtWidgets/QMainWindow>
 
 #include "MainWindow.hpp"
+#include "RemoteG3DWidget.hpp"
+#include "RenderProcess.hpp"
+
+//
+// --multi-process runs each GLG3D::GApp in a render process of its own, and shows its
+// frames in a RemoteG3DWidget. The second view of the G3D::StarterApp renders a scene
+// that lives in the G3D::StarterApp's process, so this mode doesn't have it.
+//
+static int runMultiProcess(QApplication& application) {
+    QMainWindow mainWindow;
+
+    mojo::RemoteG3DWidget* starterAppWidget     = new mojo::RemoteG3DWidget("starter", &mainWindow);
+    mojo::RemoteG3DWidget* pixelShaderAppWidget = new mojo::RemoteG3DWidget("pixelShader", &mainWindow);
+
+    starterAppWidget->setMinimumSize(800, 800);
+    pixelShaderAppWidget->setMinimumSize(400, 400);
+    pixelShaderAppWidget->setMaximumSize(400, 400);
+
+    QDockWidget* dockWidgetTop = new QDockWidget(&mainWindow);
+    dockWidgetTop->setFeatures(QDockWidget::DockWidgetFloatable | QDockWidget::DockWidgetMovable);
+    dockWidgetTop->setWidget(pixelShaderAppWidget);
+
+    mainWindow.setCentralWidget(starterAppWidget);
+    mainWindow.addDockWidget(Qt::RightDockWidgetArea, dockWidgetTop);
+
+    if (!starterAppWidget->start() || !pixelShaderAppWidget->start()) {
+        return EXIT_FAILURE;
+    }
+
+    mainWindow.show();
+    return application.exec();
+}
 
 int main(int argc, char *argv[]) {
     QApplication application(argc, argv);
+
+    //
+    // --render-process APP SERVER is how a RemoteG3DWidget starts the process that
+    // renders for it; see RenderProcess.hpp.
+    //
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--render-process") == 0 && i + 2 < argc) {
+            mojo::RenderProcess renderProcess(argv[i + 1], argv[i + 2]);
+            if (!renderProcess.start()) {
+                return EXIT_FAILURE;
+            }
+            return application.exec();
+        } else if (std::strcmp(argv[i], "--multi-process") == 0) {
+            return runMultiProcess(application);
+        }
+    }
+
     mojo::MainWindow mainWindow;
+
+    //
+    // --training-workload N runs N frames of scripted input and quits; see
+    // TrainingWorkload.hpp and build_pgo.sh.
+    //
+    // --max-frames-in-flight N and --late-input-sampling trade throughput for input
+    // latency; see FrameLatencyLimiter.hpp.
+    //
+    // --profiler-overlay draws the CPU and GPU time of each zone of the frame, and the
+    // frame and input latency, over each view; see FrameProfiler.hpp.
+    //
+    // --telemetry-port N serves live frame statistics on http://127.0.0.1:N/telemetry;
+    // see TelemetryServer.hpp.
+    //
+    // --video-environment FILE plays a video, e.g., an equirectangular 360 degree one, in
+    // the reflections of the G3D::PixelShaderApp; see VideoTextureSource.hpp.
+    //
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--training-workload") == 0 && i + 1 < argc) {
+            mainWindow.startTrainingWorkload(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--max-frames-in-flight") == 0 && i + 1 < argc) {
+            mainWindow.setMaxFramesInFlight(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--late-input-sampling") == 0) {
+            mainWindow.setLateInputSampling(true);
+        } else if (std::strcmp(argv[i], "--profiler-overlay") == 0) {
+            mainWindow.setProfilerOverlayEnabled(true);
+        } else if (std::strcmp(argv[i], "--telemetry-port") == 0 && i + 1 < argc) {
+            mainWindow.startTelemetryServer(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--video-environment") == 0 && i + 1 < argc) {
+            mainWindow.setVideoEnvironment(argv[i + 1]);
+        }
+    }
+
     mainWindow.show();
     return application.exec();
 }
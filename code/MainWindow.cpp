@@ -1,5 +1,7 @@
 #include "MainWindow.hpp"
 
+#include <limits>
+
 #include <QtWidgets/QHBoxLayout>
 #include <QtWidgets/QLabel>
 #include <QtWebKitWidgets/QWebView>
@@ -10,19 +12,31 @@
 #include "StarterApp.hpp"
 #include "PixelShaderApp.hpp"
 
+#include "Printf.hpp"
 #include "QtUtil.hpp"
+#include "TrainingWorkload.hpp"
 #include "G3DWidgetOpenGLContext.hpp"
 #include "G3DWidget.hpp"
+#include "IngestPipeline.hpp"
+#include "G3DWidgetScheduler.hpp"
+#include "ShaderWatcher.hpp"
+#include "TextureCache.hpp"
+#include "MeshCache.hpp"
+#include "TelemetryServer.hpp"
 
 namespace mojo
 {
 
+static const double kIngestUploadBudgetMilliseconds = 2.0;
+static const double kG3DWidgetBudgetMilliseconds    = 12.0;
+
 //
 // When creating G3DWidgets, we need to pass in a G3DWidgetOpenGLContext and a
 // GLG3D::RenderDevice. Decoupling the creation of G3DWidgets from OpenGL resources,
 // e.g., G3DWidgetOpenGLContext and GLG3D::RenderDevice, allows these resources
 // to be shared across multiple G3DWidgets. This is useful, e.g., for rendering
-// the same scene from multiple angles in different G3DWidgets.
+// the same scene from multiple angles in different G3DWidgets, which is what
+// m_starterAppViewWidget does below.
 //
 MainWindow::MainWindow(QWidget* parent) :
     QMainWindow             (parent),
@@ -30,25 +44,59 @@ MainWindow::MainWindow(QWidget* parent) :
     m_g3dWidgetOpenGLContext(new G3DWidgetOpenGLContext(G3D::OSWindow::Settings())),
     m_renderDevice          (new G3D::RenderDevice),
     m_starterAppWidget      (new G3DWidget(m_g3dWidgetOpenGLContext, m_renderDevice, this)),
+    m_starterAppViewWidget  (new G3DWidget(m_g3dWidgetOpenGLContext, m_renderDevice, this)),
     m_pixelShaderAppWidget  (new G3DWidget(m_g3dWidgetOpenGLContext, m_renderDevice, this)),
     m_timer                 (new QTimer(this)),
+    m_trainingFrameCount    (0),
+    m_meshCache             (new MeshCache(MeshCache::defaultDirectory())),
+    m_ingestPipeline        (new IngestPipeline),
+    m_g3dWidgetScheduler    (new G3DWidgetScheduler(kG3DWidgetBudgetMilliseconds)),
     m_g3dWidgetsInitialized (false) {
 
     m_ui->setupUi(this);
     m_starterAppWidget->setMinimumSize(800, 800);
     m_pixelShaderAppWidget->setMinimumSize(400, 400);
     m_pixelShaderAppWidget->setMaximumSize(400, 400);
+    m_starterAppViewWidget->setMinimumSize(400, 400);
 
     QDockWidget* dockWidgetTop    = findChild<QDockWidget*>("dockWidgetTop");
     QDockWidget* dockWidgetBottom = findChild<QDockWidget*>("dockWidgetBottom");
 
+    QDockWidget* dockWidgetView = new QDockWidget("Second View", this);
+    dockWidgetView->setFeatures(QDockWidget::DockWidgetFloatable | QDockWidget::DockWidgetMovable);
+    dockWidgetView->setAllowedAreas(Qt::LeftDockWidgetArea);
+    addDockWidget(Qt::LeftDockWidgetArea, dockWidgetView);
+
     QWebView* webView = new QWebView(dockWidgetBottom);
     webView->setUrl(QUrl("http://g3d.sourceforge.net/"));
 
     setCentralWidget(m_starterAppWidget);
     dockWidgetTop->setWidget(m_pixelShaderAppWidget);
     dockWidgetBottom->setWidget(webView);
+    dockWidgetView->setWidget(m_starterAppViewWidget);
+
+    //
+    // Files dropped on a G3DWidget are decoded on the IngestPipeline's worker threads
+    // and uploaded a slice at a time in onTimerTimeout(), instead of being loaded by
+    // the GLG3D::GApp on this thread, which would freeze the window for large files.
+    // The OBJ models among them share the G3D::PixelShaderApp's MeshCache, so a model
+    // that was dropped before loads from its entry.
+    //
+    m_ingestPipeline->setMeshCache(m_meshCache);
+    m_starterAppWidget->setIngestPipeline(m_ingestPipeline);
+    m_starterAppViewWidget->setIngestPipeline(m_ingestPipeline);
+    m_pixelShaderAppWidget->setIngestPipeline(m_ingestPipeline);
+
+    //
+    // The G3DWidgets share the time of each tick of m_timer. The G3D::StarterApp is the
+    // main view, so it gets the highest priority. Its second view is added after it,
+    // so that it is updated after it, and can drop to a lower rate.
+    //
+    m_g3dWidgetScheduler->add(m_starterAppWidget,     2, 60.0);
+    m_g3dWidgetScheduler->add(m_starterAppViewWidget, 0, 30.0);
+    m_g3dWidgetScheduler->add(m_pixelShaderAppWidget, 1, 60.0);
 
+    MOJO_QT_SAFE(connect(m_ingestPipeline.get(), SIGNAL(jobFinished(std::shared_ptr<mojo::IngestJob>)), this, SLOT(onIngestJobFinished(std::shared_ptr<mojo::IngestJob>))));
     MOJO_QT_SAFE(connect(m_timer, SIGNAL(timeout()), this, SLOT(onTimerTimeout())));
     m_timer->start(15);
 }
@@ -56,6 +104,51 @@ MainWindow::MainWindow(QWidget* parent) :
 MainWindow::~MainWindow() {
 }
 
+void MainWindow::startTrainingWorkload(int numFrames) {
+    m_trainingWorkload   = std::make_shared<TrainingWorkload>(numFrames);
+    m_trainingFrameCount = std::numeric_limits<std::uint64_t>::max();
+
+    // the workload's G3DWidget renders on every tick, rather than at its usual rate
+    m_g3dWidgetScheduler->setTargetRate(m_starterAppWidget, 0.0);
+    m_timer->setInterval(0);
+}
+
+void MainWindow::setMaxFramesInFlight(int maxFramesInFlight) {
+    m_starterAppWidget->frameLatencyLimiter().setMaxFramesInFlight(maxFramesInFlight);
+    m_starterAppViewWidget->frameLatencyLimiter().setMaxFramesInFlight(maxFramesInFlight);
+    m_pixelShaderAppWidget->frameLatencyLimiter().setMaxFramesInFlight(maxFramesInFlight);
+}
+
+void MainWindow::setLateInputSampling(bool enabled) {
+    m_starterAppWidget->setLateInputSampling(enabled);
+    m_starterAppViewWidget->setLateInputSampling(enabled);
+    m_pixelShaderAppWidget->setLateInputSampling(enabled);
+}
+
+void MainWindow::setProfilerOverlayEnabled(bool enabled) {
+    m_starterAppWidget->frameProfiler().setOverlayEnabled(enabled);
+    m_starterAppViewWidget->frameProfiler().setOverlayEnabled(enabled);
+    m_pixelShaderAppWidget->frameProfiler().setOverlayEnabled(enabled);
+}
+
+void MainWindow::startTelemetryServer(int port) {
+    MOJO_RELEASE_ASSERT(!m_telemetryServer);
+
+    std::shared_ptr<TelemetryServer> telemetryServer = std::make_shared<TelemetryServer>();
+    telemetryServer->add("starterApp",     m_starterAppWidget);
+    telemetryServer->add("starterAppView", m_starterAppViewWidget);
+    telemetryServer->add("pixelShaderApp", m_pixelShaderAppWidget);
+
+    if (telemetryServer->start(port)) {
+        m_telemetryServer = telemetryServer;
+    }
+}
+
+void MainWindow::setVideoEnvironment(const std::string& filename) {
+    MOJO_RELEASE_ASSERT(!m_g3dWidgetsInitialized);
+    m_videoEnvironmentFilename = filename;
+}
+
 void MainWindow::paintEvent(QPaintEvent* e) {
 
     //
@@ -68,6 +161,7 @@ void MainWindow::paintEvent(QPaintEvent* e) {
         // Our first step is to initialize the G3DWidgets.
         //
         m_starterAppWidget->initialize();
+        m_starterAppViewWidget->initialize();
         m_pixelShaderAppWidget->initialize();
 
         //
@@ -100,6 +194,26 @@ void MainWindow::paintEvent(QPaintEvent* e) {
             m_pixelShaderAppWidget,
             m_renderDevice.get()));
 
+#ifdef MOJO_SHADER_SOURCE_DIR
+        //
+        // The G3D::PixelShaderApp reloads its shaders when they are edited in the source
+        // tree, rather than in the copies next to the executable.
+        //
+        std::static_pointer_cast<G3D::PixelShaderApp>(m_pixelShaderApp)->setShaderWatcher(
+            std::make_shared<ShaderWatcher>(MOJO_SHADER_SOURCE_DIR));
+#endif
+
+        // the G3D::PixelShaderApp loads its teapot and environment map in onInit(), so these go before pushLoopBody(...)
+        std::static_pointer_cast<G3D::PixelShaderApp>(m_pixelShaderApp)->setTextureCache(
+            std::make_shared<TextureCache>(TextureCache::defaultDirectory()));
+        std::static_pointer_cast<G3D::PixelShaderApp>(m_pixelShaderApp)->setMeshCache(m_meshCache);
+
+        // the G3D::PixelShaderApp's G3DWidget is still current, as setVideoEnvironment(...) requires
+        if (!m_videoEnvironmentFilename.empty()) {
+            std::static_pointer_cast<G3D::PixelShaderApp>(m_pixelShaderApp)->setVideoEnvironment(
+                m_videoEnvironmentFilename.c_str());
+        }
+
         //
         // We complete the wiring up of our G3DWidgets by binding a specific GLG3D::GApp
         // to each of them.
@@ -107,6 +221,18 @@ void MainWindow::paintEvent(QPaintEvent* e) {
         m_starterAppWidget->pushLoopBody(m_starterApp.get());
         m_pixelShaderAppWidget->pushLoopBody(m_pixelShaderApp.get());
 
+        //
+        // A second view of the G3D::StarterApp scene doesn't need a GLG3D::GApp of its
+        // own. Instead, we bind a G3D::StarterApp::View to its G3DWidget. The view renders
+        // the scene that m_starterApp simulates and poses from its own camera, so adding
+        // views doesn't add simulation cost. Note that the G3DWidget we pass in to
+        // createView(...) must be current.
+        //
+        m_starterAppViewWidget->makeCurrent();
+        m_starterAppView = std::static_pointer_cast<G3D::StarterApp>(m_starterApp)->createView(m_starterAppViewWidget);
+        m_starterAppView->camera->setFrame(G3D::CFrame::fromXYZYPRDegrees(-2.0f, 1.0f, 2.0f, -45.0f, -10.0f));
+        m_starterAppViewWidget->pushLoopBody(&G3D::StarterApp::viewLoopBody, m_starterAppView.get());
+
         m_g3dWidgetsInitialized = true;
     }
 }
@@ -114,27 +240,109 @@ void MainWindow::paintEvent(QPaintEvent* e) {
 void MainWindow::closeEvent(QCloseEvent*) {
 
     m_timer->stop();
+    m_ingestPipeline->cancelAll();
+
+    // textures of partly uploaded files must go while the OpenGL context is alive
+    if (m_g3dWidgetsInitialized) {
+        m_starterAppWidget->makeCurrent();
+        m_ingestPipeline->discardUploads();
+    }
+
+    // the telemetry server reads the G3DWidgets, so it stops before they are terminated
+    if (m_telemetryServer) {
+        m_telemetryServer->stop();
+    }
 
     //
     // To clean up our G3DWidgets, we call popLoopBody() and then terminate(). To clean up
     // our GLG3D::RenderDevice, we call cleanup() as usual. We call these cleanup methods in
     // the opposite order as we called their corresponding initialization methods.
     //
+    m_starterAppViewWidget->popLoopBody();
     m_starterAppWidget->popLoopBody();
     m_pixelShaderAppWidget->popLoopBody();
     m_renderDevice->cleanup();
+    m_starterAppViewWidget->terminate();
     m_starterAppWidget->terminate();
     m_pixelShaderAppWidget->terminate();
 }
 
 void MainWindow::onTimerTimeout() {
 
+    //
+    // The scheduler doesn't update every G3DWidget on every tick, so we send the next
+    // frame's input only once the G3DWidget has rendered a frame with the previous one.
+    //
+    if (m_trainingWorkload && m_g3dWidgetsInitialized) {
+        std::uint64_t frameCount = m_starterAppWidget->frameProfiler().frameCount();
+        if (frameCount != m_trainingFrameCount) {
+            m_trainingWorkload->sendFrameInput(m_starterAppWidget);
+            m_trainingFrameCount = frameCount;
+        }
+    }
+
     //
     // To invoke the loop body of each GLG3D::GApp, we call update() on its
-    // corresponding G3DWidget.
+    // corresponding G3DWidget. The scheduler picks the G3DWidgets that are due and
+    // fit in this tick's budget. Views need to be updated after the GLG3D::GApp whose
+    // scene they render, so they see the surfaces it posed this frame, which the
+    // scheduler's update order takes care of.
+    //
+    m_g3dWidgetScheduler->tick();
+
+    if (m_telemetryServer) {
+        m_telemetryServer->publish(*m_g3dWidgetScheduler);
+    }
+
     //
-    m_starterAppWidget->update();
-    m_pixelShaderAppWidget->update();
+    // The G3DWidgets share an OpenGL context, which the last update() left current,
+    // so uploaded resources can be used by any of them.
+    //
+    if (m_g3dWidgetsInitialized) {
+        m_ingestPipeline->uploadSlices(kIngestUploadBudgetMilliseconds);
+    }
+
+    if (m_trainingWorkload && m_trainingWorkload->finished()) {
+        double milliseconds = m_trainingWorkload->elapsedMilliseconds();
+        int    numFrames    = m_trainingWorkload->numFrames();
+
+        mojo::printf("Training workload: ", numFrames, " frames in ", milliseconds, " ms (", milliseconds / numFrames, " ms/frame)");
+
+        m_trainingWorkload.reset();
+        close();
+    }
+}
+
+void MainWindow::onIngestJobFinished(std::shared_ptr<IngestJob> job) {
+    if (job->state() != IngestJob::STATE_DONE) {
+        return;
+    }
+
+    //
+    // A file dropped on the G3D::PixelShaderApp replaces its teapot, or shows in its
+    // reflections. One dropped on either view of the G3D::StarterApp's scene goes into
+    // the scene where it was dropped, as seen from that view.
+    //
+    if (job->target() == m_pixelShaderAppWidget) {
+        std::shared_ptr<G3D::PixelShaderApp> pixelShaderApp = std::static_pointer_cast<G3D::PixelShaderApp>(m_pixelShaderApp);
+
+        if (job->model()) {
+            pixelShaderApp->setModel(job->model());
+        } else {
+            pixelShaderApp->setEnvironmentImage(job->texture());
+        }
+        return;
+    }
+
+    std::shared_ptr<G3D::StarterApp> starterApp = std::static_pointer_cast<G3D::StarterApp>(m_starterApp);
+    const G3D::StarterApp::View*     view       = (job->target() == m_starterAppViewWidget) ? m_starterAppView.get() : NULL;
+    G3D::Point2                      position((float)job->position().x(), (float)job->position().y());
+
+    if (job->model()) {
+        starterApp->insertModel(job->model(), view, position);
+    } else {
+        starterApp->insertPicture(job->texture(), view, position);
+    }
 }
 
 }
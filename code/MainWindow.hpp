@@ -1,6 +1,7 @@
 #ifndef MAIN_WINDOW_HPP
 #define MAIN_WINDOW_HPP
 
+#include <cstdint>
 #include <string>
 #include <memory>
 
@@ -13,6 +14,7 @@ namespace G3D
 {
 class GApp;
 class RenderDevice;
+class StarterAppView;
 }
 
 namespace mojo
@@ -20,6 +22,12 @@ namespace mojo
 
 class G3DWidgetOpenGLContext;
 class G3DWidget;
+class TrainingWorkload;
+class IngestPipeline;
+class IngestJob;
+class MeshCache;
+class G3DWidgetScheduler;
+class TelemetryServer;
 
 class MainWindow : public QMainWindow
 {
@@ -29,12 +37,44 @@ public:
     MainWindow(QWidget* parent = 0);
     ~MainWindow();
 
+    //
+    // Drives the G3DWidgets with scripted input for numFrames frames, as fast as
+    // possible, then prints the elapsed time and closes the window.
+    //
+    void startTrainingWorkload(int numFrames);
+
+    //
+    // See FrameLatencyLimiter.hpp and G3DWidget::setLateInputSampling(...). Both apply
+    // to every G3DWidget.
+    //
+    void setMaxFramesInFlight(int maxFramesInFlight);
+    void setLateInputSampling(bool enabled);
+
+    //
+    // Draws the FrameProfiler, FrameLatencyLimiter and InputLatencyTracker overlays
+    // over every G3DWidget, see FrameProfiler::drawOverlay(...).
+    //
+    void setProfilerOverlayEnabled(bool enabled);
+
+    //
+    // Serves the frame statistics of every G3DWidget on http://127.0.0.1:<port>/telemetry,
+    // see TelemetryServer.hpp.
+    //
+    void startTelemetryServer(int port);
+
+    //
+    // Plays the video file in the G3D::PixelShaderApp's reflections, see
+    // VideoTextureSource.hpp. Takes effect when the G3DWidgets are initialized.
+    //
+    void setVideoEnvironment(const std::string& filename);
+
 protected:
     void paintEvent(QPaintEvent* e);
     void closeEvent(QCloseEvent* e);
 
 private slots:
     void onTimerTimeout();
+    void onIngestJobFinished(std::shared_ptr<mojo::IngestJob> job);
 
 private:
     std::shared_ptr<Ui::MainWindow>         m_ui;
@@ -42,9 +82,18 @@ private:
     std::shared_ptr<G3D::RenderDevice>      m_renderDevice;
     std::shared_ptr<G3D::GApp>              m_starterApp;
     std::shared_ptr<G3D::GApp>              m_pixelShaderApp;
+    std::shared_ptr<G3D::StarterAppView>    m_starterAppView;
     G3DWidget*                              m_starterAppWidget;
+    G3DWidget*                              m_starterAppViewWidget;
     G3DWidget*                              m_pixelShaderAppWidget;
     QTimer*                                 m_timer;
+    std::shared_ptr<TrainingWorkload>       m_trainingWorkload;
+    std::uint64_t                           m_trainingFrameCount;
+    std::shared_ptr<MeshCache>              m_meshCache;
+    std::shared_ptr<IngestPipeline>         m_ingestPipeline;
+    std::shared_ptr<G3DWidgetScheduler>     m_g3dWidgetScheduler;
+    std::shared_ptr<TelemetryServer>        m_telemetryServer;
+    std::string                             m_videoEnvironmentFilename;
     bool                                    m_g3dWidgetsInitialized;
 };
 
@@ -0,0 +1,788 @@
+#include "MeshCache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <QtCore/QDir>
+#include <QtCore/QStandardPaths>
+
+#include "Assert.hpp"
+#include "ContentHash.hpp"
+#include "Printf.hpp"
+
+namespace mojo
+{
+
+static const std::size_t kSectionAlignment = 16;
+
+// tells apart the temporary files of entries written at the same time by one process
+static std::atomic<unsigned int> s_temporaryFiles(0);
+
+static std::size_t align(std::size_t offset) {
+    return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+}
+
+static bool parseOBJFile(const std::string& path, std::vector<FlatMesh>& meshes, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        close(fd);
+        error = "Cannot read model";
+        return false;
+    }
+
+    std::size_t size    = (std::size_t)status.st_size;
+    void*       mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    bool parsed = parseOBJ((const char*)mapping, size, path, meshes, error, [](float) { return true; });
+    munmap(mapping, size);
+
+    return parsed;
+}
+
+//
+// Like IngestPipeline, we give each material its diffuse map, or its diffuse color
+// if it has none or the map cannot be loaded.
+//
+static std::shared_ptr<G3D::UniversalMaterial> createMaterial(const G3D::ParseMTL::Material* material) {
+    if (material != NULL && !material->map_Kd.empty()) {
+        G3D::String filename = G3D::FilePath::concat(material->basePath, material->map_Kd);
+
+        try {
+            return G3D::UniversalMaterial::createDiffuse(G3D::Texture::fromFile(filename));
+        } catch (...) {
+            mojo::printf("Cannot load ", filename.c_str(), ", using its material's diffuse color instead");
+        }
+    }
+
+    return G3D::UniversalMaterial::createDiffuse(material != NULL ? material->Kd : G3D::Color3(0.8f, 0.8f, 0.8f));
+}
+
+std::string MeshCache::defaultDirectory() {
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/meshes";
+    QDir().mkpath(directory);
+
+    return directory.toUtf8().constData();
+}
+
+MeshCache::MeshCache(const std::string& directory) :
+    m_directory(directory),
+    m_hits     (0),
+    m_misses   (0),
+    m_bypasses (0) {
+
+    MOJO_RELEASE_ASSERT(!directory.empty());
+}
+
+MeshCache::~MeshCache() {
+    for (Writer& writer : m_writers) {
+        writer.thread.join();
+    }
+}
+
+std::shared_ptr<G3D::ArticulatedModel> MeshCache::create(const G3D::ArticulatedModel::Specification& specification) {
+    joinFinishedWriters();
+
+    if (cachesMaterials(specification)) {
+        return createWithMaterials(specification);
+    }
+
+    if (!specification.stripMaterials) {
+        ++m_bypasses;
+        mojo::printf("Not caching ", specification.filename.c_str(), ": the mesh cache only stores the materials of OBJ models loaded without preprocessing");
+        return G3D::ArticulatedModel::create(specification);
+    }
+
+    std::string path = entryPath(specification);
+
+    // G3D::ArticulatedModel::create(...) reports the error if the source cannot be read
+    if (path.empty()) {
+        return G3D::ArticulatedModel::create(specification);
+    }
+
+    std::shared_ptr<G3D::ArticulatedModel> model = load(path, specification);
+    if (model) {
+        ++m_hits;
+        return model;
+    }
+
+    ++m_misses;
+    model = G3D::ArticulatedModel::create(specification);
+    store(path, serialize(flatten(*model)));
+
+    return model;
+}
+
+bool MeshCache::createMeshes(const std::string& path, const char* data, std::size_t size, std::vector<FlatMesh>& meshes, std::string& error, const std::function<bool (float)>& progress) {
+    std::string entry = entryPath(objSpecification(path));
+
+    if (!entry.empty() && loadMeshes(entry, meshes)) {
+        ++m_hits;
+        loadMaterials(path, meshes);
+        return true;
+    }
+
+    if (!parseOBJ(data, size, path, meshes, error, progress)) {
+        return false;
+    }
+
+    // we are on a thread of our own already, so we write the entry right away
+    if (!entry.empty()) {
+        ++m_misses;
+        write(entry, *serialize(flatten(meshes)));
+    }
+
+    return true;
+}
+
+const std::string& MeshCache::directory() const {
+    return m_directory;
+}
+
+std::uint64_t MeshCache::hits() const {
+    return m_hits;
+}
+
+std::uint64_t MeshCache::misses() const {
+    return m_misses;
+}
+
+std::uint64_t MeshCache::bypasses() const {
+    return m_bypasses;
+}
+
+bool MeshCache::cachesMaterials(const G3D::ArticulatedModel::Specification& specification) {
+    return
+        !specification.stripMaterials &&
+        G3D::toLower(G3D::FilePath::ext(specification.filename)) == "obj" &&
+        specification.toAny().unparse() == objSpecification(specification.filename.c_str()).toAny().unparse();
+}
+
+G3D::ArticulatedModel::Specification MeshCache::objSpecification(const std::string& path) {
+    G3D::ArticulatedModel::Specification specification;
+    specification.filename = path.c_str();
+
+    return specification;
+}
+
+std::string MeshCache::entryPath(const G3D::ArticulatedModel::Specification& specification) const {
+    std::uint64_t hash = hashString(kContentHashSeed, specification.toAny().unparse().c_str());
+
+    if (!hashFile(specification.filename.c_str(), hash)) {
+        return std::string();
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)hash);
+
+    return m_directory + "/" + name;
+}
+
+std::shared_ptr<G3D::ArticulatedModel> MeshCache::createWithMaterials(const G3D::ArticulatedModel::Specification& specification) {
+    std::string           sourcePath = specification.filename.c_str();
+    std::string           path       = entryPath(specification);
+    std::vector<FlatMesh> meshes;
+
+    if (!path.empty() && loadMeshes(path, meshes)) {
+        ++m_hits;
+        loadMaterials(sourcePath, meshes);
+        return createModel(specification.filename, meshes);
+    }
+
+    // G3D::ArticulatedModel::create(...) reports the error if the source cannot be read
+    std::string error;
+    if (path.empty() || !parseOBJFile(sourcePath, meshes, error)) {
+        return G3D::ArticulatedModel::create(specification);
+    }
+
+    ++m_misses;
+    store(path, serialize(flatten(meshes)));
+
+    return createModel(specification.filename, meshes);
+}
+
+const unsigned char* MeshCache::mapEntry(const std::string& path, std::size_t& size) const {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (std::size_t)status.st_size < sizeof(Header)) {
+        close(fd);
+        return NULL;
+    }
+
+    size          = (std::size_t)status.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    // we read all of it, front to back, so the kernel may as well start now
+    madvise(mapping, size, MADV_WILLNEED);
+
+    const unsigned char* data   = (const unsigned char*)mapping;
+    const Header&        header = *(const Header*)mapping;
+
+    auto fits = [size](std::uint64_t offset, std::uint64_t count, std::size_t elementSize) {
+        return offset <= size && count <= (size - offset) / elementSize;
+    };
+
+    bool valid =
+        header.magic         == kMagic &&
+        header.version       == kVersion &&
+        header.partCount     >= 0 && fits(header.partsOffset,      header.partCount,     sizeof(PartRecord)) &&
+        header.geometryCount >= 0 && fits(header.geometriesOffset, header.geometryCount, sizeof(GeometryRecord)) &&
+        header.meshCount     >= 0 && fits(header.meshesOffset,     header.meshCount,     sizeof(MeshRecord)) &&
+        fits(header.namesOffset, header.namesSize, 1);
+
+    const PartRecord*     parts      = valid ? (const PartRecord*)    (data + header.partsOffset)      : NULL;
+    const GeometryRecord* geometries = valid ? (const GeometryRecord*)(data + header.geometriesOffset) : NULL;
+    const MeshRecord*     meshes     = valid ? (const MeshRecord*)    (data + header.meshesOffset)     : NULL;
+
+    auto validName = [&header](const Name& name) {
+        return name.offset <= header.namesSize && name.length <= header.namesSize - name.offset;
+    };
+
+    // parents are written before their children
+    for (int i = 0; valid && i < header.partCount; ++i) {
+        valid = validName(parts[i].name) && parts[i].parent >= -1 && parts[i].parent < i;
+    }
+
+    for (int i = 0; valid && i < header.geometryCount; ++i) {
+        valid = validName(geometries[i].name) && fits(geometries[i].verticesOffset, geometries[i].vertexCount, sizeof(VertexRecord));
+    }
+
+    for (int i = 0; valid && i < header.meshCount; ++i) {
+        const MeshRecord& mesh = meshes[i];
+        valid =
+            validName(mesh.name) &&
+            validName(mesh.materialLibrary) &&
+            validName(mesh.materialName) &&
+            mesh.part     >= 0 && mesh.part     < header.partCount &&
+            mesh.geometry >= 0 && mesh.geometry < header.geometryCount &&
+            fits(mesh.indicesOffset, mesh.indexCount, sizeof(std::int32_t));
+    }
+
+    if (!valid) {
+        munmap(mapping, size);
+        mojo::printf("Ignoring invalid mesh cache entry ", path);
+        return NULL;
+    }
+
+    return data;
+}
+
+std::shared_ptr<G3D::ArticulatedModel> MeshCache::load(const std::string& path, const G3D::ArticulatedModel::Specification& specification) const {
+    std::size_t          size = 0;
+    const unsigned char* data = mapEntry(path, size);
+
+    if (data == NULL) {
+        return std::shared_ptr<G3D::ArticulatedModel>();
+    }
+
+    const Header&         header     = *(const Header*)data;
+    const PartRecord*     parts      = (const PartRecord*)    (data + header.partsOffset);
+    const GeometryRecord* geometries = (const GeometryRecord*)(data + header.geometriesOffset);
+    const MeshRecord*     meshes     = (const MeshRecord*)    (data + header.meshesOffset);
+
+    const char* names = (const char*)(data + header.namesOffset);
+    auto        name  = [names](const Name& name) { return G3D::String(names + name.offset, name.length); };
+
+    std::shared_ptr<G3D::ArticulatedModel> model = G3D::ArticulatedModel::createEmpty(specification.filename);
+
+    std::vector<G3D::ArticulatedModel::Part*> modelParts(header.partCount);
+    for (int i = 0; i < header.partCount; ++i) {
+        const PartRecord& record = parts[i];
+
+        G3D::Matrix3 rotation;
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 3; ++column) {
+                rotation[row][column] = record.rotation[row * 3 + column];
+            }
+        }
+
+        modelParts[i]         = model->addPart(name(record.name), record.parent >= 0 ? modelParts[record.parent] : NULL);
+        modelParts[i]->cframe = G3D::CFrame(rotation, G3D::Point3(record.translation[0], record.translation[1], record.translation[2]));
+    }
+
+    std::vector<G3D::ArticulatedModel::Geometry*> modelGeometries(header.geometryCount);
+    for (int i = 0; i < header.geometryCount; ++i) {
+        const GeometryRecord& record   = geometries[i];
+        const VertexRecord*   vertices = (const VertexRecord*)(data + record.verticesOffset);
+
+        modelGeometries[i] = model->addGeometry(name(record.name));
+
+        G3D::CPUVertexArray& cpuVertexArray = modelGeometries[i]->cpuVertexArray;
+        cpuVertexArray.hasTangent   = record.hasTangent != 0;
+        cpuVertexArray.hasTexCoord0 = record.hasTexCoord0 != 0;
+        cpuVertexArray.vertex.resize((int)record.vertexCount);
+
+        for (std::uint64_t v = 0; v < record.vertexCount; ++v) {
+            const VertexRecord&          source = vertices[v];
+            G3D::CPUVertexArray::Vertex& vertex = cpuVertexArray.vertex[(int)v];
+
+            vertex.position  = G3D::Point3 (source.position[0],  source.position[1],  source.position[2]);
+            vertex.normal    = G3D::Vector3(source.normal[0],    source.normal[1],    source.normal[2]);
+            vertex.tangent   = G3D::Vector4(source.tangent[0],   source.tangent[1],   source.tangent[2], source.tangent[3]);
+            vertex.texCoord0 = G3D::Point2 (source.texCoord0[0], source.texCoord0[1]);
+        }
+    }
+
+    for (int i = 0; i < header.meshCount; ++i) {
+        const MeshRecord& record = meshes[i];
+
+        G3D::ArticulatedModel::Mesh* mesh = model->addMesh(name(record.name), modelParts[record.part], modelGeometries[record.geometry]);
+        mesh->primitive = G3D::PrimitiveType((G3D::PrimitiveType::Value)record.primitive);
+        mesh->twoSided  = record.twoSided != 0;
+        mesh->material  = G3D::UniversalMaterial::create();
+
+        mesh->cpuIndexArray.resize((int)record.indexCount);
+        if (record.indexCount > 0) {
+            std::memcpy(mesh->cpuIndexArray.getCArray(), data + record.indicesOffset, record.indexCount * sizeof(std::int32_t));
+        }
+    }
+
+    munmap((void*)data, size);
+
+    //
+    // The normals and tangents were cached too, so this only computes the bounds and
+    // the GPU vertex and index arrays. Vertices were merged before they were cached.
+    //
+    G3D::ArticulatedModel::CleanGeometrySettings settings;
+    settings.allowVertexMerging = false;
+    model->cleanGeometry(settings);
+
+    return model;
+}
+
+bool MeshCache::loadMeshes(const std::string& path, std::vector<FlatMesh>& meshes) const {
+    std::size_t          size = 0;
+    const unsigned char* data = mapEntry(path, size);
+
+    if (data == NULL) {
+        return false;
+    }
+
+    const Header&         header     = *(const Header*)data;
+    const GeometryRecord* geometries = (const GeometryRecord*)(data + header.geometriesOffset);
+    const MeshRecord*     records    = (const MeshRecord*)    (data + header.meshesOffset);
+    const char*           names      = (const char*)          (data + header.namesOffset);
+
+    auto name = [names](const Name& name) { return G3D::String(names + name.offset, name.length); };
+
+    //
+    // flatten(meshes) writes one part, and a geometry of triangles for each mesh, whose
+    // indices we check here, since they go to the render thread as they are.
+    //
+    bool valid = header.partCount == 1 && header.geometryCount == header.meshCount;
+
+    meshes.resize(valid ? header.meshCount : 0);
+
+    for (int i = 0; valid && i < header.meshCount; ++i) {
+        const MeshRecord&     record   = records[i];
+        const GeometryRecord& geometry = geometries[i];
+
+        valid =
+            record.geometry  == i &&
+            record.primitive == G3D::PrimitiveType::TRIANGLES &&
+            geometry.hasTangent != 0 &&
+            geometry.vertexCount <= (std::uint64_t)std::numeric_limits<std::int32_t>::max() &&
+            record.indexCount % 3 == 0;
+
+        if (!valid) {
+            break;
+        }
+
+        FlatMesh& mesh = meshes[i];
+        mesh.name            = name(record.name);
+        mesh.materialLibrary = name(record.materialLibrary);
+        mesh.materialName    = name(record.materialName);
+        mesh.hasTexCoord0    = geometry.hasTexCoord0 != 0;
+
+        const VertexRecord* vertices = (const VertexRecord*)(data + geometry.verticesOffset);
+        mesh.vertices.resize((std::size_t)geometry.vertexCount);
+
+        for (std::uint64_t v = 0; v < geometry.vertexCount; ++v) {
+            const VertexRecord&          source = vertices[v];
+            G3D::CPUVertexArray::Vertex& vertex = mesh.vertices[(std::size_t)v];
+
+            vertex.position  = G3D::Point3 (source.position[0],  source.position[1],  source.position[2]);
+            vertex.normal    = G3D::Vector3(source.normal[0],    source.normal[1],    source.normal[2]);
+            vertex.tangent   = G3D::Vector4(source.tangent[0],   source.tangent[1],   source.tangent[2], source.tangent[3]);
+            vertex.texCoord0 = G3D::Point2 (source.texCoord0[0], source.texCoord0[1]);
+        }
+
+        const std::int32_t* indices = (const std::int32_t*)(data + record.indicesOffset);
+        mesh.indices.assign(indices, indices + record.indexCount);
+
+        for (int index : mesh.indices) {
+            valid = valid && index >= 0 && (std::uint64_t)index < geometry.vertexCount;
+        }
+    }
+
+    munmap((void*)data, size);
+
+    if (!valid) {
+        meshes.clear();
+        mojo::printf("Ignoring invalid mesh cache entry ", path);
+    }
+
+    return valid;
+}
+
+MeshCache::Contents MeshCache::flatten(const G3D::ArticulatedModel& model) {
+
+    //
+    // The model may change once we return, so serialize(...) must copy the vertices
+    // and indices before it does. The parts are listed depth first, so parents come
+    // before their children.
+    //
+    std::vector<G3D::ArticulatedModel::Part*> parts;
+    for (int i = 0; i < model.rootArray().size(); ++i) {
+        std::vector<G3D::ArticulatedModel::Part*> stack(1, model.rootArray()[i]);
+
+        while (!stack.empty()) {
+            G3D::ArticulatedModel::Part* part = stack.back();
+            stack.pop_back();
+            parts.push_back(part);
+
+            for (int child = part->childArray().size() - 1; child >= 0; --child) {
+                stack.push_back(part->childArray()[child]);
+            }
+        }
+    }
+
+    const G3D::Array<G3D::ArticulatedModel::Geometry*>& geometries = model.geometryArray();
+    const G3D::Array<G3D::ArticulatedModel::Mesh*>&     meshes     = model.meshArray();
+
+    std::map<const G3D::ArticulatedModel::Part*, int>     partIndices;
+    std::map<const G3D::ArticulatedModel::Geometry*, int> geometryIndices;
+    Contents                                              contents;
+
+    auto addName = [&contents](const G3D::String& value) {
+        Name name;
+        name.offset = (std::uint32_t)contents.names.size();
+        name.length = (std::uint32_t)value.size();
+        contents.names.append(value.c_str(), value.size());
+        return name;
+    };
+
+    contents.parts.resize(parts.size());
+    contents.geometries.resize(geometries.size());
+    contents.meshes.resize(meshes.size());
+
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        const G3D::ArticulatedModel::Part* part   = parts[i];
+        PartRecord&                        record = contents.parts[i];
+
+        partIndices[part] = (int)i;
+
+        record.name   = addName(part->name);
+        record.parent = part->isRoot() ? -1 : partIndices[part->parent()];
+
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 3; ++column) {
+                record.rotation[row * 3 + column] = part->cframe.rotation[row][column];
+            }
+        }
+
+        record.translation[0] = part->cframe.translation.x;
+        record.translation[1] = part->cframe.translation.y;
+        record.translation[2] = part->cframe.translation.z;
+    }
+
+    for (int i = 0; i < geometries.size(); ++i) {
+        const G3D::CPUVertexArray& cpuVertexArray = geometries[i]->cpuVertexArray;
+        GeometryRecord&            record         = contents.geometries[i];
+
+        geometryIndices[geometries[i]] = i;
+
+        record.name         = addName(geometries[i]->name);
+        record.hasTangent   = cpuVertexArray.hasTangent ? 1 : 0;
+        record.hasTexCoord0 = cpuVertexArray.hasTexCoord0 ? 1 : 0;
+        record.vertexCount  = (std::uint64_t)cpuVertexArray.vertex.size();
+
+        contents.vertices.push_back(cpuVertexArray.vertex.getCArray());
+    }
+
+    for (int i = 0; i < meshes.size(); ++i) {
+        const G3D::ArticulatedModel::Mesh* mesh   = meshes[i];
+        MeshRecord&                        record = contents.meshes[i];
+
+        record.name            = addName(mesh->name);
+        record.part            = partIndices[mesh->logicalPart];
+        record.geometry        = geometryIndices[mesh->geometry];
+        record.primitive       = (std::int32_t)mesh->primitive.value;
+        record.twoSided        = mesh->twoSided ? 1 : 0;
+        record.indexCount      = (std::uint64_t)mesh->cpuIndexArray.size();
+        record.materialLibrary = addName(G3D::String());
+        record.materialName    = addName(G3D::String());
+
+        contents.indices.push_back(mesh->cpuIndexArray.getCArray());
+    }
+
+    return contents;
+}
+
+MeshCache::Contents MeshCache::flatten(const std::vector<FlatMesh>& meshes) {
+    Contents contents;
+
+    auto addName = [&contents](const G3D::String& value) {
+        Name name;
+        name.offset = (std::uint32_t)contents.names.size();
+        name.length = (std::uint32_t)value.size();
+        contents.names.append(value.c_str(), value.size());
+        return name;
+    };
+
+    // like the model IngestPipeline builds, one part with a geometry for each mesh
+    contents.parts.resize(1);
+    contents.geometries.resize(meshes.size());
+    contents.meshes.resize(meshes.size());
+
+    PartRecord& part = contents.parts[0];
+    part.name   = addName("root");
+    part.parent = -1;
+
+    for (int i = 0; i < 9; ++i) {
+        part.rotation[i] = (i % 4 == 0) ? 1.0f : 0.0f;
+    }
+
+    part.translation[0] = 0.0f;
+    part.translation[1] = 0.0f;
+    part.translation[2] = 0.0f;
+
+    for (std::size_t i = 0; i < meshes.size(); ++i) {
+        const FlatMesh& mesh     = meshes[i];
+        GeometryRecord& geometry = contents.geometries[i];
+        MeshRecord&     record   = contents.meshes[i];
+
+        geometry.name         = addName(mesh.name);
+        geometry.hasTangent   = 1;
+        geometry.hasTexCoord0 = mesh.hasTexCoord0 ? 1 : 0;
+        geometry.vertexCount  = (std::uint64_t)mesh.vertices.size();
+
+        record.name            = addName(mesh.name);
+        record.part            = 0;
+        record.geometry        = (std::int32_t)i;
+        record.primitive       = (std::int32_t)G3D::PrimitiveType::TRIANGLES;
+        record.twoSided        = 0;
+        record.indexCount      = (std::uint64_t)mesh.indices.size();
+        record.materialLibrary = addName(mesh.materialLibrary);
+        record.materialName    = addName(mesh.materialName);
+
+        contents.vertices.push_back(mesh.vertices.empty() ? NULL : &mesh.vertices[0]);
+        contents.indices.push_back(mesh.indices.empty() ? NULL : &mesh.indices[0]);
+    }
+
+    return contents;
+}
+
+std::shared_ptr<std::vector<unsigned char> > MeshCache::serialize(const Contents& contents) {
+    std::vector<GeometryRecord> geometryRecords = contents.geometries;
+    std::vector<MeshRecord>     meshRecords     = contents.meshes;
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic         = kMagic;
+    header.version       = kVersion;
+    header.partCount     = (std::int32_t)contents.parts.size();
+    header.geometryCount = (std::int32_t)geometryRecords.size();
+    header.meshCount     = (std::int32_t)meshRecords.size();
+
+    std::size_t size = align(sizeof(Header));
+
+    header.partsOffset      = size;
+    size                    = align(size + contents.parts.size() * sizeof(PartRecord));
+    header.geometriesOffset = size;
+    size                    = align(size + geometryRecords.size() * sizeof(GeometryRecord));
+    header.meshesOffset     = size;
+    size                    = align(size + meshRecords.size() * sizeof(MeshRecord));
+    header.namesOffset      = size;
+    header.namesSize        = contents.names.size();
+    size                    = align(size + contents.names.size());
+
+    for (GeometryRecord& record : geometryRecords) {
+        record.verticesOffset = size;
+        size                  = align(size + record.vertexCount * sizeof(VertexRecord));
+    }
+
+    for (MeshRecord& record : meshRecords) {
+        record.indicesOffset = size;
+        size                 = align(size + record.indexCount * sizeof(std::int32_t));
+    }
+
+    std::shared_ptr<std::vector<unsigned char> > entry = std::make_shared<std::vector<unsigned char> >(size);
+    unsigned char*                               data  = &(*entry)[0];
+
+    std::memcpy(data, &header, sizeof(header));
+
+    if (!contents.parts.empty()) {
+        std::memcpy(data + header.partsOffset, &contents.parts[0], contents.parts.size() * sizeof(PartRecord));
+    }
+
+    if (!geometryRecords.empty()) {
+        std::memcpy(data + header.geometriesOffset, &geometryRecords[0], geometryRecords.size() * sizeof(GeometryRecord));
+    }
+
+    if (!meshRecords.empty()) {
+        std::memcpy(data + header.meshesOffset, &meshRecords[0], meshRecords.size() * sizeof(MeshRecord));
+    }
+
+    std::memcpy(data + header.namesOffset, contents.names.data(), contents.names.size());
+
+    for (std::size_t i = 0; i < geometryRecords.size(); ++i) {
+        const G3D::CPUVertexArray::Vertex* vertices = contents.vertices[i];
+        VertexRecord*                      records  = (VertexRecord*)(data + geometryRecords[i].verticesOffset);
+
+        for (std::uint64_t v = 0; v < geometryRecords[i].vertexCount; ++v) {
+            const G3D::CPUVertexArray::Vertex& vertex = vertices[v];
+            VertexRecord&                      record = records[v];
+
+            record.position[0]  = vertex.position.x;
+            record.position[1]  = vertex.position.y;
+            record.position[2]  = vertex.position.z;
+            record.normal[0]    = vertex.normal.x;
+            record.normal[1]    = vertex.normal.y;
+            record.normal[2]    = vertex.normal.z;
+            record.tangent[0]   = vertex.tangent.x;
+            record.tangent[1]   = vertex.tangent.y;
+            record.tangent[2]   = vertex.tangent.z;
+            record.tangent[3]   = vertex.tangent.w;
+            record.texCoord0[0] = vertex.texCoord0.x;
+            record.texCoord0[1] = vertex.texCoord0.y;
+        }
+    }
+
+    for (std::size_t i = 0; i < meshRecords.size(); ++i) {
+        if (meshRecords[i].indexCount > 0) {
+            std::memcpy(data + meshRecords[i].indicesOffset, contents.indices[i], meshRecords[i].indexCount * sizeof(std::int32_t));
+        }
+    }
+
+    return entry;
+}
+
+std::shared_ptr<G3D::ArticulatedModel> MeshCache::createModel(const G3D::String& name, const std::vector<FlatMesh>& meshes) {
+    std::shared_ptr<G3D::ArticulatedModel> model = G3D::ArticulatedModel::createEmpty(name);
+    G3D::ArticulatedModel::Part*           part  = model->addPart("root");
+
+    // meshes that use the same material share it
+    std::map<const G3D::ParseMTL::Material*, std::shared_ptr<G3D::UniversalMaterial> > materials;
+
+    for (const FlatMesh& flat : meshes) {
+        std::shared_ptr<G3D::UniversalMaterial>& material = materials[flat.material.get()];
+        if (!material) {
+            material = createMaterial(flat.material.get());
+        }
+
+        G3D::ArticulatedModel::Geometry* geometry       = model->addGeometry(flat.name);
+        G3D::CPUVertexArray&             cpuVertexArray = geometry->cpuVertexArray;
+        cpuVertexArray.hasTangent   = true;
+        cpuVertexArray.hasTexCoord0 = flat.hasTexCoord0;
+        cpuVertexArray.vertex.resize((int)flat.vertices.size());
+        std::copy(flat.vertices.begin(), flat.vertices.end(), cpuVertexArray.vertex.getCArray());
+
+        G3D::ArticulatedModel::Mesh* mesh = model->addMesh(flat.name, part, geometry);
+        mesh->primitive = G3D::PrimitiveType::TRIANGLES;
+        mesh->material  = material;
+        mesh->cpuIndexArray.resize((int)flat.indices.size());
+        std::copy(flat.indices.begin(), flat.indices.end(), mesh->cpuIndexArray.getCArray());
+    }
+
+    // parseOBJ(...) computed the normals and tangents and merged the vertices already
+    G3D::ArticulatedModel::CleanGeometrySettings settings;
+    settings.allowVertexMerging = false;
+    model->cleanGeometry(settings);
+
+    return model;
+}
+
+void MeshCache::store(const std::string& path, const std::shared_ptr<std::vector<unsigned char> >& entry) {
+    Writer writer;
+    writer.finished = std::make_shared<std::atomic<bool> >(false);
+
+    std::shared_ptr<std::atomic<bool> > finished = writer.finished;
+    writer.thread = std::thread([path, entry, finished] {
+        write(path, *entry);
+        finished->store(true);
+    });
+
+    m_writers.push_back(std::move(writer));
+}
+
+void MeshCache::joinFinishedWriters() {
+
+    // a scene may load many models, so we don't keep a thread around for each
+    for (std::vector<Writer>::iterator it = m_writers.begin(); it != m_writers.end();) {
+        if (it->finished->load()) {
+            it->thread.join();
+            it = m_writers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MeshCache::write(const std::string& path, const std::vector<unsigned char>& entry) {
+
+    //
+    // Several processes may miss on the same entry, e.g., with --multi-process, and so
+    // may several threads of one, e.g., IngestPipeline's workers, so each writes a file
+    // of its own and renames it into place, which replaces any other entry in one step.
+    //
+    std::string temporaryPath = path + "." + std::to_string(getpid()) + "." + std::to_string(s_temporaryFiles++) + ".tmp";
+
+    int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+        mojo::printf("Cannot create mesh cache entry ", temporaryPath, ": ", std::strerror(errno));
+        return;
+    }
+
+    std::size_t written = 0;
+
+    while (written < entry.size()) {
+        ssize_t result = ::write(fd, &entry[written], entry.size() - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (result <= 0) {
+            break;
+        }
+
+        written += (std::size_t)result;
+    }
+
+    bool stored = close(fd) == 0 && written == entry.size() && rename(temporaryPath.c_str(), path.c_str()) == 0;
+    if (!stored) {
+        mojo::printf("Cannot write mesh cache entry ", path, ": ", std::strerror(errno));
+        unlink(temporaryPath.c_str());
+    }
+}
+
+}
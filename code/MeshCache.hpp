@@ -0,0 +1,195 @@
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <G3D/G3D.h>
+#include <GLG3D/GLG3D.h>
+
+#include "FlatMesh.hpp"
+
+namespace mojo
+{
+
+//
+// MeshCache keeps G3D::ArticulatedModels on disk the way they are after loading and
+// preprocessing: the parts with their frames, and the vertices and indices of every
+// geometry and mesh, in flat arrays. Entries are named after a hash of the contents
+// of the source file and of the G3D::ArticulatedModel::Specification, so editing
+// either simply misses.
+//
+// On a miss, create(...) loads the model with G3D::ArticulatedModel::create(...) as
+// usual, flattens it into an entry and writes the entry on a thread of its own. On
+// a hit, it maps the entry and builds the model straight from the mapping, so a warm
+// load costs reading the file rather than parsing text. Large source files are hashed
+// on several threads, see ContentHash.hpp.
+//
+// Models loaded with stripMaterials are cached, and get the default material G3D
+// gives them. So are OBJ models with materials, such as most CAD exports, as long as
+// the Specification asks for nothing but the file: G3D::UniversalMaterial doesn't
+// keep the Specification it was created from, so instead those are parsed with
+// parseOBJ(...), and each mesh keeps a reference to its material, the .mtl file and
+// the material's name. On a hit, the .mtl files are parsed again with G3D::ParseMTL
+// and each material gets its diffuse map or color, as IngestPipeline gives them.
+// Other models with materials are loaded with G3D::ArticulatedModel::create(...) as
+// if there were no cache, logged, and counted by bypasses(). Of the vertex
+// attributes, positions, normals, tangents and the first texture coordinates are
+// cached.
+//
+// create(...) must be called with the OpenGL context current, like
+// G3D::ArticulatedModel::create(...). createMeshes(...) is for OBJ files that are
+// loaded on other threads, e.g., those dropped on a G3DWidget, and shares entries
+// with create(...).
+//
+class MeshCache
+{
+public:
+    //
+    // Returns a directory in the user's cache directory, creating it if needed.
+    //
+    static std::string defaultDirectory();
+
+    explicit MeshCache(const std::string& directory);
+
+    //
+    // Waits for the entries that are still being written.
+    //
+    ~MeshCache();
+
+    std::shared_ptr<G3D::ArticulatedModel> create(const G3D::ArticulatedModel::Specification& specification);
+
+    //
+    // Fills meshes from the entry of the OBJ file at path on a hit, and on a miss
+    // parses data, the file's contents, with parseOBJ(...) and writes the entry
+    // before returning. The meshes' materials are loaded either way, see
+    // loadMaterials(...). Returns what parseOBJ(...) would. Can be called from any
+    // thread, concurrently with create(...), without the OpenGL context.
+    //
+    bool createMeshes(const std::string& path, const char* data, std::size_t size, std::vector<FlatMesh>& meshes, std::string& error, const std::function<bool (float)>& progress);
+
+    const std::string& directory() const;
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+    std::uint64_t bypasses() const;
+
+private:
+    static const std::uint32_t kMagic   = 0x6d6d7363;
+    static const std::uint32_t kVersion = 2;
+
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::int32_t  partCount;
+        std::int32_t  geometryCount;
+        std::int32_t  meshCount;
+        std::int32_t  reserved;
+        std::uint64_t partsOffset;
+        std::uint64_t geometriesOffset;
+        std::uint64_t meshesOffset;
+        std::uint64_t namesOffset;
+        std::uint64_t namesSize;
+    };
+
+    struct Name
+    {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    struct PartRecord
+    {
+        Name          name;
+        std::int32_t  parent;
+        float         rotation[9];
+        float         translation[3];
+    };
+
+    struct VertexRecord
+    {
+        float         position[3];
+        float         normal[3];
+        float         tangent[4];
+        float         texCoord0[2];
+    };
+
+    struct GeometryRecord
+    {
+        Name          name;
+        std::int32_t  hasTangent;
+        std::int32_t  hasTexCoord0;
+        std::uint64_t verticesOffset;
+        std::uint64_t vertexCount;
+    };
+
+    struct MeshRecord
+    {
+        Name          name;
+        std::int32_t  part;
+        std::int32_t  geometry;
+        std::int32_t  primitive;
+        std::int32_t  twoSided;
+        std::uint64_t indicesOffset;
+        std::uint64_t indexCount;
+        Name          materialLibrary;
+        Name          materialName;
+    };
+
+    // the records of an entry, which point into the model they were made from for the vertices and indices
+    struct Contents
+    {
+        std::vector<PartRecord>                         parts;
+        std::vector<GeometryRecord>                     geometries;
+        std::vector<MeshRecord>                         meshes;
+        std::string                                     names;
+        std::vector<const G3D::CPUVertexArray::Vertex*> vertices;
+        std::vector<const int*>                         indices;
+    };
+
+    // a thread writing an entry, which sets finished once it is done
+    struct Writer
+    {
+        std::thread                         thread;
+        std::shared_ptr<std::atomic<bool> > finished;
+    };
+
+    static bool cachesMaterials(const G3D::ArticulatedModel::Specification& specification);
+    static G3D::ArticulatedModel::Specification objSpecification(const std::string& path);
+
+    std::string entryPath(const G3D::ArticulatedModel::Specification& specification) const;
+
+    std::shared_ptr<G3D::ArticulatedModel> createWithMaterials(const G3D::ArticulatedModel::Specification& specification);
+
+    const unsigned char* mapEntry(const std::string& path, std::size_t& size) const;
+    std::shared_ptr<G3D::ArticulatedModel> load(const std::string& path, const G3D::ArticulatedModel::Specification& specification) const;
+    bool loadMeshes(const std::string& path, std::vector<FlatMesh>& meshes) const;
+    void store(const std::string& path, const std::shared_ptr<std::vector<unsigned char> >& entry);
+    void joinFinishedWriters();
+
+    static Contents flatten(const G3D::ArticulatedModel& model);
+    static Contents flatten(const std::vector<FlatMesh>& meshes);
+    static std::shared_ptr<std::vector<unsigned char> > serialize(const Contents& contents);
+    static std::shared_ptr<G3D::ArticulatedModel> createModel(const G3D::String& name, const std::vector<FlatMesh>& meshes);
+    static void write(const std::string& path, const std::vector<unsigned char>& entry);
+
+    std::string                m_directory;
+
+    // counted by create(...) and by the threads that call createMeshes(...)
+    std::atomic<std::uint64_t> m_hits;
+    std::atomic<std::uint64_t> m_misses;
+    std::atomic<std::uint64_t> m_bypasses;
+
+    // only used by create(...)
+    std::vector<Writer>        m_writers;
+};
+
+}
+
+#endif
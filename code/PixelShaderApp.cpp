@@ -1,16 +1,74 @@
 #include "PixelShaderApp.hpp"
 
+#include "FrameArena.hpp"
+#include "FrameProfiler.hpp"
+#include "MeshCache.hpp"
+#include "Printf.hpp"
+#include "ShaderWatcher.hpp"
+#include "TextureCache.hpp"
+#include "VideoTextureSource.hpp"
+
 namespace G3D
 {
 
+/** How long the result of a shader reload stays on screen. */
+static const RealTime kShaderStatusDuration = 4.0;
+
+
 PixelShaderApp::PixelShaderApp(const Settings& options, OSWindow* window, RenderDevice* rd) :
     GApp(options, window, rd),
     lambertianScalar(0.6f),
     glossyScalar(0.5f),
     reflect(0.1f),
-    smoothness(0.2f) {
+    smoothness(0.2f),
+    shaderStatusTime(0) {
+}
+
+void PixelShaderApp::setShaderWatcher(const shared_ptr<mojo::ShaderWatcher>& watcher) {
+    shaderWatcher = watcher;
+
+    if (notNull(shaderWatcher)) {
+        shaderWatcher->watch("phong");
+    }
+}
+
+
+void PixelShaderApp::setTextureCache(const shared_ptr<mojo::TextureCache>& cache) {
+    textureCache = cache;
+}
+
+
+void PixelShaderApp::setMeshCache(const shared_ptr<mojo::MeshCache>& cache) {
+    meshCache = cache;
+}
+
+
+void PixelShaderApp::setVideoEnvironment(const String& filename) {
+    if (notNull(videoEnvironment)) {
+        videoEnvironment->cleanup();
+    }
+
+    // Logs why and keeps the environment map if the file cannot be played
+    videoEnvironment = mojo::VideoTextureSource::create(filename.c_str());
+}
+
+
+const shared_ptr<mojo::VideoTextureSource>& PixelShaderApp::videoEnvironmentSource() const {
+    return videoEnvironment;
 }
 
+
+void PixelShaderApp::setModel(const shared_ptr<ArticulatedModel>& newModel) {
+    debugAssert(notNull(newModel));
+    model = newModel;
+}
+
+
+void PixelShaderApp::setEnvironmentImage(const shared_ptr<Texture>& texture) {
+    environmentImage = texture;
+}
+
+
 void PixelShaderApp::onInit() {
     GApp::onInit();
     createDeveloperHUD();
@@ -23,7 +81,11 @@ void PixelShaderApp::onInit() {
     spec.scale = 0.015f;
     spec.stripMaterials = true;
     spec.preprocess.append(ArticulatedModel::Instruction(Any::parse("setCFrame(root(), Point3(0, -0.5, 0));")));
-    model = ArticulatedModel::create(spec);
+
+    // The cache stores the teapot already parsed and preprocessed, so a warm start skips the OBJ parser
+    model = notNull(meshCache) ? meshCache->create(spec) : ArticulatedModel::create(spec);
+
+    phongShader = Shader::getShaderFromPattern("phong.*");
 
     makeLighting();
     makeColorList();
@@ -50,10 +112,31 @@ void PixelShaderApp::onInit() {
 }
 
 
+void PixelShaderApp::onSimulation(RealTime rdt, SimTime sdt, SimTime idt) {
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_SIMULATION);
+
+    GApp::onSimulation(rdt, sdt, idt);
+}
+
+
+void PixelShaderApp::onPose(Array<shared_ptr<Surface> >& posed3D, Array<shared_ptr<Surface2D> >& posed2D) {
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_POSE);
+
+    GApp::onPose(posed3D, posed2D);
+}
+
+
 void PixelShaderApp::onGraphics3D(RenderDevice* rd, Array<shared_ptr<Surface> >& surface3D) {
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_GRAPHICS_3D);
+
+    reloadChangedShaders(rd);
+
+    if (notNull(videoEnvironment)) {
+        videoEnvironment->update(simTime());
+    }
 
-    m_gbuffer->setSpecification(m_gbufferSpecification);
-    m_gbuffer->resize(m_framebuffer->width(), m_framebuffer->height());
+    renderTargetSetup.beginFrame();
+    renderTargetSetup.setupGBuffer(m_gbuffer, m_gbufferSpecification, m_framebuffer->width(), m_framebuffer->height());
     m_gbuffer->prepare(rd, activeCamera(), 0, -(float)previousSimTimeStep(), m_settings.depthGuardBandThickness, m_settings.colorGuardBandThickness);
 
     m_renderer->render(rd, m_framebuffer, m_depthPeelFramebuffer, scene()->lightingEnvironment(), m_gbuffer, surface3D);
@@ -61,12 +144,15 @@ void PixelShaderApp::onGraphics3D(RenderDevice* rd, Array<shared_ptr<Surface> >&
     rd->pushState(m_framebuffer); {
 
         rd->setProjectionAndCameraMatrix(m_debugCamera->projection(), m_debugCamera->frame());
+        // The surfaces only live for this frame, so they come from the frame arena
         Array< shared_ptr<Surface> > mySurfaces;
+        mySurfaces.clearAndSetMemoryManager(mojo::FrameArena::memoryManager());
+
         // Pose our model based on the manipulator axes
         model->pose(mySurfaces, manipulator->frame());
 
         // Set up shared arguments
-        Args args;
+        Args& args = phongArgs;
         configureShaderArgs(args);
 
         // Send model geometry to the graphics card
@@ -82,7 +168,7 @@ void PixelShaderApp::onGraphics3D(RenderDevice* rd, Array<shared_ptr<Surface> >&
 
                 // (If you want to manually set the material properties and vertex attributes
                 // for shader args, they can be accessed from the fields of the gpuGeom.)
-                LAUNCH_SHADER("phong.*", args);
+                rd->apply(phongShader, args);
             }
         }
     } rd->popState();
@@ -95,6 +181,113 @@ void PixelShaderApp::onGraphics3D(RenderDevice* rd, Array<shared_ptr<Surface> >&
 
     rd->clear();
     m_film->exposeAndRender(rd, m_debugCamera->filmSettings(), m_framebuffer->texture(0), 1);
+
+    if (! shaderStatus.empty()) {
+        if (System::time() - shaderStatusTime < kShaderStatusDuration) {
+            screenPrintf("%s", shaderStatus.c_str());
+        } else {
+            shaderStatus.clear();
+        }
+    }
+
+    if (notNull(videoEnvironment)) {
+        screenPrintf("video: %d frames presented, %d dropped",
+            (int)videoEnvironment->presentedFrames(), (int)videoEnvironment->droppedFrames());
+    }
+
+    screenPrintf("render targets: %d reallocations this frame, %llu in total",
+        renderTargetSetup.appliedChanges(), (unsigned long long)renderTargetSetup.totalAppliedChanges());
+}
+
+
+void PixelShaderApp::reloadChangedShaders(RenderDevice* rd) {
+    mojo::ShaderWatcher::Sources sources;
+
+    if (isNull(shaderWatcher) || ! shaderWatcher->takeChangedSources("phong", sources)) {
+        return;
+    }
+
+    // The sources were read on the watcher's thread
+    Shader::Specification specification;
+    specification.shaderStage[Shader::VERTEX] = Shader::Source(Shader::STRING, sources.vertex.c_str());
+    specification.shaderStage[Shader::PIXEL]  = Shader::Source(Shader::STRING, sources.pixel.c_str());
+    shared_ptr<Shader> candidate = Shader::create(specification);
+
+    //
+    // A shader is compiled by its first apply(...), so we apply the reloaded one to the
+    // model here, before the frame is drawn, with every write disabled. If it fails to
+    // compile, we keep drawing with the previous shader, so a typo in the shader never
+    // takes down the app. Either way, we only try each reloaded shader once.
+    //
+    Array<shared_ptr<Surface> > surfaces;
+    model->pose(surfaces, manipulator->frame());
+
+    shared_ptr<UniversalSurface> surface = surfaces.size() > 0 ? dynamic_pointer_cast<UniversalSurface>(surfaces[0]) : shared_ptr<UniversalSurface>();
+    if (isNull(surface)) {
+        return;
+    }
+
+    Args args;
+    configureShaderArgs(args);
+    surface->gpuGeom()->setShaderArgs(args);
+
+    RealTime                begin           = System::time();
+    Shader::FailureBehavior failureBehavior = Shader::failureBehavior();
+    String                  error;
+
+    Shader::setFailureBehavior(Shader::EXCEPTION);
+    rd->pushState(); {
+        rd->setColorWrite(false);
+        rd->setDepthWrite(false);
+
+        try {
+            rd->apply(candidate, args);
+        } catch (const std::exception& e) {
+            error = e.what();
+        } catch (const String& message) {
+            error = message;
+        } catch (...) {
+            error = "unknown error";
+        }
+    } rd->popState();
+    Shader::setFailureBehavior(failureBehavior);
+
+    shaderStatusTime = System::time();
+
+    if (error.empty()) {
+        phongShader  = candidate;
+        shaderStatus = format("phong shader reloaded in %.1f ms", (shaderStatusTime - begin) * 1000.0);
+        mojo::printf(shaderStatus.c_str());
+        return;
+    }
+
+    shaderStatus = "phong shader failed to compile, keeping the previous version (see log)";
+    mojo::printf("phong shader failed to compile:\n", error.c_str());
+}
+
+
+void PixelShaderApp::onGraphics2D(RenderDevice* rd, Array<shared_ptr<Surface2D> >& surface2D) {
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_GRAPHICS_2D);
+
+    guiLayer.render(rd, surface2D);
+}
+
+
+bool PixelShaderApp::onEvent(const GEvent& e) {
+    guiLayer.onEvent(e);
+    return GApp::onEvent(e);
+}
+
+
+void PixelShaderApp::onCleanup() {
+    // The video's texture and pixel buffers need the OpenGL context, which is gone by the destructor
+    if (notNull(videoEnvironment)) {
+        videoEnvironment->cleanup();
+        videoEnvironment.reset();
+    }
+    environmentImage.reset();
+
+    GApp::onCleanup();
 }
 
 
@@ -113,6 +306,13 @@ void PixelShaderApp::configureShaderArgs(Args& args) {
     args.setUniform("ambient",              Color3(0.3f));
     args.setUniform("environmentMap",       scene()->lightingEnvironment().environmentMapArray[0], Sampler::cubeMap());
 
+    const shared_ptr<Texture>& equirectangularEnvironment = notNull(videoEnvironment) ? videoEnvironment->texture() : environmentImage;
+    if (notNull(equirectangularEnvironment)) {
+        // Neither video frames nor dropped images have MIP maps, and both wrap around horizontally
+        args.setMacro("VIDEO_ENVIRONMENT", 1);
+        args.setUniform("videoEnvironmentMap", equirectangularEnvironment, Sampler(WrapMode::TILE, InterpolateMode::BILINEAR_NO_MIPMAP));
+    }
+
     // Material
     args.setUniform("lambertianColor",      lambertianColor);
     args.setUniform("lambertianScalar",     lambertianScalar);
@@ -177,7 +377,10 @@ void PixelShaderApp::makeLighting() {
 
     environmentMapTexture.preprocess = Texture::Preprocess::gamma(2.1f);
     environmentMapTexture.generateMipMaps = true;
-    scene()->lightingEnvironment().environmentMapArray.append(Texture::create(environmentMapTexture));
+
+    // The cache stores the faces already preprocessed and with their MIP maps, so a warm start skips all of that
+    shared_ptr<Texture> environmentMap = notNull(textureCache) ? textureCache->create(environmentMapTexture) : Texture::create(environmentMapTexture);
+    scene()->lightingEnvironment().environmentMapArray.append(environmentMap);
     scene()->insert(Skybox::create("Skybox", &*scene(), scene()->lightingEnvironment().environmentMapArray, Array<SimTime>(0), 0.0f, SplineExtrapolationMode::CLAMP, false, false));
 }
 
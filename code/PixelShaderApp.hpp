@@ -4,6 +4,17 @@
 #include "G3D/G3D.h"
 #include "GLG3D/GLG3D.h"
 
+#include "CachedGUILayer.hpp"
+#include "RenderTargetSetup.hpp"
+
+namespace mojo
+{
+class MeshCache;
+class ShaderWatcher;
+class TextureCache;
+class VideoTextureSource;
+}
+
 namespace G3D
 {
 
@@ -20,6 +31,36 @@ private:
     float                                reflect;
     float                                smoothness;
 
+    /** The phong shader that is drawn with. Replaced only by a reloaded shader that compiled. */
+    shared_ptr<Shader>                   phongShader;
+
+    shared_ptr<mojo::ShaderWatcher>      shaderWatcher;
+
+    /** Whether the last reload compiled, shown for a few seconds from shaderStatusTime. */
+    String                               shaderStatus;
+    RealTime                             shaderStatusTime;
+
+    /** When set, the environment map is loaded through it. */
+    shared_ptr<mojo::TextureCache>       textureCache;
+
+    /** When set, the teapot is loaded through it. */
+    shared_ptr<mojo::MeshCache>          meshCache;
+
+    /** Reused by every frame, so setting the same uniforms again doesn't allocate. */
+    Args                                 phongArgs;
+
+    /** Sets up m_gbuffer each frame and counts the changes that reallocate it. */
+    mojo::RenderTargetSetup              renderTargetSetup;
+
+    /** When set, the reflections show this video instead of the environment map. */
+    shared_ptr<mojo::VideoTextureSource> videoEnvironment;
+
+    /** When set, and there is no video, the reflections show this image instead of the environment map. */
+    shared_ptr<Texture>                  environmentImage;
+
+    /** Renders the "Material Parameters" window and the developer HUD only when they may have changed. */
+    mojo::CachedGUILayer                 guiLayer;
+
     ////////////////////////////////////
     // GUI
 
@@ -31,13 +72,40 @@ private:
     void makeColorList();
     void makeLighting();
     void configureShaderArgs(Args& args);
+    void reloadChangedShaders(RenderDevice* rd);
 
 public:
 
     PixelShaderApp(const Settings& options=Settings(), OSWindow* window=NULL, RenderDevice* rd=NULL);
 
+    /** Reloads phong.vrt and phong.pix from the watcher's directory when they change. */
+    void setShaderWatcher(const shared_ptr<mojo::ShaderWatcher>& watcher);
+
+    /** Loads the environment map through the cache. Must be called before onInit(). */
+    void setTextureCache(const shared_ptr<mojo::TextureCache>& cache);
+
+    /** Loads the teapot through the cache. Must be called before onInit(). */
+    void setMeshCache(const shared_ptr<mojo::MeshCache>& cache);
+
+    /** Plays the video as an equirectangular environment in the reflections. Must be called with the OpenGL context current. */
+    void setVideoEnvironment(const String& filename);
+
+    /** The video setVideoEnvironment() plays, or null if there is none or it could not be played. */
+    const shared_ptr<mojo::VideoTextureSource>& videoEnvironmentSource() const;
+
+    /** Replaces the teapot, e.g., with a model that mojo::IngestPipeline loaded after it was dropped on the window. */
+    void setModel(const shared_ptr<ArticulatedModel>& model);
+
+    /** Shows an equirectangular image in the reflections, like setVideoEnvironment() does with a video. */
+    void setEnvironmentImage(const shared_ptr<Texture>& texture);
+
     virtual void onInit();
+    virtual void onSimulation(RealTime rdt, SimTime sdt, SimTime idt);
+    virtual void onPose(Array<shared_ptr<Surface> >& posed3D, Array<shared_ptr<Surface2D> >& posed2D);
     virtual void onGraphics3D(RenderDevice* rd, Array<shared_ptr<Surface> >& surface3D);
+    virtual void onGraphics2D(RenderDevice* rd, Array<shared_ptr<Surface2D> >& surface2D);
+    virtual bool onEvent(const GEvent& e);
+    virtual void onCleanup();
 };
 
 }
@@ -1,13 +1,24 @@
 #include "Printf.hpp"
 
 #include <string>
-#include <iostream>
+
+#include "Log.hpp"
 
 namespace mojo
 {
 
+std::string& printfBuffer() {
+    static thread_local std::string buffer;
+    return buffer;
+}
+
+int& printfDepth() {
+    static thread_local int depth = 0;
+    return depth;
+}
+
 void printfHelper(const std::string& string) {
-    std::cout << string << std::endl;
+    logLine(string.data(), string.size());
 }
 
 }
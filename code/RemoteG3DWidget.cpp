@@ -0,0 +1,412 @@
+#include "RemoteG3DWidget.hpp"
+
+#include <algorithm>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMetaObject>
+#include <QtCore/QMimeData>
+#include <QtCore/QStringList>
+#include <QtCore/QUrl>
+#include <QtGui/QDragEnterEvent>
+#include <QtGui/QDropEvent>
+#include <QtGui/QFocusEvent>
+#include <QtGui/QImage>
+#include <QtGui/QKeyEvent>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QPainter>
+#include <QtGui/QWheelEvent>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include "Printf.hpp"
+#include "QtUtil.hpp"
+#include "SharedFrameRing.hpp"
+
+namespace mojo
+{
+
+int RemoteG3DWidget::s_count = 0;
+
+RemoteG3DWidget::RemoteG3DWidget(const QString& appName, QWidget* parent) :
+    QWidget               (parent),
+    m_appName             (appName),
+    m_sharedFrameRingCount(0),
+    m_server              (new QLocalServer(this)),
+    m_socket              (NULL),
+    m_process             (new QProcess(this)),
+    m_stopping            (false),
+    m_framesShown         (0),
+    m_lastFrameNumber     (0),
+    m_framesSkipped       (0) {
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFocusPolicy(Qt::StrongFocus);
+    setMouseTracking(true);
+    setAcceptDrops(true);
+}
+
+RemoteG3DWidget::~RemoteG3DWidget() {
+    stopWatchingFrames();
+
+    //
+    // The RenderProcess quits when we disconnect. We give it a moment to clean up, so
+    // it doesn't outlive us holding on to the SharedFrameRing.
+    //
+    m_process->disconnect(this);
+
+    if (m_socket != NULL) {
+        m_socket->disconnectFromServer();
+    }
+
+    if (m_process->state() != QProcess::NotRunning && !m_process->waitForFinished(kTerminateTimeoutMilliseconds)) {
+        m_process->kill();
+        m_process->waitForFinished(kTerminateTimeoutMilliseconds);
+    }
+}
+
+bool RemoteG3DWidget::start() {
+    MOJO_RELEASE_ASSERT(!m_sharedFrameRing);
+
+    int index = s_count++;
+    m_sharedFrameRingPrefix = "/mojo." + std::to_string(QCoreApplication::applicationPid()) + "." + std::to_string(index);
+
+    if (!growSharedFrameRing()) {
+        return false;
+    }
+
+    QString serverName = QString("mojo-%1-%2").arg(QCoreApplication::applicationPid()).arg(index);
+
+    // a server left behind by a process that crashed would otherwise make listen(...) fail
+    QLocalServer::removeServer(serverName);
+
+    if (!m_server->listen(serverName)) {
+        mojo::printf("Cannot listen on ", serverName.toUtf8().constData(), ": ", m_server->errorString().toUtf8().constData());
+        return false;
+    }
+
+    MOJO_QT_SAFE(connect(m_server, SIGNAL(newConnection()), this, SLOT(onNewConnection())));
+    MOJO_QT_SAFE(connect(m_process, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onProcessFinished(int, QProcess::ExitStatus))));
+
+    QStringList arguments;
+    arguments << "--render-process" << m_appName << serverName;
+
+    m_process->setProcessChannelMode(QProcess::ForwardedChannels);
+    m_process->start(QCoreApplication::applicationFilePath(), arguments);
+
+    return true;
+}
+
+std::uint64_t RemoteG3DWidget::framesShown() const {
+    return m_framesShown;
+}
+
+std::uint64_t RemoteG3DWidget::framesSkipped() const {
+    return m_framesSkipped;
+}
+
+void RemoteG3DWidget::paintEvent(QPaintEvent*) {
+    QPainter painter(this);
+
+    if (m_sharedFrameRing && m_sharedFrameRing->acquireLatest()) {
+        std::uint64_t frameNumber = m_sharedFrameRing->frameNumber();
+        if (m_lastFrameNumber != 0 && frameNumber > m_lastFrameNumber + 1) {
+            m_framesSkipped += frameNumber - m_lastFrameNumber - 1;
+        }
+
+        m_lastFrameNumber = frameNumber;
+        ++m_framesShown;
+
+        m_retiredSharedFrameRing.reset();
+    }
+
+    SharedFrameRing* sharedFrameRing = m_lastFrameNumber != 0 ? m_sharedFrameRing.get() : m_retiredSharedFrameRing.get();
+    if (sharedFrameRing == NULL) {
+        painter.fillRect(rect(), Qt::black);
+        return;
+    }
+
+    //
+    // The QImage refers to the slot we acquired, which the RenderProcess won't write
+    // to until we acquire the next one. The frame is in device pixels, top row first,
+    // so it is drawn as is. Right after a resize, it may not cover all of us yet.
+    //
+    int    frameWidth  = sharedFrameRing->frameWidth();
+    int    frameHeight = sharedFrameRing->frameHeight();
+    QImage image(sharedFrameRing->framePixels(), frameWidth, frameHeight, frameWidth * 4, QImage::Format_RGBX8888);
+    image.setDevicePixelRatio(devicePixelRatio());
+
+    QSize size = deviceSize();
+    if (frameWidth < size.width() || frameHeight < size.height()) {
+        painter.fillRect(rect(), Qt::black);
+    }
+
+    painter.drawImage(QPoint(0, 0), image);
+}
+
+void RemoteG3DWidget::resizeEvent(QResizeEvent*) {
+
+    // the RenderProcess needs somewhere to write frames of the new size first
+    if (m_sharedFrameRing) {
+        growSharedFrameRing();
+    }
+
+    sendResize();
+}
+
+void RemoteG3DWidget::enterEvent(QEvent*) {
+    setFocus(Qt::OtherFocusReason);
+}
+
+void RemoteG3DWidget::mousePressEvent(QMouseEvent* e) {
+    sendMouseEvent(RemoteInputMessage::TYPE_MOUSE_PRESS, e);
+}
+
+void RemoteG3DWidget::mouseReleaseEvent(QMouseEvent* e) {
+    sendMouseEvent(RemoteInputMessage::TYPE_MOUSE_RELEASE, e);
+}
+
+void RemoteG3DWidget::mouseMoveEvent(QMouseEvent* e) {
+    sendMouseEvent(RemoteInputMessage::TYPE_MOUSE_MOVE, e);
+}
+
+void RemoteG3DWidget::wheelEvent(QWheelEvent* e) {
+    RemoteInputMessage message = RemoteInputMessage();
+    message.type      = RemoteInputMessage::TYPE_WHEEL;
+    message.x         = e->pos().x();
+    message.y         = e->pos().y();
+    message.deltaX    = e->angleDelta().x();
+    message.deltaY    = e->angleDelta().y();
+    message.buttons   = (int)e->buttons();
+    message.modifiers = (int)e->modifiers();
+    message.timestamp = (std::uint32_t)e->timestamp();
+
+    send(message);
+}
+
+void RemoteG3DWidget::keyPressEvent(QKeyEvent* e) {
+    sendKeyEvent(RemoteInputMessage::TYPE_KEY_PRESS, e);
+}
+
+void RemoteG3DWidget::keyReleaseEvent(QKeyEvent* e) {
+    sendKeyEvent(RemoteInputMessage::TYPE_KEY_RELEASE, e);
+}
+
+void RemoteG3DWidget::dragEnterEvent(QDragEnterEvent* e) {
+    if (e->mimeData()->hasUrls()) {
+        e->acceptProposedAction();
+    }
+}
+
+void RemoteG3DWidget::dropEvent(QDropEvent* e) {
+
+    // both processes run on the same machine, so local paths mean the same to both
+    QStringList paths;
+    Q_FOREACH(QUrl url, e->mimeData()->urls()) {
+        paths.append(url.toLocalFile());
+    }
+
+    e->acceptProposedAction();
+
+    RemoteInputMessage message = RemoteInputMessage();
+    message.type = RemoteInputMessage::TYPE_DROP;
+    message.x    = e->pos().x();
+    message.y    = e->pos().y();
+
+    send(message, paths.join('\n').toUtf8());
+}
+
+void RemoteG3DWidget::focusInEvent(QFocusEvent* e) {
+    sendFocus();
+    QWidget::focusInEvent(e);
+}
+
+void RemoteG3DWidget::focusOutEvent(QFocusEvent* e) {
+    sendFocus();
+    QWidget::focusOutEvent(e);
+}
+
+void RemoteG3DWidget::changeEvent(QEvent* e) {
+    if (e->type() == QEvent::ActivationChange) {
+        sendWindowActive();
+    }
+
+    QWidget::changeEvent(e);
+}
+
+void RemoteG3DWidget::onNewConnection() {
+    QLocalSocket* socket = m_server->nextPendingConnection();
+
+    // only our RenderProcess knows the server name, and it connects once
+    if (m_socket != NULL) {
+        socket->disconnectFromServer();
+        return;
+    }
+
+    m_socket = socket;
+
+    // events before the connection were dropped, but the RenderProcess needs these
+    sendSharedFrameRing();
+    sendResize();
+    sendWindowActive();
+    sendFocus();
+}
+
+void RemoteG3DWidget::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus) {
+    mojo::printf("The render process for ", m_appName.toUtf8().constData(), exitStatus == QProcess::CrashExit ? " crashed" : " exited", " with ", exitCode);
+}
+
+QSize RemoteG3DWidget::deviceSize() const {
+
+    // as G3DWidget::width() and G3DWidget::height() round them
+    return QSize((int)(width() * devicePixelRatio()), (int)(height() * devicePixelRatio()));
+}
+
+bool RemoteG3DWidget::growSharedFrameRing() {
+    QSize size = deviceSize();
+
+    int maxWidth  = m_sharedFrameRing ? m_sharedFrameRing->maxWidth()  : 0;
+    int maxHeight = m_sharedFrameRing ? m_sharedFrameRing->maxHeight() : 0;
+
+    if (size.width() <= maxWidth && size.height() <= maxHeight) {
+        return true;
+    }
+
+    //
+    // We round up, so resizing the window doesn't create a ring for every pixel it
+    // grows by, and never shrink, since the window is likely to grow again.
+    //
+    maxWidth  = std::max(maxWidth,  (size.width()  / kSharedFrameRingGranularity + 1) * kSharedFrameRingGranularity);
+    maxHeight = std::max(maxHeight, (size.height() / kSharedFrameRingGranularity + 1) * kSharedFrameRingGranularity);
+
+    std::string                      name            = m_sharedFrameRingPrefix + "." + std::to_string(m_sharedFrameRingCount++);
+    std::shared_ptr<SharedFrameRing> sharedFrameRing = SharedFrameRing::create(name, maxWidth, maxHeight);
+
+    // the RenderProcess keeps writing to the old ring, clipping the frames to it
+    if (!sharedFrameRing) {
+        return false;
+    }
+
+    stopWatchingFrames();
+
+    if (m_lastFrameNumber != 0) {
+        m_retiredSharedFrameRing = m_sharedFrameRing;
+    }
+
+    m_sharedFrameRing = sharedFrameRing;
+    m_lastFrameNumber = 0;
+
+    startWatchingFrames();
+    sendSharedFrameRing();
+
+    return true;
+}
+
+void RemoteG3DWidget::sendMouseEvent(RemoteInputMessage::Type type, const QMouseEvent* mouseEvent) {
+    RemoteInputMessage message = RemoteInputMessage();
+    message.type      = type;
+    message.x         = mouseEvent->pos().x();
+    message.y         = mouseEvent->pos().y();
+    message.button    = (int)mouseEvent->button();
+    message.buttons   = (int)mouseEvent->buttons();
+    message.modifiers = (int)mouseEvent->modifiers();
+    message.timestamp = (std::uint32_t)mouseEvent->timestamp();
+
+    send(message);
+}
+
+void RemoteG3DWidget::sendKeyEvent(RemoteInputMessage::Type type, const QKeyEvent* keyEvent) {
+    RemoteInputMessage message = RemoteInputMessage();
+    message.type             = type;
+    message.key              = keyEvent->key();
+    message.modifiers        = (int)keyEvent->modifiers();
+    message.nativeScanCode   = keyEvent->nativeScanCode();
+    message.nativeVirtualKey = keyEvent->nativeVirtualKey();
+    message.nativeModifiers  = keyEvent->nativeModifiers();
+    message.timestamp        = (std::uint32_t)keyEvent->timestamp();
+    message.flag             = keyEvent->isAutoRepeat() ? 1 : 0;
+
+    QString text       = keyEvent->text().left(RemoteInputMessage::kMaxTextLength);
+    message.textLength = text.size();
+    for (int i = 0; i < text.size(); ++i) {
+        message.text[i] = text.at(i).unicode();
+    }
+
+    send(message);
+}
+
+void RemoteG3DWidget::sendResize() {
+    RemoteInputMessage message = RemoteInputMessage();
+    message.type             = RemoteInputMessage::TYPE_RESIZE;
+    message.x                = width();
+    message.y                = height();
+    message.devicePixelRatio = devicePixelRatio();
+
+    send(message);
+}
+
+void RemoteG3DWidget::sendWindowActive() {
+    RemoteInputMessage message = RemoteInputMessage();
+    message.type = RemoteInputMessage::TYPE_WINDOW_ACTIVE;
+    message.flag = isActiveWindow() ? 1 : 0;
+
+    send(message);
+}
+
+void RemoteG3DWidget::sendFocus() {
+    RemoteInputMessage message = RemoteInputMessage();
+    message.type = RemoteInputMessage::TYPE_FOCUS;
+    message.flag = hasFocus() ? 1 : 0;
+
+    send(message);
+}
+
+void RemoteG3DWidget::sendSharedFrameRing() {
+    RemoteInputMessage message = RemoteInputMessage();
+    message.type = RemoteInputMessage::TYPE_SHARED_FRAME_RING;
+
+    send(message, QByteArray::fromStdString(m_sharedFrameRing->name()));
+}
+
+void RemoteG3DWidget::send(const RemoteInputMessage& message, const QByteArray& payload) {
+    if (m_socket == NULL) {
+        return;
+    }
+
+    RemoteInputMessage sized = message;
+    sized.payloadSize = payload.size();
+
+    m_socket->write((const char*)&sized, sizeof(sized));
+    if (!payload.isEmpty()) {
+        m_socket->write(payload);
+    }
+}
+
+void RemoteG3DWidget::startWatchingFrames() {
+    m_stopping.store(false);
+    m_frameWatcher = std::thread(&RemoteG3DWidget::watchFrames, this);
+}
+
+void RemoteG3DWidget::stopWatchingFrames() {
+    if (!m_frameWatcher.joinable()) {
+        return;
+    }
+
+    m_stopping.store(true);
+    m_sharedFrameRing->wake();
+    m_frameWatcher.join();
+}
+
+void RemoteG3DWidget::watchFrames() {
+    for (;;) {
+        m_sharedFrameRing->waitForFrame();
+
+        if (m_stopping.load()) {
+            return;
+        }
+
+        // repaints are coalesced, so this is cheap even if we fall behind
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    }
+}
+
+}
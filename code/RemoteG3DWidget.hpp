@@ -0,0 +1,120 @@
+#ifndef REMOTE_G3D_WIDGET_HPP
+#define REMOTE_G3D_WIDGET_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QProcess>
+#include <QtWidgets/QWidget>
+
+#include "RemoteInputMessage.hpp"
+
+class QLocalServer;
+class QLocalSocket;
+
+namespace mojo
+{
+
+class SharedFrameRing;
+
+//
+// RemoteG3DWidget shows a GLG3D::GApp that runs in a RenderProcess of its own,
+// started with --render-process. Frames come back through a SharedFrameRing, and
+// input events go the other way over a QLocalSocket, as RemoteInputMessages.
+//
+// A thread blocks on the SharedFrameRing's semaphore and schedules a repaint for
+// every published frame. Qt coalesces the repaints, and each paint shows the latest
+// completed frame, wrapping the shared memory in a QImage rather than copying it, so
+// a RenderProcess that renders faster than we paint just skips frames. Frames are
+// rendered at our size in device pixels and written top row first, so they are drawn
+// 1:1, without flipping or scaling them.
+//
+// The SharedFrameRing is sized to us rather than to the screen. When we grow past it,
+// we create a larger one and send its name to the RenderProcess, and keep showing the
+// last frame of the old one until the first frame arrives in the new one.
+//
+class RemoteG3DWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    //
+    // appName is passed on to the RenderProcess, see RenderProcess.hpp.
+    //
+    RemoteG3DWidget(const QString& appName, QWidget* parent = NULL);
+    virtual ~RemoteG3DWidget();
+
+    //
+    // Returns false, and logs why, if the SharedFrameRing or the local server cannot
+    // be created. The RenderProcess is started asynchronously.
+    //
+    bool start();
+
+    std::uint64_t framesShown() const;
+    std::uint64_t framesSkipped() const;
+
+protected:
+    virtual void paintEvent(QPaintEvent* e);
+    virtual void resizeEvent(QResizeEvent* e);
+    virtual void enterEvent(QEvent* e);
+    virtual void mousePressEvent(QMouseEvent* e);
+    virtual void mouseReleaseEvent(QMouseEvent* e);
+    virtual void mouseMoveEvent(QMouseEvent* e);
+    virtual void wheelEvent(QWheelEvent* e);
+    virtual void keyPressEvent(QKeyEvent* e);
+    virtual void keyReleaseEvent(QKeyEvent* e);
+    virtual void dragEnterEvent(QDragEnterEvent* e);
+    virtual void dropEvent(QDropEvent* e);
+    virtual void focusInEvent(QFocusEvent* e);
+    virtual void focusOutEvent(QFocusEvent* e);
+    virtual void changeEvent(QEvent* e);
+
+private slots:
+    void onNewConnection();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    static const int kTerminateTimeoutMilliseconds = 1000;
+
+    // the SharedFrameRing grows in steps of this many device pixels
+    static const int kSharedFrameRingGranularity = 256;
+
+    QSize deviceSize() const;
+    bool growSharedFrameRing();
+
+    void sendMouseEvent(RemoteInputMessage::Type type, const QMouseEvent* mouseEvent);
+    void sendKeyEvent(RemoteInputMessage::Type type, const QKeyEvent* keyEvent);
+    void sendResize();
+    void sendWindowActive();
+    void sendFocus();
+    void sendSharedFrameRing();
+    void send(const RemoteInputMessage& message, const QByteArray& payload = QByteArray());
+
+    void startWatchingFrames();
+    void stopWatchingFrames();
+    void watchFrames();
+
+    QString                          m_appName;
+    std::string                      m_sharedFrameRingPrefix;
+    int                              m_sharedFrameRingCount;
+    std::shared_ptr<SharedFrameRing> m_sharedFrameRing;
+    std::shared_ptr<SharedFrameRing> m_retiredSharedFrameRing;
+    QLocalServer*                    m_server;
+    QLocalSocket*                    m_socket;
+    QProcess*                        m_process;
+    std::thread                      m_frameWatcher;
+    std::atomic<bool>                m_stopping;
+    std::uint64_t                    m_framesShown;
+    std::uint64_t                    m_lastFrameNumber;
+    std::uint64_t                    m_framesSkipped;
+
+    static int                       s_count;
+};
+
+}
+
+#endif
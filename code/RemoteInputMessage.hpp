@@ -0,0 +1,69 @@
+#ifndef REMOTE_INPUT_MESSAGE_HPP
+#define REMOTE_INPUT_MESSAGE_HPP
+
+#include <cstdint>
+
+namespace mojo
+{
+
+//
+// An input event that a RemoteG3DWidget forwards to its RenderProcess over a local
+// socket. Both ends are the same executable, so messages are sent as raw bytes. A
+// message may be followed by payloadSize bytes that don't fit its fields: the paths
+// of the dropped files for TYPE_DROP, one per line, and the name of the
+// SharedFrameRing to write to from now on for TYPE_SHARED_FRAME_RING, in UTF-8.
+//
+struct RemoteInputMessage
+{
+    enum Type
+    {
+        TYPE_MOUSE_MOVE,
+        TYPE_MOUSE_PRESS,
+        TYPE_MOUSE_RELEASE,
+        TYPE_WHEEL,
+        TYPE_KEY_PRESS,
+        TYPE_KEY_RELEASE,
+        TYPE_DROP,
+        TYPE_RESIZE,
+        TYPE_WINDOW_ACTIVE,
+        TYPE_FOCUS,
+        TYPE_SHARED_FRAME_RING
+    };
+
+    static const int kMaxTextLength = 4;
+
+    std::int32_t  type;
+
+    // the position for mouse events and TYPE_DROP, the size for TYPE_RESIZE
+    std::int32_t  x;
+    std::int32_t  y;
+
+    // the rotation for TYPE_WHEEL, in eighths of a degree
+    std::int32_t  deltaX;
+    std::int32_t  deltaY;
+
+    std::int32_t  button;
+    std::int32_t  buttons;
+    std::int32_t  modifiers;
+    std::int32_t  key;
+    std::uint32_t nativeScanCode;
+    std::uint32_t nativeVirtualKey;
+    std::uint32_t nativeModifiers;
+    std::uint32_t timestamp;
+
+    // autorepeat for key events, whether the window is active for TYPE_WINDOW_ACTIVE,
+    // whether the RemoteG3DWidget has focus for TYPE_FOCUS
+    std::int32_t  flag;
+
+    std::int32_t  textLength;
+    std::uint16_t text[kMaxTextLength];
+
+    // the device pixel ratio of the RemoteG3DWidget's screen for TYPE_RESIZE
+    double        devicePixelRatio;
+
+    std::int32_t  payloadSize;
+};
+
+}
+
+#endif
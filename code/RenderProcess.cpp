@@ -0,0 +1,237 @@
+#include "RenderProcess.hpp"
+
+#include <cstring>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMimeData>
+#include <QtCore/QTimer>
+#include <QtCore/QUrl>
+#include <QtGui/QDropEvent>
+#include <QtGui/QKeyEvent>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QWheelEvent>
+#include <QtNetwork/QLocalSocket>
+
+#include <GLG3D/RenderDevice.h>
+#include <GLG3D/GApp.h>
+
+#include "StarterApp.hpp"
+#include "PixelShaderApp.hpp"
+
+#include "Printf.hpp"
+#include "QtUtil.hpp"
+#include "G3DWidgetOpenGLContext.hpp"
+#include "G3DWidget.hpp"
+#include "SharedFrameRing.hpp"
+#include "TextureCache.hpp"
+#include "MeshCache.hpp"
+#include "RemoteInputMessage.hpp"
+
+namespace mojo
+{
+
+RenderProcess::RenderProcess(const QString& appName, const QString& serverName, QObject* parent) :
+    QObject                 (parent),
+    m_appName               (appName),
+    m_serverName            (serverName),
+    m_g3dWidgetOpenGLContext(new G3DWidgetOpenGLContext(G3D::OSWindow::Settings())),
+    m_renderDevice          (new G3D::RenderDevice),
+    m_g3dWidget             (new G3DWidget(m_g3dWidgetOpenGLContext, m_renderDevice)),
+    m_socket                (new QLocalSocket(this)),
+    m_timer                 (new QTimer(this)),
+    m_initialized           (false) {
+}
+
+RenderProcess::~RenderProcess() {
+    terminate();
+}
+
+bool RenderProcess::start() {
+    if (m_appName != "starter" && m_appName != "pixelShader") {
+        mojo::printf("Unknown GLG3D::GApp ", m_appName.toUtf8().constData());
+        return false;
+    }
+
+    m_socket->connectToServer(m_serverName);
+    if (!m_socket->waitForConnected(kConnectTimeoutMilliseconds)) {
+        mojo::printf("Cannot connect to ", m_serverName.toUtf8().constData(), ": ", m_socket->errorString().toUtf8().constData());
+        return false;
+    }
+
+    //
+    // Qt::WA_DontShowOnScreen gives the G3DWidget a native window, and so its OpenGL
+    // context a drawable, without putting it on screen. The RemoteG3DWidget sends us
+    // its size as soon as we connect.
+    //
+    m_g3dWidget->setAttribute(Qt::WA_DontShowOnScreen);
+    m_g3dWidget->resize(400, 400);
+    m_g3dWidget->show();
+
+    //
+    // From here on, we wire up the G3DWidget the same way MainWindow does on its first
+    // paint event.
+    //
+    m_g3dWidget->initialize();
+    m_g3dWidget->makeCurrent();
+    m_renderDevice->init(m_g3dWidget.get());
+
+    if (m_appName == "starter") {
+        m_app = std::shared_ptr<G3D::GApp>(new G3D::StarterApp(G3D::GApp::Settings(), m_g3dWidget.get(), m_renderDevice.get()));
+    } else {
+        std::shared_ptr<G3D::PixelShaderApp> pixelShaderApp(new G3D::PixelShaderApp(G3D::GApp::Settings(), m_g3dWidget.get(), m_renderDevice.get()));
+        pixelShaderApp->setTextureCache(std::make_shared<TextureCache>(TextureCache::defaultDirectory()));
+        pixelShaderApp->setMeshCache(std::make_shared<MeshCache>(MeshCache::defaultDirectory()));
+        m_app = pixelShaderApp;
+    }
+
+    m_g3dWidget->pushLoopBody(m_app.get());
+    m_initialized = true;
+
+    MOJO_QT_SAFE(connect(m_socket, SIGNAL(readyRead()), this, SLOT(onReadyRead())));
+    MOJO_QT_SAFE(connect(m_socket, SIGNAL(disconnected()), this, SLOT(onDisconnected())));
+    MOJO_QT_SAFE(connect(m_timer, SIGNAL(timeout()), this, SLOT(onTimerTimeout())));
+    m_timer->start(15);
+
+    // messages that arrived while we initialized don't signal readyRead() again
+    onReadyRead();
+
+    return true;
+}
+
+void RenderProcess::onTimerTimeout() {
+    m_g3dWidget->update();
+}
+
+void RenderProcess::onReadyRead() {
+    m_received.append(m_socket->readAll());
+
+    int offset = 0;
+    while (m_received.size() - offset >= (int)sizeof(RemoteInputMessage)) {
+        RemoteInputMessage message;
+        std::memcpy(&message, m_received.constData() + offset, sizeof(RemoteInputMessage));
+
+        // the payload may not have arrived yet
+        int size = (int)sizeof(RemoteInputMessage) + message.payloadSize;
+        if (m_received.size() - offset < size) {
+            break;
+        }
+
+        dispatch(message, m_received.mid(offset + (int)sizeof(RemoteInputMessage), message.payloadSize));
+        offset += size;
+    }
+
+    m_received.remove(0, offset);
+}
+
+void RenderProcess::onDisconnected() {
+
+    // the RemoteG3DWidget is gone, so there is nobody left to render for
+    terminate();
+    QCoreApplication::quit();
+}
+
+void RenderProcess::dispatch(const RemoteInputMessage& message, const QByteArray& payload) {
+    Qt::KeyboardModifiers modifiers(message.modifiers);
+
+    switch (message.type) {
+    case RemoteInputMessage::TYPE_MOUSE_MOVE:
+    case RemoteInputMessage::TYPE_MOUSE_PRESS:
+    case RemoteInputMessage::TYPE_MOUSE_RELEASE:
+    {
+        QEvent::Type type =
+            message.type == RemoteInputMessage::TYPE_MOUSE_MOVE  ? QEvent::MouseMove :
+            message.type == RemoteInputMessage::TYPE_MOUSE_PRESS ? QEvent::MouseButtonPress :
+                                                                   QEvent::MouseButtonRelease;
+
+        QMouseEvent mouseEvent(type, QPointF(message.x, message.y), (Qt::MouseButton)message.button, Qt::MouseButtons(message.buttons), modifiers);
+        mouseEvent.setTimestamp(message.timestamp);
+        QCoreApplication::sendEvent(m_g3dWidget.get(), &mouseEvent);
+        break;
+    }
+
+    case RemoteInputMessage::TYPE_WHEEL:
+    {
+        QPointF         position(message.x, message.y);
+        Qt::Orientation orientation = message.deltaY != 0 ? Qt::Vertical : Qt::Horizontal;
+        int             delta       = message.deltaY != 0 ? message.deltaY : message.deltaX;
+
+        QWheelEvent wheelEvent(position, position, QPoint(), QPoint(message.deltaX, message.deltaY), delta, orientation, Qt::MouseButtons(message.buttons), modifiers);
+        wheelEvent.setTimestamp(message.timestamp);
+        QCoreApplication::sendEvent(m_g3dWidget.get(), &wheelEvent);
+        break;
+    }
+
+    case RemoteInputMessage::TYPE_KEY_PRESS:
+    case RemoteInputMessage::TYPE_KEY_RELEASE:
+    {
+        QEvent::Type type = message.type == RemoteInputMessage::TYPE_KEY_PRESS ? QEvent::KeyPress : QEvent::KeyRelease;
+        QString      text((const QChar*)message.text, message.textLength);
+
+        QKeyEvent keyEvent(type, message.key, modifiers, message.nativeScanCode, message.nativeVirtualKey, message.nativeModifiers, text, message.flag != 0);
+        keyEvent.setTimestamp(message.timestamp);
+        QCoreApplication::sendEvent(m_g3dWidget.get(), &keyEvent);
+        break;
+    }
+
+    case RemoteInputMessage::TYPE_DROP:
+    {
+        QList<QUrl> urls;
+        Q_FOREACH(QString path, QString::fromUtf8(payload).split('\n', QString::SkipEmptyParts)) {
+            urls.append(QUrl::fromLocalFile(path));
+        }
+
+        QMimeData mimeData;
+        mimeData.setUrls(urls);
+
+        QDropEvent dropEvent(QPointF(message.x, message.y), Qt::CopyAction, &mimeData, Qt::NoButton, modifiers);
+        QCoreApplication::sendEvent(m_g3dWidget.get(), &dropEvent);
+        break;
+    }
+
+    case RemoteInputMessage::TYPE_RESIZE:
+        m_g3dWidget->setDevicePixelRatio(message.devicePixelRatio);
+        m_g3dWidget->resize(message.x, message.y);
+        break;
+
+    case RemoteInputMessage::TYPE_WINDOW_ACTIVE:
+        m_g3dWidget->setRemoteWindowActive(message.flag != 0);
+        break;
+
+    case RemoteInputMessage::TYPE_FOCUS:
+        m_g3dWidget->setRemoteFocus(message.flag != 0);
+        break;
+
+    case RemoteInputMessage::TYPE_SHARED_FRAME_RING:
+    {
+        // open(...) logs why it fails, and we keep writing to the ring we have
+        std::shared_ptr<SharedFrameRing> sharedFrameRing = SharedFrameRing::open(payload.toStdString());
+        if (sharedFrameRing) {
+            m_g3dWidget->setSharedFrameRing(sharedFrameRing);
+        }
+        break;
+    }
+
+    default:
+        mojo::printf("Unknown RemoteInputMessage type ", message.type);
+        break;
+    }
+}
+
+void RenderProcess::terminate() {
+    m_timer->stop();
+
+    if (!m_initialized) {
+        return;
+    }
+
+    //
+    // We clean up in the opposite order we initialized in, like MainWindow::closeEvent(...).
+    //
+    m_g3dWidget->popLoopBody();
+    m_renderDevice->cleanup();
+    m_g3dWidget->terminate();
+
+    m_initialized = false;
+}
+
+}
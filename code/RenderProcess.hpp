@@ -0,0 +1,80 @@
+#ifndef RENDER_PROCESS_HPP
+#define RENDER_PROCESS_HPP
+
+#include <memory>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+class QLocalSocket;
+class QTimer;
+
+namespace G3D
+{
+class GApp;
+class RenderDevice;
+}
+
+namespace mojo
+{
+
+class G3DWidgetOpenGLContext;
+class G3DWidget;
+struct RemoteInputMessage;
+
+//
+// RenderProcess runs a single GLG3D::GApp in a process of its own, for a
+// RemoteG3DWidget in the process that shows it. The GLG3D::GApp renders into a
+// G3DWidget that is never shown on screen, which reads each frame back into a
+// SharedFrameRing. Input events arrive from the RemoteG3DWidget over a local socket,
+// and are sent to the G3DWidget as the Qt events they were, so it translates them
+// as usual. So does the name of the SharedFrameRing, first thing after we connect
+// and again whenever the RemoteG3DWidget outgrows it. The process quits when the
+// socket disconnects.
+//
+// Since each GLG3D::GApp has its own process, OpenGL context and thread, a heavy or
+// misbehaving one no longer holds up the others.
+//
+class RenderProcess : public QObject
+{
+    Q_OBJECT
+
+public:
+    //
+    // appName is "starter" or "pixelShader".
+    //
+    RenderProcess(const QString& appName, const QString& serverName, QObject* parent = 0);
+    virtual ~RenderProcess();
+
+    //
+    // Returns false, and logs why, if we cannot connect to the RemoteG3DWidget.
+    //
+    bool start();
+
+private slots:
+    void onTimerTimeout();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    static const int kConnectTimeoutMilliseconds = 5000;
+
+    void dispatch(const RemoteInputMessage& message, const QByteArray& payload);
+    void terminate();
+
+    QString                                 m_appName;
+    QString                                 m_serverName;
+    std::shared_ptr<G3DWidgetOpenGLContext> m_g3dWidgetOpenGLContext;
+    std::shared_ptr<G3D::RenderDevice>      m_renderDevice;
+    std::unique_ptr<G3DWidget>              m_g3dWidget;
+    std::shared_ptr<G3D::GApp>              m_app;
+    QLocalSocket*                           m_socket;
+    QTimer*                                 m_timer;
+    QByteArray                              m_received;
+    bool                                    m_initialized;
+};
+
+}
+
+#endif
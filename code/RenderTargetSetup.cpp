@@ -0,0 +1,45 @@
+#include "RenderTargetSetup.hpp"
+
+namespace mojo
+{
+
+RenderTargetSetup::RenderTargetSetup() :
+    m_appliedChanges     (0),
+    m_totalAppliedChanges(0) {
+}
+
+void RenderTargetSetup::beginFrame() {
+    m_totalAppliedChanges += m_appliedChanges;
+    m_appliedChanges       = 0;
+}
+
+void RenderTargetSetup::setupGBuffer(const G3D::shared_ptr<G3D::GBuffer>& gbuffer, const G3D::GBuffer::Specification& specification, int width, int height) {
+
+    // setting a specification can reallocate every texture of the G3D::GBuffer
+    if (!(gbuffer->specification() == specification)) {
+        gbuffer->setSpecification(specification);
+        ++m_appliedChanges;
+    }
+
+    if ((gbuffer->width() != width) || (gbuffer->height() != height)) {
+        gbuffer->resize(width, height);
+        ++m_appliedChanges;
+    }
+}
+
+void RenderTargetSetup::resizeFramebuffer(const G3D::shared_ptr<G3D::Framebuffer>& framebuffer, int width, int height) {
+    if ((framebuffer->width() != width) || (framebuffer->height() != height)) {
+        framebuffer->resize(width, height);
+        ++m_appliedChanges;
+    }
+}
+
+int RenderTargetSetup::appliedChanges() const {
+    return m_appliedChanges;
+}
+
+std::uint64_t RenderTargetSetup::totalAppliedChanges() const {
+    return m_totalAppliedChanges + m_appliedChanges;
+}
+
+}
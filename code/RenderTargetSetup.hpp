@@ -0,0 +1,42 @@
+#ifndef RENDER_TARGET_SETUP_HPP
+#define RENDER_TARGET_SETUP_HPP
+
+#include <cstdint>
+
+#include <G3D/G3D.h>
+#include <GLG3D/GLG3D.h>
+
+namespace mojo
+{
+
+//
+// RenderTargetSetup applies the per-frame setup of GBuffers and Framebuffers, and
+// counts the changes that actually reallocate something: a new GBuffer specification
+// or a new size. Setting what a target already has costs nothing, since G3D skips it
+// too, so it isn't counted. A frame that counts changes in a steady state, e.g.,
+// while the window isn't being resized, reallocates render targets it shouldn't.
+//
+// Call beginFrame() at the start of each frame to reset the count. Each view that
+// sets up targets of its own uses its own RenderTargetSetup, so counts don't mix.
+//
+class RenderTargetSetup
+{
+public:
+    RenderTargetSetup();
+
+    void beginFrame();
+
+    void setupGBuffer(const G3D::shared_ptr<G3D::GBuffer>& gbuffer, const G3D::GBuffer::Specification& specification, int width, int height);
+    void resizeFramebuffer(const G3D::shared_ptr<G3D::Framebuffer>& framebuffer, int width, int height);
+
+    int appliedChanges() const;
+    std::uint64_t totalAppliedChanges() const;
+
+private:
+    int           m_appliedChanges;
+    std::uint64_t m_totalAppliedChanges;
+};
+
+}
+
+#endif
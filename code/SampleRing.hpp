@@ -0,0 +1,120 @@
+#ifndef SAMPLE_RING_HPP
+#define SAMPLE_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace mojo
+{
+
+struct SampleStatistics
+{
+    SampleStatistics() : count(0), mean(0.0f), p50(0.0f), p95(0.0f), p99(0.0f), max(0.0f) {}
+
+    int   count;
+    float mean;
+    float p50;
+    float p95;
+    float p99;
+    float max;
+};
+
+//
+// SampleRing is a fixed-size ring of the most recent Capacity samples. It is
+// lock-free: a single producer thread calls push(...), and any number of reader
+// threads can call snapshot(...) or statistics() concurrently. A reader racing
+// with the producer may observe a sample from the next lap in an old slot, which
+// is harmless for the aggregate statistics we compute from it.
+//
+template <int Capacity>
+class SampleRing
+{
+public:
+    SampleRing();
+
+    void push(float sample);
+    void clear();
+
+    std::uint64_t totalCount() const;
+    int snapshot(float* samples) const;
+    SampleStatistics statistics() const;
+
+private:
+    std::atomic<float>         m_samples[Capacity];
+    std::atomic<std::uint64_t> m_writeIndex;
+};
+
+template <int Capacity>
+inline SampleRing<Capacity>::SampleRing() :
+    m_writeIndex(0)
+{
+    for (int i = 0; i < Capacity; ++i) {
+        m_samples[i].store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+template <int Capacity>
+inline void SampleRing<Capacity>::push(float sample)
+{
+    std::uint64_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+    m_samples[writeIndex % Capacity].store(sample, std::memory_order_relaxed);
+    m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+template <int Capacity>
+inline void SampleRing<Capacity>::clear()
+{
+    m_writeIndex.store(0, std::memory_order_release);
+}
+
+template <int Capacity>
+inline std::uint64_t SampleRing<Capacity>::totalCount() const
+{
+    return m_writeIndex.load(std::memory_order_acquire);
+}
+
+template <int Capacity>
+inline int SampleRing<Capacity>::snapshot(float* samples) const
+{
+    std::uint64_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+    int           count      = (int)std::min<std::uint64_t>(writeIndex, Capacity);
+
+    for (int i = 0; i < count; ++i) {
+        samples[i] = m_samples[(writeIndex - count + i) % Capacity].load(std::memory_order_relaxed);
+    }
+
+    return count;
+}
+
+template <int Capacity>
+inline SampleStatistics SampleRing<Capacity>::statistics() const
+{
+    float samples[Capacity];
+    int   count = snapshot(samples);
+
+    SampleStatistics statistics;
+    if (count == 0) {
+        return statistics;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        sum += samples[i];
+    }
+
+    std::sort(samples, samples + count);
+
+    statistics.count = count;
+    statistics.mean  = (float)(sum / count);
+    statistics.p50   = samples[(count - 1) * 50 / 100];
+    statistics.p95   = samples[(count - 1) * 95 / 100];
+    statistics.p99   = samples[(count - 1) * 99 / 100];
+    statistics.max   = samples[count - 1];
+
+    return statistics;
+}
+
+}
+
+#endif
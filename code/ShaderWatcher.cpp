@@ -0,0 +1,149 @@
+#include "ShaderWatcher.hpp"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QTimer>
+
+#include "Assert.hpp"
+#include "QtUtil.hpp"
+
+namespace mojo
+{
+
+namespace
+{
+
+const char* const kSuffixes[] = { ".vrt", ".pix" };
+
+bool readFile(const QString& path, std::string& contents) {
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QByteArray bytes = file.readAll();
+    contents.assign(bytes.constData(), bytes.size());
+    return true;
+}
+
+}
+
+ShaderWatcher::ShaderWatcher(const QString& directory, QObject* parent) :
+    QObject     (parent),
+    m_directory (directory),
+    m_watcher   (new QFileSystemWatcher(this)),
+    m_readTimer (new QTimer(this)),
+    m_stopping  (false),
+    m_generation(0) {
+
+    m_readTimer->setSingleShot(true);
+    m_readTimer->setInterval(kSettleMilliseconds);
+
+    MOJO_QT_SAFE(connect(m_watcher, SIGNAL(fileChanged(const QString&)), this, SLOT(onFileChanged(const QString&))));
+    MOJO_QT_SAFE(connect(m_readTimer, SIGNAL(timeout()), this, SLOT(onReadTimerTimeout())));
+
+    m_reader = std::thread(&ShaderWatcher::read, this);
+}
+
+ShaderWatcher::~ShaderWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_readCondition.notify_one();
+    m_reader.join();
+}
+
+void ShaderWatcher::watch(const QString& baseName) {
+    for (const char* suffix : kSuffixes) {
+        m_watcher->addPath(QDir(m_directory).filePath(baseName + suffix));
+    }
+}
+
+bool ShaderWatcher::takeChangedSources(const QString& baseName, Sources& sources) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::map<QString, Sources>::const_iterator it = m_sources.find(baseName);
+    if (it == m_sources.end() || m_taken[baseName] == it->second.generation) {
+        return false;
+    }
+
+    sources           = it->second;
+    m_taken[baseName] = sources.generation;
+    return true;
+}
+
+const QString& ShaderWatcher::directory() const {
+    return m_directory;
+}
+
+void ShaderWatcher::onFileChanged(const QString& path) {
+    QString baseName = QFileInfo(path).completeBaseName();
+    if (!m_changed.contains(baseName)) {
+        m_changed.append(baseName);
+    }
+
+    //
+    // Many editors save by writing a new file and renaming it over the old one, which
+    // removes the old file from the watcher, so we watch the path again.
+    //
+    if (!m_watcher->files().contains(path) && QFileInfo(path).exists()) {
+        m_watcher->addPath(path);
+    }
+
+    // wait for saves that touch several files, or write in several steps, to settle
+    m_readTimer->start();
+}
+
+void ShaderWatcher::onReadTimerTimeout() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const QString& baseName : m_changed) {
+            if (!m_pending.contains(baseName)) {
+                m_pending.append(baseName);
+            }
+        }
+    }
+
+    m_changed.clear();
+    m_readCondition.notify_one();
+}
+
+void ShaderWatcher::read() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        m_readCondition.wait(lock, [this] { return m_stopping || !m_pending.isEmpty(); });
+
+        if (m_stopping) {
+            return;
+        }
+
+        QStringList baseNames = m_pending;
+        m_pending.clear();
+
+        // reading doesn't need the lock, so takeChangedSources(...) never waits for it
+        lock.unlock();
+
+        for (const QString& baseName : baseNames) {
+            Sources sources;
+
+            if (!readFile(QDir(m_directory).filePath(baseName + ".vrt"), sources.vertex) ||
+                !readFile(QDir(m_directory).filePath(baseName + ".pix"), sources.pixel)) {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> sourcesLock(m_mutex);
+            sources.generation  = ++m_generation;
+            m_sources[baseName] = sources;
+        }
+
+        lock.lock();
+    }
+}
+
+}
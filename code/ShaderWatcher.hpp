@@ -0,0 +1,79 @@
+#ifndef SHADER_WATCHER_HPP
+#define SHADER_WATCHER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+namespace mojo
+{
+
+//
+// Watches a directory of shader sources, e.g., MOJO_SHADER_SOURCE_DIR, and re-reads a
+// shader's files on a reader thread of its own whenever one of them changes. The
+// render thread polls takeChangedSources(...) at a frame boundary and compiles the
+// new sources itself, since compiling needs the OpenGL context.
+//
+// A shader is identified by its base name, e.g., "phong" for phong.vrt and phong.pix.
+//
+class ShaderWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Sources
+    {
+        std::string   vertex;
+        std::string   pixel;
+        std::uint64_t generation;
+    };
+
+    ShaderWatcher(const QString& directory, QObject* parent = 0);
+    virtual ~ShaderWatcher();
+
+    void watch(const QString& baseName);
+
+    //
+    // Returns true, and the sources, if the shader changed since the last call.
+    //
+    bool takeChangedSources(const QString& baseName, Sources& sources);
+
+    const QString& directory() const;
+
+private slots:
+    void onFileChanged(const QString& path);
+    void onReadTimerTimeout();
+
+private:
+    static const int kSettleMilliseconds = 100;
+
+    void read();
+
+    QString                          m_directory;
+    QFileSystemWatcher*              m_watcher;
+    QTimer*                          m_readTimer;
+    QStringList                      m_changed;
+    std::thread                      m_reader;
+
+    std::mutex                       m_mutex;
+    std::condition_variable          m_readCondition;
+    QStringList                      m_pending;
+    bool                             m_stopping;
+    std::map<QString, Sources>       m_sources;
+    std::map<QString, std::uint64_t> m_taken;
+    std::uint64_t                    m_generation;
+};
+
+}
+
+#endif
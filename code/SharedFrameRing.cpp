@@ -0,0 +1,242 @@
+#include "SharedFrameRing.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Assert.hpp"
+#include "Printf.hpp"
+
+namespace mojo
+{
+
+// the header lives in memory shared between processes, so its atomics can't use locks
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "SharedFrameRing needs lock-free 32-bit atomics");
+
+static const std::size_t kPageSize = 4096;
+
+std::shared_ptr<SharedFrameRing> SharedFrameRing::create(const std::string& name, int maxWidth, int maxHeight) {
+    MOJO_RELEASE_ASSERT(maxWidth > 0 && maxHeight > 0);
+
+    std::shared_ptr<SharedFrameRing> sharedFrameRing(new SharedFrameRing(name, true));
+
+    // a ring left behind by a process that crashed would otherwise make O_EXCL fail
+    shm_unlink(name.c_str());
+    sem_unlink(semaphoreName(name).c_str());
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        mojo::printf("Cannot create shared memory ", name, ": ", std::strerror(errno));
+        return std::shared_ptr<SharedFrameRing>();
+    }
+
+    std::size_t size = headerSize() + kSlotCount * (std::size_t)maxWidth * maxHeight * 4;
+
+    bool mapped = ftruncate(fd, (off_t)size) == 0 && sharedFrameRing->map(fd, size);
+    close(fd);
+
+    if (!mapped) {
+        mojo::printf("Cannot map shared memory ", name, ": ", std::strerror(errno));
+        return std::shared_ptr<SharedFrameRing>();
+    }
+
+    //
+    // Initially the producer writes to slot 0, slot 1 is the latest frame, without the
+    // dirty bit since it was never written, and the consumer shows slot 2.
+    //
+    Header* header = new (sharedFrameRing->m_header) Header;
+    header->maxWidth   = maxWidth;
+    header->maxHeight  = maxHeight;
+    header->frameCount = 0;
+    header->latest.store(1, std::memory_order_relaxed);
+
+    for (int i = 0; i < kSlotCount; ++i) {
+        header->slots[i].width       = 0;
+        header->slots[i].height      = 0;
+        header->slots[i].frameNumber = 0;
+    }
+
+    sharedFrameRing->m_writeSlot = 0;
+    sharedFrameRing->m_readSlot  = 2;
+
+    sharedFrameRing->m_semaphore = sem_open(semaphoreName(name).c_str(), O_CREAT | O_EXCL, S_IRUSR | S_IWUSR, 0);
+    if (sharedFrameRing->m_semaphore == SEM_FAILED) {
+        sharedFrameRing->m_semaphore = NULL;
+        mojo::printf("Cannot create semaphore ", semaphoreName(name), ": ", std::strerror(errno));
+        return std::shared_ptr<SharedFrameRing>();
+    }
+
+    // the producer checks the magic number, so we publish it last
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kMagic;
+
+    return sharedFrameRing;
+}
+
+std::shared_ptr<SharedFrameRing> SharedFrameRing::open(const std::string& name) {
+    std::shared_ptr<SharedFrameRing> sharedFrameRing(new SharedFrameRing(name, false));
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        mojo::printf("Cannot open shared memory ", name, ": ", std::strerror(errno));
+        return std::shared_ptr<SharedFrameRing>();
+    }
+
+    struct stat status;
+    bool mapped = fstat(fd, &status) == 0 && (std::size_t)status.st_size > headerSize() && sharedFrameRing->map(fd, (std::size_t)status.st_size);
+    close(fd);
+
+    if (!mapped || sharedFrameRing->m_header->magic != kMagic || sharedFrameRing->m_size < headerSize() + kSlotCount * sharedFrameRing->slotSize()) {
+        mojo::printf("Cannot map shared memory ", name);
+        return std::shared_ptr<SharedFrameRing>();
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    sharedFrameRing->m_semaphore = sem_open(semaphoreName(name).c_str(), 0);
+    if (sharedFrameRing->m_semaphore == SEM_FAILED) {
+        sharedFrameRing->m_semaphore = NULL;
+        mojo::printf("Cannot open semaphore ", semaphoreName(name), ": ", std::strerror(errno));
+        return std::shared_ptr<SharedFrameRing>();
+    }
+
+    sharedFrameRing->m_writeSlot = 0;
+    sharedFrameRing->m_readSlot  = 2;
+
+    return sharedFrameRing;
+}
+
+SharedFrameRing::SharedFrameRing(const std::string& name, bool owner) :
+    m_name     (name),
+    m_owner    (owner),
+    m_header   (NULL),
+    m_size     (0),
+    m_semaphore(NULL),
+    m_writeSlot(0),
+    m_readSlot (0) {
+
+    MOJO_RELEASE_ASSERT(!name.empty() && name[0] == '/');
+    MOJO_RELEASE_ASSERT(semaphoreName(name).size() <= 30);
+}
+
+SharedFrameRing::~SharedFrameRing() {
+    if (m_semaphore != NULL) {
+        sem_close(m_semaphore);
+    }
+
+    if (m_header != NULL) {
+        munmap(m_header, m_size);
+    }
+
+    if (m_owner) {
+        sem_unlink(semaphoreName(m_name).c_str());
+        shm_unlink(m_name.c_str());
+    }
+}
+
+const std::string& SharedFrameRing::name() const {
+    return m_name;
+}
+
+int SharedFrameRing::maxWidth() const {
+    return m_header->maxWidth;
+}
+
+int SharedFrameRing::maxHeight() const {
+    return m_header->maxHeight;
+}
+
+unsigned char* SharedFrameRing::beginWrite(int width, int height) {
+    MOJO_RELEASE_ASSERT(width  > 0 && width  <= m_header->maxWidth);
+    MOJO_RELEASE_ASSERT(height > 0 && height <= m_header->maxHeight);
+
+    Slot& slot  = m_header->slots[m_writeSlot];
+    slot.width  = width;
+    slot.height = height;
+
+    return slotPixels(m_writeSlot);
+}
+
+void SharedFrameRing::endWrite() {
+    m_header->slots[m_writeSlot].frameNumber = ++m_header->frameCount;
+
+    //
+    // Swap the slot we wrote with the latest one, marking it as new. The consumer may
+    // not have taken the previous latest frame, in which case it is dropped, and we
+    // write the next frame over it.
+    //
+    std::uint32_t latest = m_header->latest.exchange((std::uint32_t)m_writeSlot | kDirtyBit, std::memory_order_acq_rel);
+    m_writeSlot          = (int)(latest & kIndexMask);
+
+    sem_post(m_semaphore);
+}
+
+bool SharedFrameRing::acquireLatest() {
+    if ((m_header->latest.load(std::memory_order_relaxed) & kDirtyBit) == 0) {
+        return false;
+    }
+
+    std::uint32_t latest = m_header->latest.exchange((std::uint32_t)m_readSlot, std::memory_order_acq_rel);
+    m_readSlot           = (int)(latest & kIndexMask);
+
+    return true;
+}
+
+const unsigned char* SharedFrameRing::framePixels() const {
+    return slotPixels(m_readSlot);
+}
+
+int SharedFrameRing::frameWidth() const {
+    return m_header->slots[m_readSlot].width;
+}
+
+int SharedFrameRing::frameHeight() const {
+    return m_header->slots[m_readSlot].height;
+}
+
+std::uint64_t SharedFrameRing::frameNumber() const {
+    return m_header->slots[m_readSlot].frameNumber;
+}
+
+void SharedFrameRing::waitForFrame() {
+    while (sem_wait(m_semaphore) != 0 && errno == EINTR) {
+    }
+}
+
+void SharedFrameRing::wake() {
+    sem_post(m_semaphore);
+}
+
+bool SharedFrameRing::map(int fd, std::size_t size) {
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+
+    m_header = (Header*)p;
+    m_size   = size;
+    return true;
+}
+
+std::size_t SharedFrameRing::slotSize() const {
+    return (std::size_t)m_header->maxWidth * m_header->maxHeight * 4;
+}
+
+unsigned char* SharedFrameRing::slotPixels(int slot) const {
+    return (unsigned char*)m_header + headerSize() + slot * slotSize();
+}
+
+std::size_t SharedFrameRing::headerSize() {
+    return (sizeof(Header) + kPageSize - 1) & ~(kPageSize - 1);
+}
+
+std::string SharedFrameRing::semaphoreName(const std::string& name) {
+    return name + ".s";
+}
+
+}
@@ -0,0 +1,114 @@
+#ifndef SHARED_FRAME_RING_HPP
+#define SHARED_FRAME_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <semaphore.h>
+
+namespace mojo
+{
+
+//
+// SharedFrameRing carries rendered frames from a render process to the process that
+// shows them, through POSIX shared memory. It is a ring of kSlotCount RGBA8 slots used
+// as a triple buffer: the producer owns one slot it renders into, the consumer owns
+// one slot it shows, and the third slot holds the latest completed frame. Ownership
+// moves with a single atomic exchange in the shared header, so neither side ever
+// waits on the other, and a slow consumer simply skips frames.
+//
+// The producer posts a named semaphore after each frame, which the consumer can block
+// on with waitForFrame() instead of polling.
+//
+// The consumer creates the ring, and unlinks the shared memory and the semaphore when
+// it is destroyed; the producer opens it by name. Names are limited to 30 characters,
+// since that is all macOS allows.
+//
+class SharedFrameRing
+{
+public:
+    static const int kSlotCount = 3;
+
+    //
+    // Return an empty pointer, and log why, if the ring cannot be created or opened.
+    //
+    static std::shared_ptr<SharedFrameRing> create(const std::string& name, int maxWidth, int maxHeight);
+    static std::shared_ptr<SharedFrameRing> open(const std::string& name);
+
+    ~SharedFrameRing();
+
+    const std::string& name() const;
+    int maxWidth() const;
+    int maxHeight() const;
+
+    //
+    // Called by the producer. beginWrite(...) returns the slot to write the frame to,
+    // top row first, and endWrite() publishes it as the latest frame.
+    //
+    unsigned char* beginWrite(int width, int height);
+    void endWrite();
+
+    //
+    // Called by the consumer. Takes the latest frame, if there is one that wasn't taken
+    // yet, and returns true if it did. The frame accessors refer to the taken frame,
+    // which stays valid until the next call.
+    //
+    bool acquireLatest();
+
+    const unsigned char* framePixels() const;
+    int frameWidth() const;
+    int frameHeight() const;
+    std::uint64_t frameNumber() const;
+
+    //
+    // Blocks until the producer has published a frame, or wake() is called.
+    //
+    void waitForFrame();
+    void wake();
+
+private:
+    static const std::uint32_t kMagic     = 0x6d6f6a6f;
+    static const std::uint32_t kDirtyBit  = 0x4;
+    static const std::uint32_t kIndexMask = 0x3;
+
+    struct Slot
+    {
+        std::int32_t  width;
+        std::int32_t  height;
+        std::uint64_t frameNumber;
+    };
+
+    struct Header
+    {
+        std::uint32_t              magic;
+        std::int32_t               maxWidth;
+        std::int32_t               maxHeight;
+        std::atomic<std::uint32_t> latest;
+        std::uint64_t              frameCount;
+        Slot                       slots[kSlotCount];
+    };
+
+    SharedFrameRing(const std::string& name, bool owner);
+
+    bool map(int fd, std::size_t size);
+    std::size_t slotSize() const;
+    unsigned char* slotPixels(int slot) const;
+
+    static std::size_t headerSize();
+    static std::string semaphoreName(const std::string& name);
+
+    std::string m_name;
+    bool        m_owner;
+    Header*     m_header;
+    std::size_t m_size;
+    sem_t*      m_semaphore;
+    int         m_writeSlot;
+    int         m_readSlot;
+};
+
+}
+
+#endif
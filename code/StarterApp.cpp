@@ -1,4 +1,5 @@
 #include "Assert.hpp"
+#include "FrameProfiler.hpp"
 
 #include "StarterApp.hpp"
 
@@ -6,7 +7,33 @@ namespace G3D
 {
 
 StarterApp::StarterApp(const GApp::Settings& settings, OSWindow* window, RenderDevice* rd) :
-    GApp(settings, window, rd) {
+    GApp(settings, window, rd),
+    m_threadedSimulationEnabled(false),
+    m_simulationTimeStep(1.0 / 120.0),
+    m_pendingSimulationTime(0.0),
+    m_passTimer(PASS_COUNT, 2),
+    m_passTimerResolution(0, 0),
+    m_showPassTimings(false),
+    m_debugWindowWidth(0),
+    m_dynamicResolutionEnabled(false),
+    m_resolvedPassTimings(0),
+    m_depthGuardBand(0, 0),
+    m_colorGuardBand(0, 0),
+    m_passesRun(0),
+    m_framebufferReusable(false),
+    m_previousFieldOfViewAngle(0.0f),
+    m_previousSceneChangeTime(0.0),
+    m_previousResolution(0, 0) {
+
+    for (int i = 0; i < PASS_COUNT; ++i) {
+        m_passRunCounts[i] = 0;
+    }
+}
+
+
+StarterApp::~StarterApp() {
+    // The worker thread calls back into this app, so it must stop before we are destroyed
+    setThreadedSimulation(false);
 }
 
 
@@ -49,6 +76,9 @@ void StarterApp::makeGUI() {
     infoPane->addLabel("You can add GUI controls");
     infoPane->addLabel("in App::onInit().");
     infoPane->addButton("Exit", this, &StarterApp::endProgram);
+    infoPane->addCheckBox("Show GPU pass timings", &m_showPassTimings);
+    infoPane->addCheckBox("Dynamic resolution", &m_dynamicResolutionEnabled);
+    infoPane->addCheckBox("Threaded simulation", &m_threadedSimulationEnabled);
     infoPane->pack();
 
     // More examples of debugging GUI controls:
@@ -59,39 +89,94 @@ void StarterApp::makeGUI() {
 
     debugWindow->pack();
     debugWindow->setRect(Rect2D::xywh(0, 0, (float)window()->width(), debugWindow->rect().height()));
+    m_debugWindowWidth = window()->width();
 }
 
 
 void StarterApp::onGraphics3D(RenderDevice* rd, Array<shared_ptr<Surface> >& allSurfaces) {
-    // This implementation is equivalent to the default GApp's. It is repeated here to make it
-    // easy to modify rendering. If you don't require custom rendering, just delete this
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_GRAPHICS_3D);
+
+    // This implementation started out equivalent to the default GApp's. On top of that it
+    // times each pass on the GPU, renders at a dynamic resolution, and skips passes that
+    // cannot change the image. If you don't require custom rendering, just delete this
     // method from your application and rely on the base class.
 
     if (! scene()) {
         return;
     }
 
-    m_gbuffer->setSpecification(m_gbufferSpecification);
-    m_gbuffer->resize(m_framebuffer->width(), m_framebuffer->height());
-    m_gbuffer->prepare(rd, activeCamera(), 0, -(float)previousSimTimeStep(), m_settings.depthGuardBandThickness, m_settings.colorGuardBandThickness);
+    updateRenderScale();
 
-    m_renderer->render(rd, m_framebuffer, m_depthPeelFramebuffer, scene()->lightingEnvironment(), m_gbuffer, allSurfaces);
+    // Pass statistics are only comparable at a fixed resolution. The render scale
+    // controller doesn't read them, so starting them over doesn't affect the scale.
+    const Vector2int32 resolution(m_framebuffer->width(), m_framebuffer->height());
+    if (resolution != m_passTimerResolution) {
+        m_passTimer.clearStatistics();
+        m_passTimerResolution = resolution;
 
-    // Debug visualizations and post-process effects
-    rd->pushState(m_framebuffer); {
-        // Call to make the App show the output of debugDraw(...)
-        rd->setProjectionAndCameraMatrix(activeCamera()->projection(), activeCamera()->frame());
-        drawDebugShapes();
-        const shared_ptr<Entity>& selectedEntity = (notNull(developerWindow) && notNull(developerWindow->sceneEditorWindow)) ? developerWindow->sceneEditorWindow->selectedEntity() : shared_ptr<Entity>();
-        scene()->visualize(rd, selectedEntity, allSurfaces, sceneVisualizationSettings());
+        for (int i = 0; i < PASS_COUNT; ++i) {
+            m_passRunCounts[i] = 0;
+        }
+    }
 
-        // Post-process special effects
-        m_depthOfField->apply(rd, m_framebuffer->texture(0), m_framebuffer->texture(Framebuffer::DEPTH), activeCamera(), m_settings.depthGuardBandThickness - m_settings.colorGuardBandThickness);
+    m_passTimer.beginFrame();
+    m_passesRun = 0;
+    m_renderTargetSetup.beginFrame();
 
-        m_motionBlur->apply(rd, m_framebuffer->texture(0), m_gbuffer->texture(GBuffer::Field::SS_EXPRESSIVE_MOTION),
-                            m_framebuffer->texture(Framebuffer::DEPTH), activeCamera(),
-                            m_settings.depthGuardBandThickness - m_settings.colorGuardBandThickness);
-    } rd->popState();
+    //
+    // Skip passes that cannot change the image. When neither the camera nor the scene
+    // has changed since the previous frame, m_framebuffer still holds the previous
+    // post-processed result, so we only need to tone map it again.
+    //
+    const bool dofEnabled        = activeCamera()->depthOfFieldSettings().enabled();
+    const bool motionBlurEnabled = activeCamera()->motionBlurSettings().enabled();
+    const bool viewStatic        = updateMotionState(resolution);
+    const bool reuseFramebuffer  = viewStatic && m_framebufferReusable && (debugShapeArray.size() == 0);
+
+    if (! reuseFramebuffer) {
+        beginPass(PASS_GBUFFER_PREPARE);
+        m_renderTargetSetup.setupGBuffer(m_gbuffer, m_gbufferSpecification, m_framebuffer->width(), m_framebuffer->height());
+        m_gbuffer->prepare(rd, activeCamera(), 0, -(float)previousSimTimeStep(), m_depthGuardBand, m_colorGuardBand);
+        endPass(PASS_GBUFFER_PREPARE);
+
+        beginPass(PASS_RENDER);
+        m_renderer->render(rd, m_framebuffer, m_depthPeelFramebuffer, scene()->lightingEnvironment(), m_gbuffer, allSurfaces);
+        endPass(PASS_RENDER);
+
+        // Debug visualizations and post-process effects
+        rd->pushState(m_framebuffer); {
+            // Call to make the App show the output of debugDraw(...)
+            beginPass(PASS_DEBUG_SHAPES);
+            rd->setProjectionAndCameraMatrix(activeCamera()->projection(), activeCamera()->frame());
+            drawDebugShapes();
+            endPass(PASS_DEBUG_SHAPES);
+
+            beginPass(PASS_SCENE_VISUALIZATION);
+            const shared_ptr<Entity>& selectedEntity = (notNull(developerWindow) && notNull(developerWindow->sceneEditorWindow)) ? developerWindow->sceneEditorWindow->selectedEntity() : shared_ptr<Entity>();
+            scene()->visualize(rd, selectedEntity, allSurfaces, sceneVisualizationSettings());
+            endPass(PASS_SCENE_VISUALIZATION);
+
+            // Post-process special effects
+            if (dofEnabled) {
+                beginPass(PASS_DEPTH_OF_FIELD);
+                m_depthOfField->apply(rd, m_framebuffer->texture(0), m_framebuffer->texture(Framebuffer::DEPTH), activeCamera(), m_depthGuardBand - m_colorGuardBand);
+                endPass(PASS_DEPTH_OF_FIELD);
+            }
+
+            // Without camera or scene motion the motion vectors are all zero, so there is nothing to blur
+            if (motionBlurEnabled && ! viewStatic) {
+                beginPass(PASS_MOTION_BLUR);
+                m_motionBlur->apply(rd, m_framebuffer->texture(0), m_gbuffer->texture(GBuffer::Field::SS_EXPRESSIVE_MOTION),
+                                    m_framebuffer->texture(Framebuffer::DEPTH), activeCamera(),
+                                    m_depthGuardBand - m_colorGuardBand);
+                endPass(PASS_MOTION_BLUR);
+            }
+        } rd->popState();
+
+        // A motion-blurred frame must not be tone mapped again once the view stops,
+        // so the first static frame after motion renders in full
+        m_framebufferReusable = viewStatic || ! motionBlurEnabled;
+    }
 
     if ((submitToDisplayMode() == SubmitToDisplayMode::MAXIMIZE_THROUGHPUT) && (!renderDevice->swapBuffersAutomatically())) {
         // We're about to render to the actual back buffer, so swap the buffers now.
@@ -105,12 +190,470 @@ void StarterApp::onGraphics3D(RenderDevice* rd, Array<shared_ptr<Surface> >& all
         //swapBuffers();
     }
 
+    beginPass(PASS_FILM);
+
     // Clear the entire screen (needed even though we'll render over it, since
     // AFR uses clear() to detect that the buffer is not re-used.)
     rd->clear();
 
-    // Perform gamma correction, bloom, and SSAA, and write to the native window frame buffer
+    // Perform gamma correction, bloom, and SSAA, and write to the native window frame buffer.
+    // When dynamic resolution is enabled, this also upscales m_framebuffer to the native size.
     m_film->exposeAndRender(rd, activeCamera()->filmSettings(), m_framebuffer->texture(0));
+    endPass(PASS_FILM);
+
+    m_passTimer.endFrame();
+
+    if (m_dynamicResolution.settings().enabled) {
+        screenPrintf("Render scale: %.3f (%dx%d)", m_dynamicResolution.scale(), resolution.x, resolution.y);
+    }
+
+    if (m_showPassTimings) {
+        // Built on the stack, so that a steady-state frame does not allocate
+        char   passesRun[256] = "";
+        size_t length         = 0;
+        for (int i = 0; i < PASS_COUNT; ++i) {
+            if (passRanLastFrame((Pass)i)) {
+                length += snprintf(passesRun + length, sizeof(passesRun) - length, "%s%s", (length == 0) ? "" : ", ", passName((Pass)i));
+            }
+        }
+        screenPrintf("Passes run: %s", passesRun);
+    }
+
+    if (m_showPassTimings) {
+        screenPrintf("Render target reallocations: %d this frame, %llu in total",
+                     m_renderTargetSetup.appliedChanges(), (unsigned long long)m_renderTargetSetup.totalAppliedChanges());
+        screenPrintf("GPU pass timings at %dx%d (ms)   mean    p50    p99    max", resolution.x, resolution.y);
+        for (int i = 0; i < PASS_COUNT; ++i) {
+            const mojo::SampleStatistics& statistics = passStatistics((Pass)i);
+            screenPrintf("  %-20s %6.2f %6.2f %6.2f %6.2f", passName((Pass)i), statistics.mean, statistics.p50, statistics.p99, statistics.max);
+        }
+    }
+}
+
+
+bool StarterApp::updateMotionState(const Vector2int32& resolution) {
+    const shared_ptr<Camera>& camera      = activeCamera();
+    const RealTime            sceneChange = scene()->lastVisibleChangeTime();
+
+    const bool viewStatic =
+        (camera                     == m_previousCamera)           &&
+        (camera->frame()            == m_previousCameraFrame)      &&
+        (camera->fieldOfViewAngle() == m_previousFieldOfViewAngle) &&
+        (sceneChange                == m_previousSceneChangeTime)  &&
+        (resolution                 == m_previousResolution);
+
+    if (! viewStatic) {
+        m_framebufferReusable = false;
+    }
+
+    m_previousCamera           = camera;
+    m_previousCameraFrame      = camera->frame();
+    m_previousFieldOfViewAngle = camera->fieldOfViewAngle();
+    m_previousSceneChangeTime  = sceneChange;
+    m_previousResolution       = resolution;
+
+    return viewStatic;
+}
+
+
+bool StarterApp::passRanLastFrame(Pass pass) const {
+    return (m_passesRun & (1 << pass)) != 0;
+}
+
+
+int StarterApp::passRunCount(Pass pass) const {
+    return m_passRunCounts[pass];
+}
+
+
+void StarterApp::updateRenderScale() {
+    if (m_dynamicResolutionEnabled != m_dynamicResolution.settings().enabled) {
+        mojo::DynamicResolutionController::Settings settings = m_dynamicResolution.settings();
+        settings.enabled = m_dynamicResolutionEnabled;
+        m_dynamicResolution.setSettings(settings);
+    }
+
+    //
+    // Feed the controller each frame once, when its GPU timings are read back. The
+    // timings of passes that frame skipped read as 0 rather than as their last cost.
+    // Without timer queries, we feed it every frame with the CPU time alone.
+    //
+    mojo::FrameProfiler* frameProfiler = mojo::FrameProfiler::current();
+
+    if (!m_passTimer.supported() || (m_passTimer.resolvedFrames() != m_resolvedPassTimings)) {
+        m_resolvedPassTimings = m_passTimer.resolvedFrames();
+
+        float gpuMilliseconds = 0.0f;
+        for (int i = 0; i < PASS_COUNT; ++i) {
+            gpuMilliseconds += m_passTimer.lastMilliseconds(i);
+        }
+
+        float cpuMilliseconds = (frameProfiler != NULL) ? frameProfiler->lastCPUMilliseconds(mojo::FrameProfiler::ZONE_LOOP_BODY) : 0.0f;
+
+        m_dynamicResolution.addFrame(gpuMilliseconds, cpuMilliseconds);
+    }
+
+    if (frameProfiler != NULL) {
+        frameProfiler->setRenderScale(m_dynamicResolution.scale());
+    }
+
+    //
+    // The guard bands are part of the scaled image, so they scale with it, and the
+    // same scaled thicknesses go to the GBuffer, depth of field and motion blur.
+    //
+    m_depthGuardBand = scaledGuardBand(m_settings.depthGuardBandThickness);
+    m_colorGuardBand = scaledGuardBand(m_settings.colorGuardBandThickness);
+
+    // The scale is quantized and changes at most once per adjustment window, so
+    // this only reallocates the render targets when the scale actually changes
+    const int width  = m_dynamicResolution.scaledSize(window()->width())  + 2 * m_depthGuardBand.x;
+    const int height = m_dynamicResolution.scaledSize(window()->height()) + 2 * m_depthGuardBand.y;
+
+    if ((m_framebuffer->width() != width) || (m_framebuffer->height() != height)) {
+        m_framebuffer->resize(width, height);
+        if (notNull(m_depthPeelFramebuffer)) {
+            m_depthPeelFramebuffer->resize(width, height);
+        }
+    }
+}
+
+
+Vector2int16 StarterApp::scaledGuardBand(const Vector2int16& thickness) const {
+    const float scale = m_dynamicResolution.scale();
+    return Vector2int16((int16)floor(thickness.x * scale + 0.5f), (int16)floor(thickness.y * scale + 0.5f));
+}
+
+
+shared_ptr<StarterApp::View> StarterApp::createView(OSWindow* window) {
+    const shared_ptr<View>& view = std::make_shared<View>();
+
+    view->app    = this;
+    view->window = window;
+    view->camera = Camera::create("View::camera");
+    view->camera->copyParametersFrom(activeCamera());
+    view->camera->setFrame(activeCamera()->frame());
+
+    view->gbuffer              = GBuffer::create(m_gbufferSpecification, "View::gbuffer");
+    view->framebuffer          = Framebuffer::create(
+        Texture::createEmpty("View::framebuffer::color", window->width(), window->height(), m_framebuffer->texture(0)->format()),
+        Texture::createEmpty("View::framebuffer::depth", window->width(), window->height(), m_framebuffer->texture(Framebuffer::DEPTH)->format()));
+    view->depthPeelFramebuffer = Framebuffer::create(
+        Texture::createEmpty("View::depthPeelFramebuffer::depth", window->width(), window->height(), m_framebuffer->texture(Framebuffer::DEPTH)->format()));
+    view->film                 = Film::create();
+    view->depthOfField         = DepthOfField::create();
+
+    // Renderers keep per-frame state, e.g., of their ambient occlusion, so views don't share ours
+    const shared_ptr<DefaultRenderer>& renderer = dynamic_pointer_cast<DefaultRenderer>(DefaultRenderer::create());
+    renderer->setOrderIndependentTransparency(false);
+    view->renderer = renderer;
+
+    return view;
+}
+
+
+void StarterApp::renderView(View& view) {
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_GRAPHICS_3D);
+
+    if (! scene()) {
+        return;
+    }
+
+    RenderDevice* rd     = renderDevice;
+    const int     width  = view.window->width();
+    const int     height = view.window->height();
+
+    // Nothing is reallocated unless the view's window changed size
+    view.renderTargetSetup.beginFrame();
+    view.renderTargetSetup.resizeFramebuffer(view.framebuffer, width, height);
+    view.renderTargetSetup.resizeFramebuffer(view.depthPeelFramebuffer, width, height);
+    view.renderTargetSetup.setupGBuffer(view.gbuffer, m_gbufferSpecification, width, height);
+
+    // The view's framebuffer has no guard bands, see StarterAppView
+    const Vector2int16 noGuardBand(0, 0);
+
+    view.gbuffer->prepare(rd, view.camera, 0, -(float)previousSimTimeStep(), noGuardBand, noGuardBand);
+    view.renderer->render(rd, view.framebuffer, view.depthPeelFramebuffer, scene()->lightingEnvironment(), view.gbuffer, m_viewSurfaces);
+
+    if (view.camera->depthOfFieldSettings().enabled()) {
+        rd->pushState(view.framebuffer); {
+            rd->setProjectionAndCameraMatrix(view.camera->projection(), view.camera->frame());
+            view.depthOfField->apply(rd, view.framebuffer->texture(0), view.framebuffer->texture(Framebuffer::DEPTH), view.camera, noGuardBand);
+        } rd->popState();
+    }
+
+    rd->clear();
+    view.film->exposeAndRender(rd, view.camera->filmSettings(), view.framebuffer->texture(0));
+}
+
+
+void StarterApp::viewLoopBody(void* arg) {
+    View* view = static_cast<View*>(arg);
+
+    //
+    // A View has no GApp of its own to consume the events fired at its window, so we
+    // drain them here to keep the window's event queue from growing without bound.
+    // Code that drives the view's camera, e.g., a multi-view editor, can set
+    // view->camera directly.
+    //
+    GEvent event;
+    while (view->window->pollEvent(event)) {
+    }
+
+    // Like GApp::oneFrame(), so the RenderDevice's per-frame state is reset for the view
+    RenderDevice* rd = view->app->renderDevice;
+    rd->beginFrame();
+    view->app->renderView(*view);
+    rd->endFrame();
+}
+
+
+void StarterApp::setDynamicResolutionSettings(const mojo::DynamicResolutionController::Settings& settings) {
+    m_dynamicResolution.setSettings(settings);
+    m_dynamicResolutionEnabled = settings.enabled;
+}
+
+
+float StarterApp::renderScale() const {
+    return m_dynamicResolution.scale();
+}
+
+
+void StarterApp::beginPass(Pass pass) {
+    m_passesRun |= 1 << pass;
+    ++m_passRunCounts[pass];
+    m_passTimer.beginZone(pass);
+}
+
+
+void StarterApp::endPass(Pass pass) {
+    m_passTimer.endZone(pass);
+}
+
+
+const char* StarterApp::passName(Pass pass) {
+    switch (pass) {
+    case PASS_GBUFFER_PREPARE:     return "GBuffer prepare";
+    case PASS_RENDER:              return "Render";
+    case PASS_DEBUG_SHAPES:        return "Debug shapes";
+    case PASS_SCENE_VISUALIZATION: return "Scene visualization";
+    case PASS_DEPTH_OF_FIELD:      return "Depth of field";
+    case PASS_MOTION_BLUR:         return "Motion blur";
+    case PASS_FILM:                return "Film";
+    default:                       return "Unknown";
+    }
+}
+
+
+mojo::SampleStatistics StarterApp::passStatistics(Pass pass) const {
+    return m_passTimer.statistics(pass);
+}
+
+
+Vector2int32 StarterApp::passStatisticsResolution() const {
+    return m_passTimerResolution;
+}
+
+
+bool StarterApp::passesWithinBudget(const Table<String, float>& budgets, const Vector2int32& resolution, int minSamples, Array<String>& failedPasses, Array<String>& skippedPasses) const {
+    bool withinBudget = true;
+
+    for (int i = 0; i < PASS_COUNT; ++i) {
+        const String name = passName((Pass)i);
+        if (! budgets.containsKey(name)) {
+            continue;
+        }
+
+        // A pass that was skipped in most frames never collects enough samples to judge
+        if ((resolution == m_passTimerResolution) && (m_passRunCounts[i] < minSamples)) {
+            skippedPasses.append(name);
+            continue;
+        }
+
+        const mojo::SampleStatistics& statistics = passStatistics((Pass)i);
+        if ((resolution != m_passTimerResolution) || (statistics.count < minSamples) || (statistics.p99 > budgets.get(name))) {
+            failedPasses.append(name);
+            withinBudget = false;
+        }
+    }
+
+    return withinBudget;
+}
+
+
+void StarterApp::onFixedStepSimulation(SimulationState& state, SimTime time, SimTime timeStep) {
+    (void)time;
+    // Add fixed-step simulation code here. Note that this may run on a worker thread
+
+    for (int i = 0; i < state.frames.size(); ++i) {
+        const Vector3& angularVelocity = state.angularVelocities[i];
+        const float    speed           = angularVelocity.length();
+
+        if (speed > 0.0f) {
+            PhysicsFrame& frame = state.frames[i];
+            frame.rotation = (Quat::fromAxisAngleRotation(angularVelocity / speed, speed * (float)timeStep) * frame.rotation).toUnit();
+        }
+    }
+}
+
+
+void StarterApp::addSimulatedEntity(const shared_ptr<Entity>& entity, const Vector3& angularVelocity) {
+    MOJO_RELEASE_ASSERT(notNull(entity));
+
+    // The worker owns its state, so it starts over with the new entity in it
+    const bool threaded = threadedSimulation();
+    setThreadedSimulation(false);
+
+    m_simulatedEntities.append(entity);
+    m_currentSimulationState.frames.append(PhysicsFrame(entity->frame()));
+    m_currentSimulationState.angularVelocities.append(angularVelocity);
+
+    setThreadedSimulation(threaded, m_simulationTimeStep);
+}
+
+
+void StarterApp::onAfterLoadScene(const Any& any, const String& sceneName) {
+    GApp::onAfterLoadScene(any, sceneName);
+
+    // The entities we simulated went away with the previous scene
+    const bool threaded = threadedSimulation();
+    setThreadedSimulation(false);
+
+    m_simulatedEntities.fastClear();
+    m_currentSimulationState.frames.fastClear();
+    m_currentSimulationState.angularVelocities.fastClear();
+    m_pendingSimulationTime = 0.0;
+
+    setThreadedSimulation(threaded, m_simulationTimeStep);
+}
+
+
+void StarterApp::readSimulatedFrames(SimulationState& state) const {
+    for (int i = 0; i < m_simulatedEntities.size(); ++i) {
+        state.frames[i] = PhysicsFrame(m_simulatedEntities[i]->frame());
+    }
+}
+
+
+void StarterApp::insertModel(const shared_ptr<ArticulatedModel>& model, const View* view, const Point2& position) {
+    MOJO_RELEASE_ASSERT(notNull(model));
+
+    if (isNull(scene())) {
+        return;
+    }
+
+    static const float kTurntableSpeed = 0.25f;
+
+    addSimulatedEntity(insertEntity(model, dropFrame(view, position)), Vector3(0.0f, kTurntableSpeed, 0.0f));
+}
+
+
+void StarterApp::insertPicture(const shared_ptr<Texture>& texture, const View* view, const Point2& position) {
+    MOJO_RELEASE_ASSERT(notNull(texture));
+
+    if (isNull(scene())) {
+        return;
+    }
+
+    // A two-sided quad with its bottom edge at the origin of its part, so it stands on what it was dropped on
+    const float width  = (float)texture->width() / max(texture->height(), 1);
+    const float height = 1.0f;
+
+    const shared_ptr<ArticulatedModel>& model    = ArticulatedModel::createEmpty(FilePath::baseExt(texture->name()));
+    ArticulatedModel::Part*             part     = model->addPart("root");
+    ArticulatedModel::Geometry*         geometry = model->addGeometry("quad");
+    ArticulatedModel::Mesh*             mesh     = model->addMesh("quad", part, geometry);
+
+    const Point3 corners[4]   = { Point3(-0.5f * width, height, 0.0f), Point3(-0.5f * width, 0.0f, 0.0f), Point3(0.5f * width, 0.0f, 0.0f), Point3(0.5f * width, height, 0.0f) };
+    const Point2 texCoords[4] = { Point2(0.0f, 0.0f), Point2(0.0f, 1.0f), Point2(1.0f, 1.0f), Point2(1.0f, 0.0f) };
+
+    CPUVertexArray& cpuVertexArray = geometry->cpuVertexArray;
+    cpuVertexArray.hasTangent   = true;
+    cpuVertexArray.hasTexCoord0 = true;
+    cpuVertexArray.vertex.resize(4);
+    for (int i = 0; i < 4; ++i) {
+        CPUVertexArray::Vertex& vertex = cpuVertexArray.vertex[i];
+        vertex.position  = corners[i];
+        vertex.normal    = Vector3::unitZ();
+        vertex.tangent   = Vector4(1.0f, 0.0f, 0.0f, 1.0f);
+        vertex.texCoord0 = texCoords[i];
+    }
+
+    mesh->primitive = PrimitiveType::TRIANGLES;
+    mesh->twoSided  = true;
+    mesh->material  = UniversalMaterial::createDiffuse(texture);
+    mesh->cpuIndexArray.append(0, 1, 2);
+    mesh->cpuIndexArray.append(0, 2, 3);
+
+    ArticulatedModel::CleanGeometrySettings settings;
+    settings.allowVertexMerging = false;
+    model->cleanGeometry(settings);
+
+    insertEntity(model, dropFrame(view, position));
+}
+
+
+CFrame StarterApp::dropFrame(const View* view, const Point2& position) const {
+    static const float kDefaultDropDistance = 3.0f;
+
+    const shared_ptr<Camera>& camera = notNull(view) ? view->camera : activeCamera();
+    const OSWindow*           target = notNull(view) ? view->window : window();
+    const Ray&                ray    = camera->worldRay(position.x, position.y, Rect2D::xywh(0, 0, (float)target->width(), (float)target->height()));
+
+    // Dropped on nothing, it lands in front of the camera
+    float distance = finf();
+    if (isNull(scene()->intersect(ray, distance))) {
+        distance = kDefaultDropDistance;
+    }
+
+    const Point3&  point    = ray.origin() + ray.direction() * distance;
+    const Vector3& toCamera = camera->frame().translation - point;
+
+    return CFrame::fromXYZYPRRadians(point.x, point.y, point.z, atan2(toCamera.x, toCamera.z));
+}
+
+
+shared_ptr<Entity> StarterApp::insertEntity(const shared_ptr<ArticulatedModel>& model, const CFrame& frame) {
+    String name = model->name();
+    for (int i = 2; notNull(scene()->entity(name)); ++i) {
+        name = format("%s%d", model->name().c_str(), i);
+    }
+
+    const shared_ptr<Entity>& entity = VisibleEntity::create(name, scene().get(), model, frame);
+
+    scene()->insert(model);
+    scene()->insert(entity);
+
+    m_framebufferReusable = false;
+    return entity;
+}
+
+
+void StarterApp::setThreadedSimulation(bool enabled, SimTime timeStep) {
+    if (enabled == threadedSimulation()) {
+        return;
+    }
+
+    if (enabled) {
+        // Start from where the entities are, e.g., after they were moved in the scene editor
+        readSimulatedFrames(m_currentSimulationState);
+        m_simulationTimeStep = timeStep;
+
+        m_fixedStepSimulation.reset(new mojo::FixedStepSimulation<SimulationState>(
+            m_currentSimulationState,
+            timeStep,
+            [this](SimulationState& state, double time, double step) { onFixedStepSimulation(state, time, step); }));
+
+        m_fixedStepSimulation->start();
+    } else {
+        m_fixedStepSimulation.reset();
+    }
+
+    m_threadedSimulationEnabled = enabled;
+}
+
+
+bool StarterApp::threadedSimulation() const {
+    return (bool)m_fixedStepSimulation;
 }
 
 
@@ -127,15 +670,65 @@ void StarterApp::onNetwork() {
 
 
 void StarterApp::onSimulation(RealTime rdt, SimTime sdt, SimTime idt) {
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_SIMULATION);
+
     GApp::onSimulation(rdt, sdt, idt);
 
+    setThreadedSimulation(m_threadedSimulationEnabled, m_simulationTimeStep);
+
+    //
+    // Without threaded simulation, the fixed-step simulation runs here, taking as many
+    // fixed steps as fit this frame's time step. Like on the worker, a frame takes at
+    // most kMaxCatchUpSteps steps and drops the time left over after those.
+    //
+    if (! m_fixedStepSimulation && (m_simulatedEntities.size() > 0)) {
+        static const int kMaxCatchUpSteps = mojo::FixedStepSimulation<SimulationState>::kMaxCatchUpSteps;
+
+        m_pendingSimulationTime += sdt;
+
+        int steps = 0;
+        if (m_pendingSimulationTime >= m_simulationTimeStep) {
+            readSimulatedFrames(m_currentSimulationState);
+        }
+
+        while ((m_pendingSimulationTime >= m_simulationTimeStep) && (steps < kMaxCatchUpSteps)) {
+            onFixedStepSimulation(m_currentSimulationState, simTime() - m_pendingSimulationTime, m_simulationTimeStep);
+            m_pendingSimulationTime -= m_simulationTimeStep;
+            ++steps;
+        }
+
+        if (m_pendingSimulationTime >= m_simulationTimeStep) {
+            m_pendingSimulationTime = 0.0;
+        }
+
+        if (steps > 0) {
+            for (int i = 0; i < m_simulatedEntities.size(); ++i) {
+                m_simulatedEntities[i]->setFrame(m_currentSimulationState.frames[i].toCoordinateFrame());
+            }
+        }
+    }
+
     // Example GUI dynamic layout code.  Resize the debugWindow to fill
     // the screen horizontally.
-    debugWindow->setRect(Rect2D::xywh(0, 0, (float)window()->width(), debugWindow->rect().height()));
+    // Setting the rect lays the window out again, so we only do it when the width changed
+    if (window()->width() != m_debugWindowWidth) {
+        debugWindow->setRect(Rect2D::xywh(0, 0, (float)window()->width(), debugWindow->rect().height()));
+        m_debugWindowWidth = window()->width();
+        m_guiLayer.invalidate();
+    }
 }
 
 
 bool StarterApp::onEvent(const GEvent& event) {
+    // Anything other than plain mouse motion may change what onGraphics3D draws,
+    // e.g., a GUI control or a key that toggles a visualization, so the previous
+    // frame can no longer be reused as is
+    if ((event.type != GEventType::MOUSE_MOTION) && (event.type != GEventType::FOCUS)) {
+        m_framebufferReusable = false;
+    }
+
+    m_guiLayer.onEvent(event);
+
     // Handle super-class events
     if (GApp::onEvent(event)) { return true; }
 
@@ -160,21 +753,43 @@ void StarterApp::onUserInput(UserInput* ui) {
 
 
 void StarterApp::onPose(Array<shared_ptr<Surface> >& surface, Array<shared_ptr<Surface2D> >& surface2D) {
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_POSE);
+
+    // Apply the interpolated result of the fixed-step simulation, if it runs on its own thread
+    if (m_fixedStepSimulation) {
+        float alpha = 0.0f;
+        if (m_fixedStepSimulation->sample(m_previousSimulationState, m_currentSimulationState, alpha)) {
+            for (int i = 0; i < m_simulatedEntities.size(); ++i) {
+                const PhysicsFrame& frame = m_previousSimulationState.frames[i].lerp(m_currentSimulationState.frames[i], alpha);
+                m_simulatedEntities[i]->setFrame(frame.toCoordinateFrame());
+            }
+        }
+    }
+
     GApp::onPose(surface, surface2D);
 
     // Append any models to the arrays that you want to later be rendered by onGraphics()
+
+    // Views render what we posed this frame instead of posing the scene again
+    m_viewSurfaces.fastClear();
+    m_viewSurfaces.append(surface);
 }
 
 
 void StarterApp::onGraphics2D(RenderDevice* rd, Array<shared_ptr<Surface2D> >& posed2D) {
+    MOJO_PROFILE_ZONE(mojo::FrameProfiler::ZONE_GRAPHICS_2D);
+
     // Render 2D objects like Widgets.  These do not receive tone mapping or gamma correction.
-    Surface2D::sortAndRender(rd, posed2D);
+    // They are cached in a texture that is only re-rendered when they may have changed.
+    m_guiLayer.render(rd, posed2D);
 }
 
 
 void StarterApp::onCleanup() {
     // Called after the application loop ends.  Place a majority of cleanup code
     // here instead of in the constructor so that exceptions can be caught.
+    setThreadedSimulation(false);
+    m_passTimer.cleanup();
 }
 
 
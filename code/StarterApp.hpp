@@ -4,22 +4,186 @@
 #include "G3D/G3D.h"
 #include "GLG3D/GLG3D.h"
 
+#include "GPUTimer.hpp"
+#include "DynamicResolutionController.hpp"
+#include "FixedStepSimulation.hpp"
+#include "CachedGUILayer.hpp"
+#include "RenderTargetSetup.hpp"
+
 namespace G3D
 {
 
+class StarterApp;
+
+/**
+  An additional view of a StarterApp's scene, rendered into another OSWindow (e.g., a
+  second G3DWidget) from its own camera, with its own G-buffer, renderer and
+  post-processing. Views never simulate or pose the scene; they render the surfaces
+  the app posed in its most recent onPose, so the cost of simulation does not grow
+  with the number of views. Bind a view to its window with
+  pushLoopBody(StarterApp::viewLoopBody, view).
+
+  A view's framebuffer is the size of its window, without guard bands, so it renders
+  and post-processes with guard bands of zero.
+ */
+class StarterAppView {
+public:
+    StarterApp*              app;
+    OSWindow*                window;
+    shared_ptr<Camera>       camera;
+    shared_ptr<GBuffer>      gbuffer;
+    shared_ptr<Framebuffer>  framebuffer;
+    shared_ptr<Framebuffer>  depthPeelFramebuffer;
+    shared_ptr<Renderer>     renderer;
+    shared_ptr<DepthOfField> depthOfField;
+    shared_ptr<Film>         film;
+
+    /** Counts the view's own render target reallocations. */
+    mojo::RenderTargetSetup  renderTargetSetup;
+};
+
 class StarterApp : public GApp {
+public:
+
+    /** The passes of onGraphics3D that are timed on the GPU. */
+    enum Pass {
+        PASS_GBUFFER_PREPARE,
+        PASS_RENDER,
+        PASS_DEBUG_SHAPES,
+        PASS_SCENE_VISUALIZATION,
+        PASS_DEPTH_OF_FIELD,
+        PASS_MOTION_BLUR,
+        PASS_FILM,
+        PASS_COUNT
+    };
+
+    /** See StarterAppView. */
+    typedef StarterAppView View;
+
+    /** The state advanced by onFixedStepSimulation: the frame and the angular velocity,
+        in radians per second about a world-space axis, of each simulated entity. */
+    class SimulationState {
+    public:
+        Array<PhysicsFrame>     frames;
+        Array<Vector3>          angularVelocities;
+    };
+
 protected:
 
+    /** Entities whose frames are driven by onFixedStepSimulation, in SimulationState order. */
+    Array<shared_ptr<Entity> >        m_simulatedEntities;
+
+    /** Runs onFixedStepSimulation on a worker thread while threaded simulation is enabled. */
+    std::unique_ptr<mojo::FixedStepSimulation<SimulationState> > m_fixedStepSimulation;
+
+    SimulationState                   m_previousSimulationState;
+    SimulationState                   m_currentSimulationState;
+    bool                              m_threadedSimulationEnabled;
+
+    /** The fixed time step of onFixedStepSimulation, on the worker thread or not. */
+    SimTime                           m_simulationTimeStep;
+
+    /** Simulation time that onSimulation has not taken a fixed step for yet. */
+    SimTime                           m_pendingSimulationTime;
+
+    /** GPU time of each Pass, double-buffered so that reading results never stalls. */
+    mojo::GPUTimer                    m_passTimer;
+
+    /** The framebuffer size that the current pass statistics were measured at. */
+    Vector2int32                      m_passTimerResolution;
+
+    bool                              m_showPassTimings;
+
+    /** Sets up m_gbuffer each frame and counts the changes that reallocate it. */
+    mojo::RenderTargetSetup           m_renderTargetSetup;
+
+    /** Renders the 2D surfaces, e.g., the developer HUD, only when they may have changed. */
+    mojo::CachedGUILayer              m_guiLayer;
+
+    /** The width debugWindow was last laid out for, so we only set its rect when it changes. */
+    int                               m_debugWindowWidth;
+
+    /** Chooses the scale of m_framebuffer and m_gbuffer relative to the native window size. */
+    mojo::DynamicResolutionController m_dynamicResolution;
+    bool                              m_dynamicResolutionEnabled;
+
+    /** m_passTimer.resolvedFrames() when m_dynamicResolution was last fed a frame. */
+    int                               m_resolvedPassTimings;
+
+    /** m_settings' guard band thicknesses at the current render scale. */
+    Vector2int16                      m_depthGuardBand;
+    Vector2int16                      m_colorGuardBand;
+
+    /** Bitmask of (1 << Pass) for the passes that ran in the most recent frame. */
+    int                               m_passesRun;
+
+    /** The number of frames that ran each Pass since the pass statistics were cleared. */
+    int                               m_passRunCounts[PASS_COUNT];
+
+    /** True while m_framebuffer holds a finished frame that is still valid to display. */
+    bool                              m_framebufferReusable;
+
+    /** State of the previous frame, used to detect a static camera and scene. */
+    shared_ptr<Camera>                m_previousCamera;
+    CFrame                            m_previousCameraFrame;
+    float                             m_previousFieldOfViewAngle;
+    RealTime                          m_previousSceneChangeTime;
+    Vector2int32                      m_previousResolution;
+
+    /**
+      The surfaces posed in the most recent onPose, shared by every View. Views render
+      in the updates of their own G3DWidgets, after our frame arena was reset, so this
+      is a member that keeps its capacity rather than an array from the arena.
+     */
+    Array<shared_ptr<Surface> >       m_viewSurfaces;
+
     /** Called from onInit */
     void makeGUI();
 
+    /**
+      Advances \a state by one fixed \a timeStep. While threaded simulation is enabled,
+      this runs on a worker thread, so it must only read and write \a state. onPose
+      interpolates between the two most recent states and applies the result to
+      m_simulatedEntities. Otherwise onSimulation takes as many fixed steps as fit
+      the frame's time step, at most mojo::FixedStepSimulation::kMaxCatchUpSteps.
+
+      The default turns each entity at its angular velocity.
+     */
+    virtual void onFixedStepSimulation(SimulationState& state, SimTime time, SimTime timeStep);
+
+    /** Called from onGraphics3D. Returns true if neither the camera nor the scene changed
+        since the previous frame. */
+    bool updateMotionState(const Vector2int32& resolution);
+
+    /** Where something dropped at \a position, in pixels of \a view's window or of this
+        app's window if \a view is NULL, lands in the scene: on the first surface under
+        it, turned to face the camera. */
+    CFrame dropFrame(const View* view, const Point2& position) const;
+
+    /** Inserts \a model with an entity of its own at \a frame, both named after the model. */
+    shared_ptr<Entity> insertEntity(const shared_ptr<ArticulatedModel>& model, const CFrame& frame);
+
+    /** Sets the frames in \a state to the current frames of m_simulatedEntities. */
+    void readSimulatedFrames(SimulationState& state) const;
+
+    /** Called from onGraphics3D. Resizes the render targets if the render scale changed. */
+    void updateRenderScale();
+
+    /** \a thickness, in native pixels, at the current render scale. */
+    Vector2int16 scaledGuardBand(const Vector2int16& thickness) const;
+
+    void beginPass(Pass pass);
+    void endPass(Pass pass);
+
 public:
 
     StarterApp(const GApp::Settings& settings = GApp::Settings(), OSWindow* window=NULL, RenderDevice* rd=NULL);
+    virtual ~StarterApp();
     virtual void onInit() override;
     virtual void onAI() override;
     virtual void onNetwork() override;
     virtual void onSimulation(RealTime rdt, SimTime sdt, SimTime idt) override;
+    virtual void onAfterLoadScene(const Any& any, const String& sceneName) override;
     virtual void onPose(Array<shared_ptr<Surface> >& posed3D, Array<shared_ptr<Surface2D> >& posed2D) override;
 
     // You can override onGraphics if you want more control over the rendering loop.
@@ -34,6 +198,75 @@ public:
 
     /** Sets m_endProgram to true. */
     virtual void endProgram();
+
+    /** Creates a View of this app's scene that renders into \a window. The view's camera
+        starts out as a copy of the active camera. */
+    shared_ptr<View> createView(OSWindow* window);
+
+    /** Renders \a view. Must be called after this app's loop body has run for the frame,
+        with \a view's window current. */
+    void renderView(View& view);
+
+    /** A loop body that renders the View passed in \a view as one frame of its window. */
+    static void viewLoopBody(void* view);
+
+    /** Adds an entity whose frame is driven by onFixedStepSimulation, turning at
+        \a angularVelocity. If threaded simulation is running, it is restarted from
+        the current frames of the entities. */
+    void addSimulatedEntity(const shared_ptr<Entity>& entity, const Vector3& angularVelocity = Vector3::zero());
+
+    /** Adds an instance of \a model where it was dropped, e.g., a model that
+        mojo::IngestPipeline loaded after it was dropped on the window. \a position is
+        in pixels of \a view's window, or of this app's window if \a view is NULL.
+        The model turns slowly about the vertical axis, driven by onFixedStepSimulation,
+        so it can be looked at from all sides. */
+    void insertModel(const shared_ptr<ArticulatedModel>& model, const View* view, const Point2& position);
+
+    /** Adds an upright, one meter tall picture of \a texture where it was dropped,
+        facing the camera it was dropped from, like insertModel(). */
+    void insertPicture(const shared_ptr<Texture>& texture, const View* view, const Point2& position);
+
+    /**
+      When enabled, onFixedStepSimulation runs at a fixed \a timeStep on a worker thread
+      instead of sharing the frame budget with rendering, and onPose interpolates
+      between the two most recently published states. The rest of onSimulation, e.g.,
+      camera controllers and GUI, still runs once per frame on the render thread.
+     */
+    void setThreadedSimulation(bool enabled, SimTime timeStep = 1.0 / 120.0);
+    bool threadedSimulation() const;
+
+    void setDynamicResolutionSettings(const mojo::DynamicResolutionController::Settings& settings);
+
+    /** The current scale of the internal render targets relative to the native window size. */
+    float renderScale() const;
+
+    static const char* passName(Pass pass);
+
+    /** True if \a pass ran in the most recent frame. Passes that cannot change the image,
+        e.g., depth of field when it is disabled, are skipped. */
+    bool passRanLastFrame(Pass pass) const;
+
+    /** The number of frames that ran \a pass since passStatistics() were last cleared. */
+    int passRunCount(Pass pass) const;
+
+    /** Rolling GPU time statistics of \a pass, in milliseconds. */
+    mojo::SampleStatistics passStatistics(Pass pass) const;
+
+    /** The framebuffer size that passStatistics() were measured at. Statistics are
+        cleared whenever this changes. */
+    Vector2int32 passStatisticsResolution() const;
+
+    /**
+      Returns true if the p99 GPU time of every pass named in \a budgets is within its
+      budget (in milliseconds), and the statistics were measured at \a resolution with
+      at least \a minSamples samples. Intended for automated performance tests. The
+      names of the passes that fail are appended to \a failedPasses.
+
+      Passes that ran in fewer than \a minSamples frames, e.g., depth of field while it
+      is disabled, or motion blur while the view is static, cannot be judged. They
+      don't fail; their names are appended to \a skippedPasses instead.
+     */
+    bool passesWithinBudget(const Table<String, float>& budgets, const Vector2int32& resolution, int minSamples, Array<String>& failedPasses, Array<String>& skippedPasses) const;
 };
 
 }
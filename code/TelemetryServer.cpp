@@ -0,0 +1,269 @@
+#include "TelemetryServer.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+#include <civetweb.h>
+
+#include "Assert.hpp"
+#include "Printf.hpp"
+#include "G3DWidget.hpp"
+#include "G3DWidgetScheduler.hpp"
+
+namespace mojo
+{
+
+const double TelemetryServer::kEventRateSeconds = 1.0;
+
+// the upper bounds of all but the last bucket, which counts everything slower
+const float TelemetryServer::kHistogramBucketMilliseconds[kHistogramBucketCount - 1] = {
+    4.0f, 8.0f, 12.0f, 16.7f, 25.0f, 33.3f, 50.0f
+};
+
+static void appendf(std::string& json, const char* format, ...) {
+    char buffer[256];
+
+    va_list args;
+    va_start(args, format);
+    int size = std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    MOJO_ASSERT(size >= 0 && size < (int)sizeof(buffer));
+    json.append(buffer, size);
+}
+
+static void appendStatistics(std::string& json, const char* name, const SampleStatistics& statistics) {
+    appendf(json, "\"%s\":{\"count\":%d,\"mean\":%.3f,\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,\"max\":%.3f}",
+        name, statistics.count, statistics.mean, statistics.p50, statistics.p95, statistics.p99, statistics.max);
+}
+
+static void residentBytes(std::uint64_t& current, std::uint64_t& peak) {
+    current = 0;
+    peak    = 0;
+
+#ifdef __APPLE__
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t      count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS) {
+        current = info.resident_size;
+        peak    = info.resident_size_max;
+    }
+#endif
+}
+
+TelemetryServer::TelemetryServer() :
+    m_context      (NULL),
+    m_port         (0),
+    m_startTime    (Clock::now()),
+    m_eventRateTime(Clock::now()) {
+}
+
+TelemetryServer::~TelemetryServer() {
+    stop();
+}
+
+void TelemetryServer::add(const std::string& name, const G3DWidget* g3dWidget) {
+    MOJO_RELEASE_ASSERT(g3dWidget != NULL);
+    MOJO_RELEASE_ASSERT(m_context == NULL);
+
+    std::unique_ptr<Source> source(new Source);
+    source->g3dWidgetName = name;
+    source->g3dWidget     = g3dWidget;
+    source->skippedFrames.store(0, std::memory_order_relaxed);
+    source->estimatedMilliseconds.store(0.0f, std::memory_order_relaxed);
+    source->frameArenaPeakBytes.store(0, std::memory_order_relaxed);
+
+    for (int i = 0; i < InputLatencyTracker::INPUT_TYPE_COUNT; ++i) {
+        source->eventRates[i].store(0.0f, std::memory_order_relaxed);
+        source->eventCounts[i] = g3dWidget->inputLatencyTracker().inputCount((InputLatencyTracker::InputType)i);
+    }
+
+    m_sources.push_back(std::move(source));
+}
+
+bool TelemetryServer::start(int port) {
+    MOJO_RELEASE_ASSERT(m_context == NULL);
+    MOJO_RELEASE_ASSERT(port > 0 && port < 65536);
+
+    //
+    // Binding to the loopback address keeps the endpoint off the network. A single
+    // worker thread is plenty for a scraper, and keeps us from competing with the
+    // render loop for cores.
+    //
+    char listeningPorts[32];
+    std::snprintf(listeningPorts, sizeof(listeningPorts), "127.0.0.1:%d", port);
+
+    const char* options[] = {
+        "listening_ports", listeningPorts,
+        "num_threads",     "1",
+        NULL
+    };
+
+    mg_callbacks callbacks;
+    std::memset(&callbacks, 0, sizeof(callbacks));
+
+    m_context = mg_start(&callbacks, NULL, options);
+    if (m_context == NULL) {
+        mojo::printf("Cannot start the telemetry server on ", listeningPorts);
+        return false;
+    }
+
+    mg_set_request_handler(m_context, "/telemetry$", &TelemetryServer::handleRequest, this);
+
+    m_port = port;
+    mojo::printf("Serving telemetry on http://", listeningPorts, "/telemetry");
+    return true;
+}
+
+void TelemetryServer::stop() {
+    if (m_context == NULL) {
+        return;
+    }
+
+    // waits for the request being handled, if any
+    mg_stop(m_context);
+
+    m_context = NULL;
+    m_port    = 0;
+}
+
+bool TelemetryServer::running() const {
+    return m_context != NULL;
+}
+
+int TelemetryServer::port() const {
+    return m_port;
+}
+
+void TelemetryServer::publish(const G3DWidgetScheduler& g3dWidgetScheduler) {
+    for (const std::unique_ptr<Source>& source : m_sources) {
+        source->skippedFrames.store(g3dWidgetScheduler.skippedFrames(source->g3dWidget), std::memory_order_relaxed);
+        source->estimatedMilliseconds.store(g3dWidgetScheduler.estimatedMilliseconds(source->g3dWidget), std::memory_order_relaxed);
+        source->frameArenaPeakBytes.store(source->g3dWidget->frameArena().peakBytesAllocated(), std::memory_order_relaxed);
+    }
+
+    Clock::time_point now     = Clock::now();
+    double            seconds = std::chrono::duration<double>(now - m_eventRateTime).count();
+
+    if (seconds < kEventRateSeconds) {
+        return;
+    }
+
+    for (const std::unique_ptr<Source>& source : m_sources) {
+        for (int i = 0; i < InputLatencyTracker::INPUT_TYPE_COUNT; ++i) {
+            std::uint64_t count = source->g3dWidget->inputLatencyTracker().inputCount((InputLatencyTracker::InputType)i);
+
+            source->eventRates[i].store((float)((count - source->eventCounts[i]) / seconds), std::memory_order_relaxed);
+            source->eventCounts[i] = count;
+        }
+    }
+
+    m_eventRateTime = now;
+}
+
+std::string TelemetryServer::json() const {
+    std::string json;
+    json.reserve(1024 * m_sources.size() + 256);
+
+    std::uint64_t residentBytesCurrent;
+    std::uint64_t residentBytesPeak;
+    residentBytes(residentBytesCurrent, residentBytesPeak);
+
+    appendf(json, "{\"uptimeSeconds\":%.3f,", std::chrono::duration<double>(Clock::now() - m_startTime).count());
+    appendf(json, "\"memory\":{\"residentBytes\":%llu,\"peakResidentBytes\":%llu},",
+        (unsigned long long)residentBytesCurrent, (unsigned long long)residentBytesPeak);
+
+    json += "\"g3dWidgets\":[";
+    for (std::size_t i = 0; i < m_sources.size(); ++i) {
+        if (i > 0) {
+            json += ",";
+        }
+        writeSource(json, *m_sources[i]);
+    }
+    json += "]}\n";
+
+    return json;
+}
+
+int TelemetryServer::handleRequest(mg_connection* connection, void* userData) {
+    const TelemetryServer* telemetryServer = (const TelemetryServer*)userData;
+    const mg_request_info* requestInfo     = mg_get_request_info(connection);
+
+    if (std::strcmp(requestInfo->request_method, "GET") != 0) {
+        mg_printf(connection, "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return 405;
+    }
+
+    std::string json = telemetryServer->json();
+
+    mg_printf(connection,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: %d\r\n"
+        "Cache-Control: no-store\r\n"
+        "Connection: close\r\n\r\n",
+        (int)json.size());
+    mg_write(connection, json.data(), json.size());
+
+    return 200;
+}
+
+void TelemetryServer::writeSource(std::string& json, const Source& source) const {
+    const FrameProfiler&       frameProfiler       = source.g3dWidget->frameProfiler();
+    const FrameLatencyLimiter& frameLatencyLimiter = source.g3dWidget->frameLatencyLimiter();
+
+    appendf(json, "{\"name\":\"%s\",", source.g3dWidgetName.c_str());
+    appendf(json, "\"frames\":%llu,", (unsigned long long)frameProfiler.frameCount());
+    appendf(json, "\"skippedFrames\":%llu,", (unsigned long long)source.skippedFrames.load(std::memory_order_relaxed));
+    appendf(json, "\"estimatedMilliseconds\":%.3f,", source.estimatedMilliseconds.load(std::memory_order_relaxed));
+    appendf(json, "\"renderScale\":%.3f,", frameProfiler.renderScale());
+    appendf(json, "\"framesInFlight\":%d,", frameLatencyLimiter.framesInFlight());
+    appendf(json, "\"frameArenaPeakBytes\":%llu,", (unsigned long long)source.frameArenaPeakBytes.load(std::memory_order_relaxed));
+
+    appendStatistics(json, "cpuMilliseconds", frameProfiler.cpuStatistics(FrameProfiler::ZONE_UPDATE));
+    json += ",";
+    appendStatistics(json, "gpuMilliseconds", frameProfiler.gpuStatistics(FrameProfiler::ZONE_UPDATE));
+    json += ",";
+
+    //
+    // The histogram is of the update times in the FrameProfiler's history, i.e., of the
+    // last FrameProfiler::kHistorySize frames.
+    //
+    float samples[FrameProfiler::kHistorySize];
+    int   numSamples = frameProfiler.cpuSamples(FrameProfiler::ZONE_UPDATE, samples);
+
+    int counts[kHistogramBucketCount] = {};
+    for (int i = 0; i < numSamples; ++i) {
+        int bucket = 0;
+        while (bucket < kHistogramBucketCount - 1 && samples[i] > kHistogramBucketMilliseconds[bucket]) {
+            ++bucket;
+        }
+        ++counts[bucket];
+    }
+
+    json += "\"histogram\":{\"upperBoundMilliseconds\":[";
+    for (int i = 0; i < kHistogramBucketCount - 1; ++i) {
+        appendf(json, i > 0 ? ",%.1f" : "%.1f", kHistogramBucketMilliseconds[i]);
+    }
+    json += "],\"counts\":[";
+    for (int i = 0; i < kHistogramBucketCount; ++i) {
+        appendf(json, i > 0 ? ",%d" : "%d", counts[i]);
+    }
+    json += "]},";
+
+    json += "\"eventsPerSecond\":{";
+    for (int i = 0; i < InputLatencyTracker::INPUT_TYPE_COUNT; ++i) {
+        appendf(json, i > 0 ? ",\"%s\":%.1f" : "\"%s\":%.1f",
+            InputLatencyTracker::inputTypeName((InputLatencyTracker::InputType)i),
+            source.eventRates[i].load(std::memory_order_relaxed));
+    }
+    json += "}}";
+}
+
+}
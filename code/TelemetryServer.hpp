@@ -0,0 +1,94 @@
+#ifndef TELEMETRY_SERVER_HPP
+#define TELEMETRY_SERVER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "InputLatencyTracker.hpp"
+
+struct mg_context;
+struct mg_connection;
+
+namespace mojo
+{
+
+class G3DWidget;
+class G3DWidgetScheduler;
+
+//
+// TelemetryServer serves live frame statistics of a set of G3DWidgets as JSON over
+// HTTP, so running instances can be scraped by monitoring, or polled by load tests,
+// without access to their GUI:
+//
+//     curl http://127.0.0.1:<port>/telemetry
+//
+// It is opt-in, and only listens on the loopback interface. Requests are handled by a
+// single civetweb worker thread, which only reads the lock-free statistics of each
+// G3DWidget, e.g., the rings of its FrameProfiler, so the render loop never waits on a
+// request. The few values that aren't lock-free, e.g., the skipped frames counted by
+// the G3DWidgetScheduler, are copied into atomics by publish(...), which the thread of
+// the G3DWidgets calls after each tick. Event rates are computed there too.
+//
+// G3DWidgets must be added before start(...), and must outlive stop().
+//
+class TelemetryServer
+{
+public:
+    static const int kHistogramBucketCount = 8;
+
+    TelemetryServer();
+    ~TelemetryServer();
+
+    void add(const std::string& name, const G3DWidget* g3dWidget);
+
+    //
+    // Returns false, and logs why, if the port cannot be bound.
+    //
+    bool start(int port);
+    void stop();
+
+    bool running() const;
+    int port() const;
+
+    void publish(const G3DWidgetScheduler& g3dWidgetScheduler);
+
+    //
+    // The JSON served for /telemetry. Can be called from any thread.
+    //
+    std::string json() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const double kEventRateSeconds;
+    static const float  kHistogramBucketMilliseconds[kHistogramBucketCount - 1];
+
+    struct Source
+    {
+        std::string                g3dWidgetName;
+        const G3DWidget*           g3dWidget;
+        std::atomic<std::uint64_t> skippedFrames;
+        std::atomic<float>         estimatedMilliseconds;
+        std::atomic<std::uint64_t> frameArenaPeakBytes;
+        std::atomic<float>         eventRates[InputLatencyTracker::INPUT_TYPE_COUNT];
+        std::uint64_t              eventCounts[InputLatencyTracker::INPUT_TYPE_COUNT];
+    };
+
+    static int handleRequest(mg_connection* connection, void* userData);
+
+    void writeSource(std::string& json, const Source& source) const;
+
+    std::vector<std::unique_ptr<Source>> m_sources;
+    mg_context*                          m_context;
+    int                                  m_port;
+    Clock::time_point                    m_startTime;
+    Clock::time_point                    m_eventRateTime;
+};
+
+}
+
+#endif
@@ -0,0 +1,341 @@
+#include "TextureCache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <QtCore/QDir>
+#include <QtCore/QStandardPaths>
+
+#include "Assert.hpp"
+#include "ContentHash.hpp"
+#include "Printf.hpp"
+
+namespace mojo
+{
+
+static const std::size_t kLevelAlignment = 16;
+
+static GLenum faceTarget(G3D::Texture::Dimension dimension, int face) {
+    return dimension == G3D::Texture::DIM_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+}
+
+std::string TextureCache::defaultDirectory() {
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/textures";
+    QDir().mkpath(directory);
+
+    return directory.toUtf8().constData();
+}
+
+TextureCache::TextureCache(const std::string& directory) :
+    m_directory(directory),
+    m_hits     (0),
+    m_misses   (0) {
+
+    MOJO_RELEASE_ASSERT(!directory.empty());
+}
+
+std::shared_ptr<G3D::Texture> TextureCache::create(const G3D::Texture::Specification& specification) {
+    std::string path = cachable(specification) ? entryPath(specification) : std::string();
+
+    // G3D::Texture::create(...) reports the error if the sources cannot be read
+    if (path.empty()) {
+        return G3D::Texture::create(specification);
+    }
+
+    std::shared_ptr<G3D::Texture> texture = load(path, specification);
+    if (texture) {
+        ++m_hits;
+        return texture;
+    }
+
+    ++m_misses;
+    texture = G3D::Texture::create(specification);
+    store(path, texture, specification);
+
+    return texture;
+}
+
+const std::string& TextureCache::directory() const {
+    return m_directory;
+}
+
+std::uint64_t TextureCache::hits() const {
+    return m_hits;
+}
+
+std::uint64_t TextureCache::misses() const {
+    return m_misses;
+}
+
+bool TextureCache::cachable(const G3D::Texture::Specification& specification) const {
+    return specification.dimension == G3D::Texture::DIM_2D || specification.dimension == G3D::Texture::DIM_CUBE_MAP;
+}
+
+std::string TextureCache::entryPath(const G3D::Texture::Specification& specification) const {
+
+    //
+    // The filenames may have a wildcard, e.g., for the faces of a cube map, so we hash
+    // every file it matches, in a stable order.
+    //
+    G3D::Array<G3D::String> files;
+    G3D::FileSystem::getFiles(specification.filename, files, true);
+
+    if (!specification.alphaFilename.empty()) {
+        G3D::FileSystem::getFiles(specification.alphaFilename, files, true);
+    }
+
+    if (files.empty()) {
+        return std::string();
+    }
+
+    files.sort();
+
+    std::uint64_t hash = hashString(kContentHashSeed, specification.toAny().unparse().c_str());
+
+    for (int i = 0; i < files.size(); ++i) {
+        if (!hashFile(files[i].c_str(), hash)) {
+            return std::string();
+        }
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.tex", (unsigned long long)hash);
+
+    return m_directory + "/" + name;
+}
+
+std::shared_ptr<G3D::Texture> TextureCache::load(const std::string& path, const G3D::Texture::Specification& specification) const {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return std::shared_ptr<G3D::Texture>();
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (std::size_t)status.st_size < sizeof(Header)) {
+        close(fd);
+        return std::shared_ptr<G3D::Texture>();
+    }
+
+    std::size_t size    = (std::size_t)status.st_size;
+    void*       mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return std::shared_ptr<G3D::Texture>();
+    }
+
+    // we read all of it, front to back, so the kernel may as well start now
+    madvise(mapping, size, MADV_WILLNEED);
+
+    const unsigned char*    data      = (const unsigned char*)mapping;
+    const Header&           header    = *(const Header*)mapping;
+    const G3D::ImageFormat* format    = NULL;
+    int                     faceCount = specification.dimension == G3D::Texture::DIM_CUBE_MAP ? 6 : 1;
+
+    bool valid =
+        header.magic      == kMagic &&
+        header.version    == kVersion &&
+        header.dimension  == (std::int32_t)specification.dimension &&
+        header.faceCount  == faceCount &&
+        header.levelCount >= 1 &&
+        header.levelCount <= kMaxLevels;
+
+    if (valid) {
+        format = G3D::ImageFormat::fromCode((G3D::ImageFormat::Code)header.imageFormat);
+        valid  = format != NULL && !format->compressed && format->cpuBitsPerPixel % 8 == 0;
+    }
+
+    //
+    // Every face has the size of the first, each level is half the size of the one
+    // before, down to 1, and holds exactly its pixels, as store(...) wrote them, so
+    // glTexImage2D(...) never reads past a level, or past the mapping.
+    //
+    for (int face = 0; valid && face < header.faceCount; ++face) {
+        for (int level = 0; valid && level < header.levelCount; ++level) {
+            const Level& entry = header.levels[face][level];
+            const Level& first = header.levels[0][0];
+
+            int width  = level == 0 ? first.width  : std::max(1, header.levels[face][level - 1].width  / 2);
+            int height = level == 0 ? first.height : std::max(1, header.levels[face][level - 1].height / 2);
+
+            valid =
+                entry.width  > 0 &&
+                entry.height > 0 &&
+                entry.width  == width &&
+                entry.height == height &&
+                entry.size   == (std::uint64_t)entry.width * entry.height * (format->cpuBitsPerPixel / 8) &&
+                entry.offset <= size &&
+                entry.size   <= size - entry.offset;
+        }
+    }
+
+    if (!valid) {
+        munmap(mapping, size);
+        mojo::printf("Ignoring invalid texture cache entry ", path);
+        return std::shared_ptr<G3D::Texture>();
+    }
+
+    G3D::Texture::Dimension       dimension = specification.dimension;
+    std::shared_ptr<G3D::Texture> texture   = G3D::Texture::createEmpty(
+        specification.filename,
+        header.levels[0][0].width,
+        header.levels[0][0].height,
+        format,
+        dimension,
+        header.levelCount > 1);
+
+    //
+    // G3D::RenderDevice tracks the GL state it sets, so we restore what we change. The
+    // levels are uploaded from the mapping itself, which is only read once, by the driver.
+    //
+    GLenum target  = dimension == G3D::Texture::DIM_CUBE_MAP ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    GLenum binding = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_BINDING_CUBE_MAP : GL_TEXTURE_BINDING_2D;
+
+    GLint pixelBuffer, boundTexture, alignment, rowLength;
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &pixelBuffer);
+    glGetIntegerv(binding,                        &boundTexture);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT,            &alignment);
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH,           &rowLength);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(target, texture->openGLID());
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    for (int face = 0; face < header.faceCount; ++face) {
+        for (int level = 0; level < header.levelCount; ++level) {
+            const Level& entry = header.levels[face][level];
+            glTexImage2D(faceTarget(dimension, face), level, format->openGLFormat, entry.width, entry.height, 0,
+                format->openGLBaseFormat, format->openGLDataFormat, data + entry.offset);
+        }
+    }
+
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL,  header.levelCount - 1);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  alignment);
+    glBindTexture(target, boundTexture);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+
+    munmap(mapping, size);
+    return texture;
+}
+
+void TextureCache::store(const std::string& path, const std::shared_ptr<G3D::Texture>& texture, const G3D::Texture::Specification& specification) const {
+    const G3D::ImageFormat* format = texture->format();
+    if (format->compressed || format->cpuBitsPerPixel % 8 != 0) {
+        return;
+    }
+
+    G3D::Texture::Dimension dimension = specification.dimension;
+    GLenum                  target    = dimension == G3D::Texture::DIM_CUBE_MAP ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    GLenum                  binding   = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_BINDING_CUBE_MAP : GL_TEXTURE_BINDING_2D;
+
+    GLint pixelBuffer, boundTexture, alignment, rowLength;
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pixelBuffer);
+    glGetIntegerv(binding,                      &boundTexture);
+    glGetIntegerv(GL_PACK_ALIGNMENT,            &alignment);
+    glGetIntegerv(GL_PACK_ROW_LENGTH,           &rowLength);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindTexture(target, texture->openGLID());
+    glPixelStorei(GL_PACK_ALIGNMENT,  1);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic       = kMagic;
+    header.version     = kVersion;
+    header.dimension   = (std::int32_t)dimension;
+    header.imageFormat = (std::int32_t)format->code;
+    header.faceCount   = dimension == G3D::Texture::DIM_CUBE_MAP ? 6 : 1;
+    header.levelCount  = 0;
+
+    // the levels G3D::Texture::create(...) generated go down to 1x1, where the next one has no width
+    int maxLevels = specification.generateMipMaps ? kMaxLevels : 1;
+    for (int level = 0; level < maxLevels; ++level) {
+        GLint width = 0;
+        glGetTexLevelParameteriv(faceTarget(dimension, 0), level, GL_TEXTURE_WIDTH, &width);
+
+        if (width <= 0) {
+            break;
+        }
+
+        header.levelCount = level + 1;
+    }
+
+    std::size_t size = (sizeof(Header) + kLevelAlignment - 1) / kLevelAlignment * kLevelAlignment;
+    for (int face = 0; face < header.faceCount; ++face) {
+        for (int level = 0; level < header.levelCount; ++level) {
+            GLint width, height;
+            glGetTexLevelParameteriv(faceTarget(dimension, face), level, GL_TEXTURE_WIDTH,  &width);
+            glGetTexLevelParameteriv(faceTarget(dimension, face), level, GL_TEXTURE_HEIGHT, &height);
+
+            Level& entry = header.levels[face][level];
+            entry.offset = size;
+            entry.size   = (std::uint64_t)width * height * (format->cpuBitsPerPixel / 8);
+            entry.width  = width;
+            entry.height = height;
+
+            size += (entry.size + kLevelAlignment - 1) / kLevelAlignment * kLevelAlignment;
+        }
+    }
+
+    std::vector<unsigned char> buffer(size);
+    std::memcpy(&buffer[0], &header, sizeof(header));
+
+    for (int face = 0; face < header.faceCount; ++face) {
+        for (int level = 0; level < header.levelCount; ++level) {
+            glGetTexImage(faceTarget(dimension, face), level, format->openGLBaseFormat, format->openGLDataFormat, &buffer[header.levels[face][level].offset]);
+        }
+    }
+
+    glPixelStorei(GL_PACK_ROW_LENGTH, rowLength);
+    glPixelStorei(GL_PACK_ALIGNMENT,  alignment);
+    glBindTexture(target, boundTexture);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+
+    //
+    // Several processes may miss on the same entry, e.g., with --multi-process, so each
+    // writes a file of its own and renames it into place, which replaces any other
+    // process's entry in one step.
+    //
+    std::string temporaryPath = path + "." + std::to_string(getpid()) + ".tmp";
+
+    int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+        mojo::printf("Cannot create texture cache entry ", temporaryPath, ": ", std::strerror(errno));
+        return;
+    }
+
+    std::size_t written = 0;
+    while (written < size) {
+        ssize_t result = write(fd, &buffer[written], size - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (result <= 0) {
+            break;
+        }
+
+        written += (std::size_t)result;
+    }
+
+    bool stored = close(fd) == 0 && written == size && rename(temporaryPath.c_str(), path.c_str()) == 0;
+    if (!stored) {
+        mojo::printf("Cannot write texture cache entry ", path, ": ", std::strerror(errno));
+        unlink(temporaryPath.c_str());
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef TEXTURE_CACHE_HPP
+#define TEXTURE_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <G3D/G3D.h>
+#include <GLG3D/GLG3D.h>
+
+namespace mojo
+{
+
+//
+// TextureCache keeps G3D::Textures on disk the way they end up on the GPU: decoded,
+// preprocessed, and with all of their MIP levels. Entries are named after a hash of
+// the contents of the source files and of the G3D::Texture::Specification, so editing
+// either simply misses, and the stale entry is never read again.
+//
+// On a miss, create(...) loads the texture with G3D::Texture::create(...) as usual,
+// then reads every level of every face back and writes the entry. On a hit, it maps
+// the entry and uploads the levels straight from the mapping, so a warm load costs
+// reading the file rather than decoding and preprocessing images.
+//
+// Only uncompressed 2D textures and cube maps are cached; everything else is passed
+// through to G3D::Texture::create(...). All methods that take a specification must be
+// called with the OpenGL context current.
+//
+class TextureCache
+{
+public:
+    //
+    // Returns a directory in the user's cache directory, creating it if needed.
+    //
+    static std::string defaultDirectory();
+
+    explicit TextureCache(const std::string& directory);
+
+    std::shared_ptr<G3D::Texture> create(const G3D::Texture::Specification& specification);
+
+    const std::string& directory() const;
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+private:
+    static const std::uint32_t kMagic     = 0x6d747863;
+    static const std::uint32_t kVersion   = 1;
+    static const int           kMaxFaces  = 6;
+    static const int           kMaxLevels = 16;
+
+    struct Level
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::int32_t  width;
+        std::int32_t  height;
+    };
+
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::int32_t  dimension;
+        std::int32_t  imageFormat;
+        std::int32_t  faceCount;
+        std::int32_t  levelCount;
+        Level         levels[kMaxFaces][kMaxLevels];
+    };
+
+    bool cachable(const G3D::Texture::Specification& specification) const;
+    std::string entryPath(const G3D::Texture::Specification& specification) const;
+
+    std::shared_ptr<G3D::Texture> load(const std::string& path, const G3D::Texture::Specification& specification) const;
+    void store(const std::string& path, const std::shared_ptr<G3D::Texture>& texture, const G3D::Texture::Specification& specification) const;
+
+    std::string   m_directory;
+    std::uint64_t m_hits;
+    std::uint64_t m_misses;
+};
+
+}
+
+#endif
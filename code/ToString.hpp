@@ -1,6 +1,8 @@
 #ifndef TO_STRING_HPP
 #define TO_STRING_HPP
 
+#include <cmath>
+#include <cstdio>
 #include <string>
 
 #include <boost/lexical_cast.hpp>
@@ -8,199 +10,274 @@
 namespace mojo
 {
 
-template <typename T00>
-inline std::string toString(T00 t00);
+//
+// toString(...) formats any number of arguments and concatenates the results. The
+// output is the same as concatenating boost::lexical_cast<std::string>(...) of each
+// argument, but common types are formatted directly into a single buffer instead
+// of going through a temporary std::string and an iostream per argument.
+//
+// appendToString(...) appends to a caller-supplied buffer, so callers that format
+// repeatedly, e.g., once per frame, can reuse the buffer and avoid allocating at
+// all once it has grown large enough.
+//
+// A value's operator<< may itself call toString(...), or printf(...), which must not
+// clear the per-thread buffer the outer call is formatting into, so the nested call
+// sees the depth of the calls using it and formats into a std::string of its own.
+//
+template <typename... Types>
+inline std::string toString(const Types&... values);
 
-template <typename T00, typename T01>
-inline std::string toString(T00 t00, T01 t01);
+template <typename... Types>
+inline void appendToString(std::string& buffer, const Types&... values);
 
-template <typename T00, typename T01, typename T02>
-inline std::string toString(T00 t00, T01 t01, T02 t02);
+inline std::string& toStringBuffer();
+inline int& toStringDepth();
 
-template <typename T00, typename T01, typename T02, typename T03>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03);
+class ScopedDepth
+{
+public:
+    explicit ScopedDepth(int& depth);
+    ~ScopedDepth();
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04);
+private:
+    int& m_depth;
+};
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05);
+inline void toStringHelper(std::string& buffer, const char* value);
+inline void toStringHelper(std::string& buffer, const std::string& value);
+inline void toStringHelper(std::string& buffer, char value);
+inline void toStringHelper(std::string& buffer, signed char value);
+inline void toStringHelper(std::string& buffer, unsigned char value);
+inline void toStringHelper(std::string& buffer, bool value);
+inline void toStringHelper(std::string& buffer, short value);
+inline void toStringHelper(std::string& buffer, unsigned short value);
+inline void toStringHelper(std::string& buffer, int value);
+inline void toStringHelper(std::string& buffer, unsigned int value);
+inline void toStringHelper(std::string& buffer, long value);
+inline void toStringHelper(std::string& buffer, unsigned long value);
+inline void toStringHelper(std::string& buffer, long long value);
+inline void toStringHelper(std::string& buffer, unsigned long long value);
+inline void toStringHelper(std::string& buffer, float value);
+inline void toStringHelper(std::string& buffer, double value);
+inline void toStringHelper(std::string& buffer, long double value);
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06);
+template <typename T>
+inline void toStringHelper(std::string& buffer, const T& value);
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07);
+template <typename T>
+inline void toStringIntegerHelper(std::string& buffer, T value);
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07, typename T08>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07, T08 t08);
+template <typename T>
+inline void toStringFloatingPointHelper(std::string& buffer, T value, const char* format, int precision);
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07, typename T08, typename T09>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07, T08 t08, T09 t09);
+template <typename... Types>
+inline std::string toString(const Types&... values)
+{
+    int& depth = toStringDepth();
+    if (depth > 0) {
+        std::string buffer;
+        appendToString(buffer, values...);
+        return buffer;
+    }
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07, typename T08, typename T09, typename T10>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07, T08 t08, T09 t09, T10 t10);
+    ScopedDepth  scopedDepth(depth);
+    std::string& buffer = toStringBuffer();
+    buffer.clear();
+    appendToString(buffer, values...);
+    return buffer;
+}
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07, typename T08, typename T09, typename T10, typename T11>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07, T08 t08, T09 t09, T10 t10, T11 t11);
+template <typename... Types>
+inline void appendToString(std::string& buffer, const Types&... values)
+{
+    int expand[] = { 0, (toStringHelper(buffer, values), 0)... };
+    (void)expand;
+}
 
-template <typename T>
-inline std::string toStringHelper(T t);
+inline std::string& toStringBuffer()
+{
+    static thread_local std::string buffer;
+    return buffer;
+}
+
+inline int& toStringDepth()
+{
+    static thread_local int depth = 0;
+    return depth;
+}
+
+inline ScopedDepth::ScopedDepth(int& depth) :
+    m_depth(depth)
+{
+    ++m_depth;
+}
+
+inline ScopedDepth::~ScopedDepth()
+{
+    --m_depth;
+}
+
+inline void toStringHelper(std::string& buffer, const char* value)
+{
+    buffer.append(value);
+}
+
+inline void toStringHelper(std::string& buffer, const std::string& value)
+{
+    buffer.append(value);
+}
+
+inline void toStringHelper(std::string& buffer, char value)
+{
+    buffer.push_back(value);
+}
+
+inline void toStringHelper(std::string& buffer, signed char value)
+{
+    buffer.push_back((char)value);
+}
+
+inline void toStringHelper(std::string& buffer, unsigned char value)
+{
+    buffer.push_back((char)value);
+}
+
+inline void toStringHelper(std::string& buffer, bool value)
+{
+    buffer.push_back(value ? '1' : '0');
+}
+
+inline void toStringHelper(std::string& buffer, short value)
+{
+    toStringIntegerHelper(buffer, value);
+}
+
+inline void toStringHelper(std::string& buffer, unsigned short value)
+{
+    toStringIntegerHelper(buffer, value);
+}
+
+inline void toStringHelper(std::string& buffer, int value)
+{
+    toStringIntegerHelper(buffer, value);
+}
+
+inline void toStringHelper(std::string& buffer, unsigned int value)
+{
+    toStringIntegerHelper(buffer, value);
+}
+
+inline void toStringHelper(std::string& buffer, long value)
+{
+    toStringIntegerHelper(buffer, value);
+}
+
+inline void toStringHelper(std::string& buffer, unsigned long value)
+{
+    toStringIntegerHelper(buffer, value);
+}
+
+inline void toStringHelper(std::string& buffer, long long value)
+{
+    toStringIntegerHelper(buffer, value);
+}
 
-template <typename T00>
-inline std::string toString(T00 t00)
+inline void toStringHelper(std::string& buffer, unsigned long long value)
 {
-    return std::string(
-        toStringHelper(t00));
+    toStringIntegerHelper(buffer, value);
 }
 
-template <typename T00, typename T01>
-inline std::string toString(T00 t00, T01 t01)
+//
+// boost::lexical_cast formats floating point values with "%.*g" and enough digits
+// to round trip, i.e., 9 for float, 17 for double and 21 for long double, and spells
+// out infinities and NaNs itself. We do the same without the iostream.
+//
+inline void toStringHelper(std::string& buffer, float value)
 {
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01));
+    toStringFloatingPointHelper(buffer, (double)value, "%.*g", 9);
 }
 
-template <typename T00, typename T01, typename T02>
-inline std::string toString(T00 t00, T01 t01, T02 t02)
+inline void toStringHelper(std::string& buffer, double value)
 {
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02));
+    toStringFloatingPointHelper(buffer, value, "%.*g", 17);
 }
 
-template < typename T00, typename T01, typename T02, typename T03 >
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03)
+inline void toStringHelper(std::string& buffer, long double value)
+{
+    toStringFloatingPointHelper(buffer, value, "%.*Lg", 21);
+}
+
+//
+// Everything else, e.g., pointers and types with an operator<<, goes through
+// boost::lexical_cast as before.
+//
+template <typename T>
+inline void toStringHelper(std::string& buffer, const T& value)
 {
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03));
+    buffer.append(boost::lexical_cast<std::string>(value));
 }
 
-template <typename T00, typename T01, typename T02, typename T03, typename T04>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04)
+template <typename T>
+inline void toStringIntegerHelper(std::string& buffer, T value)
 {
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03) +
-        toStringHelper(t04));
-}
-
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05)
-{
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03) +
-        toStringHelper(t04) +
-        toStringHelper(t05));
-}
-
-template < typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06)
-{
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03) +
-        toStringHelper(t04) +
-        toStringHelper(t05) +
-        toStringHelper(t06));
-}
-
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07)
-{
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03) +
-        toStringHelper(t04) +
-        toStringHelper(t05) +
-        toStringHelper(t06) +
-        toStringHelper(t07));
-}
-
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07, typename T08>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07, T08 t08)
-{
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03) +
-        toStringHelper(t04) +
-        toStringHelper(t05) +
-        toStringHelper(t06) +
-        toStringHelper(t07) +
-        toStringHelper(t08));
-}
-
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07, typename T08, typename T09>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07, T08 t08, T09 t09)
-{
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03) +
-        toStringHelper(t04) +
-        toStringHelper(t05) +
-        toStringHelper(t06) +
-        toStringHelper(t07) +
-        toStringHelper(t08) +
-        toStringHelper(t09));
-}
-
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07, typename T08, typename T09, typename T10>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07, T08 t08, T09 t09, T10 t10)
-{
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03) +
-        toStringHelper(t04) +
-        toStringHelper(t05) +
-        toStringHelper(t06) +
-        toStringHelper(t07) +
-        toStringHelper(t08) +
-        toStringHelper(t09) +
-        toStringHelper(t10));
-}
-
-template <typename T00, typename T01, typename T02, typename T03, typename T04, typename T05, typename T06, typename T07, typename T08, typename T09, typename T10, typename T11>
-inline std::string toString(T00 t00, T01 t01, T02 t02, T03 t03, T04 t04, T05 t05, T06 t06, T07 t07, T08 t08, T09 t09, T10 t10, T11 t11)
-{
-    return std::string(
-        toStringHelper(t00) +
-        toStringHelper(t01) +
-        toStringHelper(t02) +
-        toStringHelper(t03) +
-        toStringHelper(t04) +
-        toStringHelper(t05) +
-        toStringHelper(t06) +
-        toStringHelper(t07) +
-        toStringHelper(t08) +
-        toStringHelper(t09) +
-        toStringHelper(t10) +
-        toStringHelper(t11));
+    static const char digitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    // Enough for the digits and sign of a 64-bit integer
+    char  digits[24];
+    char* end   = digits + sizeof(digits);
+    char* begin = end;
+
+    bool               negative  = value < 0;
+    unsigned long long magnitude = negative ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+
+    while (magnitude >= 100) {
+        unsigned int pair = (unsigned int)(magnitude % 100) * 2;
+        magnitude /= 100;
+        *--begin = digitPairs[pair + 1];
+        *--begin = digitPairs[pair];
+    }
+
+    if (magnitude >= 10) {
+        unsigned int pair = (unsigned int)magnitude * 2;
+        *--begin = digitPairs[pair + 1];
+        *--begin = digitPairs[pair];
+    } else {
+        *--begin = (char)('0' + magnitude);
+    }
+
+    if (negative) {
+        *--begin = '-';
+    }
+
+    buffer.append(begin, end);
 }
 
 template <typename T>
-inline std::string toStringHelper(T t)
+inline void toStringFloatingPointHelper(std::string& buffer, T value, const char* format, int precision)
 {
-    return boost::lexical_cast<std::string>(t);
+    if (std::isnan(value)) {
+        buffer.append(std::signbit(value) ? "-nan" : "nan");
+        return;
+    }
+
+    if (std::isinf(value)) {
+        buffer.append(std::signbit(value) ? "-inf" : "inf");
+        return;
+    }
+
+    char digits[64];
+    int  length = std::snprintf(digits, sizeof(digits), format, precision, value);
+    buffer.append(digits, length);
 }
 
 }
@@ -0,0 +1,123 @@
+#include "TrainingWorkload.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QtCore/QCoreApplication>
+#include <QtGui/QKeyEvent>
+#include <QtGui/QMouseEvent>
+#include <QtWidgets/QWidget>
+
+#include "Assert.hpp"
+
+namespace mojo
+{
+
+namespace
+{
+
+const int kMouseMovesPerFrame = 8;
+
+struct ScriptedKey
+{
+    int                   key;
+    Qt::KeyboardModifiers modifiers;
+    const char*           text;
+};
+
+//
+// Camera movement keys, with and without modifiers, and a few keys G3D binds to
+// developer tools. We stay away from keys that would quit or open dialogs.
+//
+const ScriptedKey kScriptedKeys[] = {
+    { Qt::Key_W,     Qt::NoModifier,    "w" },
+    { Qt::Key_A,     Qt::NoModifier,    "a" },
+    { Qt::Key_S,     Qt::NoModifier,    "s" },
+    { Qt::Key_D,     Qt::NoModifier,    "d" },
+    { Qt::Key_Q,     Qt::NoModifier,    "q" },
+    { Qt::Key_E,     Qt::NoModifier,    "e" },
+    { Qt::Key_W,     Qt::ShiftModifier, "W" },
+    { Qt::Key_Up,    Qt::NoModifier,    ""  },
+    { Qt::Key_Left,  Qt::NoModifier,    ""  },
+    { Qt::Key_Shift, Qt::ShiftModifier, ""  },
+};
+
+const int kNumScriptedKeys = sizeof(kScriptedKeys) / sizeof(kScriptedKeys[0]);
+
+}
+
+TrainingWorkload::TrainingWorkload(int numFrames) :
+    m_numFrames(numFrames),
+    m_frame    (0) {
+
+    MOJO_RELEASE_ASSERT(numFrames > 0);
+}
+
+void TrainingWorkload::sendFrameInput(QWidget* widget) {
+    MOJO_RELEASE_ASSERT(widget != NULL);
+
+    if (m_frame == 0) {
+        m_begin = Clock::now();
+    }
+
+    QPoint center(widget->width() / 2, widget->height() / 2);
+    int    radius = std::min(widget->width(), widget->height()) / 4;
+
+    // drag the mouse along a circle, holding the right button for half of the time
+    Qt::MouseButtons buttons = (m_frame / 120) % 2 ? Qt::MouseButtons(Qt::RightButton) : Qt::MouseButtons(Qt::NoButton);
+    for (int i = 0; i < kMouseMovesPerFrame; ++i) {
+        double angle = (m_frame * kMouseMovesPerFrame + i) * 0.01;
+        m_mousePosition = center + QPoint((int)(radius * std::cos(angle)), (int)(radius * std::sin(angle)));
+
+        QMouseEvent mouseMove(QEvent::MouseMove, m_mousePosition, Qt::NoButton, buttons, Qt::NoModifier);
+        QCoreApplication::sendEvent(widget, &mouseMove);
+    }
+
+    if (m_frame % 30 == 0) {
+        QMouseEvent mousePress(QEvent::MouseButtonPress, m_mousePosition, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+        QCoreApplication::sendEvent(widget, &mousePress);
+
+        QMouseEvent mouseRelease(QEvent::MouseButtonRelease, m_mousePosition, Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+        QCoreApplication::sendEvent(widget, &mouseRelease);
+    }
+
+    // hold each key for a few frames, auto repeating, then release it
+    const ScriptedKey& key = kScriptedKeys[(m_frame / 10) % kNumScriptedKeys];
+    switch (m_frame % 10) {
+    case 0: {
+        QKeyEvent keyPress(QEvent::KeyPress, key.key, key.modifiers, key.text, false);
+        QCoreApplication::sendEvent(widget, &keyPress);
+        break;
+    }
+    case 9: {
+        QKeyEvent keyRelease(QEvent::KeyRelease, key.key, key.modifiers, key.text, false);
+        QCoreApplication::sendEvent(widget, &keyRelease);
+        break;
+    }
+    default: {
+        QKeyEvent keyRepeat(QEvent::KeyPress, key.key, key.modifiers, key.text, true);
+        QCoreApplication::sendEvent(widget, &keyRepeat);
+        break;
+    }
+    }
+
+    ++m_frame;
+}
+
+bool TrainingWorkload::finished() const {
+    return m_frame >= m_numFrames;
+}
+
+int TrainingWorkload::numFrames() const {
+    return m_numFrames;
+}
+
+double TrainingWorkload::elapsedMilliseconds() const {
+    if (m_frame == 0) {
+        return 0.0;
+    }
+
+    return std::chrono::duration<double, std::milli>(Clock::now() - m_begin).count();
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef TRAINING_WORKLOAD_HPP
+#define TRAINING_WORKLOAD_HPP
+
+#include <chrono>
+
+#include <QtCore/QPoint>
+
+class QWidget;
+
+namespace mojo
+{
+
+//
+// A scripted, deterministic stream of mouse and keyboard input that runs for a fixed
+// number of frames. The input is sent through QCoreApplication::sendEvent(...), so it
+// takes the same path as real input: Qt's event dispatch, G3DWidget's event
+// translation and the GLG3D::GApp event handlers. G3DWidgetDemo runs it with
+// --training-workload N to record a profile for profile-guided optimization, and
+// to time builds against each other.
+//
+class TrainingWorkload
+{
+public:
+    TrainingWorkload(int numFrames);
+
+    //
+    // Sends one frame's worth of input to widget and advances to the next frame.
+    //
+    void sendFrameInput(QWidget* widget);
+
+    bool   finished() const;
+    int    numFrames() const;
+    double elapsedMilliseconds() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    int               m_numFrames;
+    int               m_frame;
+    QPoint            m_mousePosition;
+    Clock::time_point m_begin;
+};
+
+}
+
+#endif
@@ -0,0 +1,572 @@
+#include "VideoTextureSource.hpp"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+#include <algorithm>
+
+#include "Assert.hpp"
+#include "Printf.hpp"
+
+namespace mojo
+{
+
+// slices start on a multiple of this many rows, so the chroma planes split evenly too
+static const int kConversionSliceAlignment = 16;
+static const int kMinConversionSliceHeight = 256;
+
+std::shared_ptr<VideoTextureSource> VideoTextureSource::create(const std::string& filename, bool loop) {
+    static std::once_flag registered;
+    std::call_once(registered, []() { av_register_all(); });
+
+    std::shared_ptr<VideoTextureSource> videoTextureSource(new VideoTextureSource(filename, loop));
+    if (!videoTextureSource->open()) {
+        return std::shared_ptr<VideoTextureSource>();
+    }
+
+    videoTextureSource->start();
+    return videoTextureSource;
+}
+
+VideoTextureSource::VideoTextureSource(const std::string& filename, bool loop) :
+    m_filename         (filename),
+    m_loop             (loop),
+    m_formatContext    (NULL),
+    m_codecContext     (NULL),
+    m_chromaShift      (0),
+    m_streamIndex      (-1),
+    m_width            (0),
+    m_height           (0),
+    m_frameDuration    (0.0),
+    m_firstFrameDecoded(false),
+    m_firstFrameTime   (0.0),
+    m_lastFrameTime    (0.0),
+    m_loopOffset       (0.0),
+    m_initialized      (false),
+    m_started          (false),
+    m_startTime        (0.0),
+    m_presentedFrames  (0),
+    m_droppedFrames    (0),
+    m_videoTime        (-1.0),
+    m_stopping         (false),
+    m_sliceStopping    (false),
+    m_sliceGeneration  (0),
+    m_pendingSlices    (0),
+    m_sliceFrame       (NULL),
+    m_slicePixels      (NULL) {
+
+    for (int i = 0; i < kUploadSlotCount; ++i) {
+        m_uploadSlots[i].pixelBuffer = 0;
+        m_uploadSlots[i].pixels      = NULL;
+    }
+}
+
+VideoTextureSource::~VideoTextureSource() {
+    stop();
+
+    for (const DecodedFrame& decodedFrame : m_decodedFrames) {
+        AVFrame* frame = decodedFrame.frame;
+        av_frame_free(&frame);
+    }
+
+    for (const ConversionSlice& slice : m_conversionSlices) {
+        sws_freeContext(slice.swsContext);
+    }
+
+    if (m_codecContext != NULL) {
+        avcodec_close(m_codecContext);
+    }
+
+    if (m_formatContext != NULL) {
+        avformat_close_input(&m_formatContext);
+    }
+}
+
+bool VideoTextureSource::open() {
+    if (avformat_open_input(&m_formatContext, m_filename.c_str(), NULL, NULL) != 0) {
+        mojo::printf("Cannot open video ", m_filename);
+        return false;
+    }
+
+    if (avformat_find_stream_info(m_formatContext, NULL) < 0) {
+        mojo::printf("Cannot find the streams of video ", m_filename);
+        return false;
+    }
+
+    AVCodec* codec = NULL;
+    m_streamIndex  = av_find_best_stream(m_formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (m_streamIndex < 0 || codec == NULL) {
+        mojo::printf("Cannot find a video stream we can decode in ", m_filename);
+        return false;
+    }
+
+    AVStream* stream = m_formatContext->streams[m_streamIndex];
+    m_codecContext   = stream->codec;
+
+    //
+    // With "auto", libavcodec decodes with a thread per core. We keep references to the
+    // decoded frames in our queue, so they need to be reference counted.
+    //
+    AVDictionary* options = NULL;
+    av_dict_set(&options, "threads",           "auto", 0);
+    av_dict_set(&options, "refcounted_frames", "1",    0);
+
+    int error = avcodec_open2(m_codecContext, codec, &options);
+    av_dict_free(&options);
+
+    if (error < 0) {
+        m_codecContext = NULL;
+        mojo::printf("Cannot open the decoder of video ", m_filename);
+        return false;
+    }
+
+    m_width  = m_codecContext->width;
+    m_height = m_codecContext->height;
+
+    //
+    // The size doesn't change, so there's no scaling, only the conversion to RGBA8, and
+    // every row of the output only depends on its own rows of the input. Each slice gets
+    // a context the size of the slice. Palettes aren't rows, so those formats get one.
+    //
+    const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(m_codecContext->pix_fmt);
+    if (descriptor == NULL) {
+        mojo::printf("Cannot convert the pixel format of video ", m_filename);
+        return false;
+    }
+
+    m_chromaShift = descriptor->log2_chroma_h;
+
+    int sliceCount = 1;
+    if ((descriptor->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_PSEUDOPAL)) == 0) {
+        int threadCount = std::max(1, std::min((int)std::thread::hardware_concurrency(), kMaxConversionThreads));
+        sliceCount      = std::max(1, std::min(threadCount, m_height / kMinConversionSliceHeight));
+    }
+
+    int sliceHeight = (m_height + sliceCount - 1) / sliceCount;
+    sliceHeight     = (sliceHeight + kConversionSliceAlignment - 1) / kConversionSliceAlignment * kConversionSliceAlignment;
+
+    for (int y = 0; y < m_height; y += sliceHeight) {
+        ConversionSlice slice;
+        slice.y          = y;
+        slice.height     = std::min(sliceHeight, m_height - y);
+        slice.swsContext = sws_getContext(
+            m_width, slice.height, m_codecContext->pix_fmt,
+            m_width, slice.height, AV_PIX_FMT_RGBA,
+            SWS_POINT, NULL, NULL, NULL);
+
+        if (slice.swsContext == NULL) {
+            mojo::printf("Cannot convert the pixel format of video ", m_filename);
+            return false;
+        }
+
+        m_conversionSlices.push_back(slice);
+    }
+
+    AVRational frameRate = av_guess_frame_rate(m_formatContext, stream, NULL);
+    m_frameDuration      = frameRate.num > 0 ? av_q2d(av_inv_q(frameRate)) : 1.0 / 30.0;
+
+    //
+    // The texture and the pixel buffer objects are created on the render thread, and
+    // every slot starts out mapped and writable.
+    //
+    m_texture = G3D::Texture::createEmpty("mojo::VideoTextureSource", m_width, m_height, G3D::ImageFormat::RGBA8(), G3D::Texture::DIM_2D, false);
+
+    GLint pixelBuffer;
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &pixelBuffer);
+
+    for (int i = 0; i < kUploadSlotCount; ++i) {
+        glGenBuffers(1, &m_uploadSlots[i].pixelBuffer);
+        m_uploadSlots[i].pixels = mapPixelBuffer(i);
+        m_writableSlots.push_back(i);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+
+    m_initialized = true;
+    return true;
+}
+
+void VideoTextureSource::start() {
+    m_decodeThread  = std::thread(&VideoTextureSource::decode, this);
+    m_convertThread = std::thread(&VideoTextureSource::convert, this);
+
+    // the conversion thread converts the first slice itself
+    for (int i = 1; i < (int)m_conversionSlices.size(); ++i) {
+        m_sliceThreads.push_back(std::thread(&VideoTextureSource::convertSliceLoop, this, i));
+    }
+}
+
+void VideoTextureSource::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    if (m_decodeThread.joinable()) {
+        m_decodeThread.join();
+    }
+
+    if (m_convertThread.joinable()) {
+        m_convertThread.join();
+    }
+
+    // only the conversion thread hands the slice threads frames, so they are idle now
+    {
+        std::lock_guard<std::mutex> lock(m_sliceMutex);
+        m_sliceStopping = true;
+    }
+    m_sliceCondition.notify_all();
+
+    for (std::thread& thread : m_sliceThreads) {
+        thread.join();
+    }
+    m_sliceThreads.clear();
+}
+
+void VideoTextureSource::cleanup() {
+
+    // the conversion thread writes to the mapped pixel buffers, so it has to stop first
+    stop();
+
+    if (m_initialized) {
+        GLint pixelBuffer;
+        glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &pixelBuffer);
+
+        for (int i = 0; i < kUploadSlotCount; ++i) {
+            if (m_uploadSlots[i].pixels != NULL) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadSlots[i].pixelBuffer);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                m_uploadSlots[i].pixels = NULL;
+            }
+
+            glDeleteBuffers(1, &m_uploadSlots[i].pixelBuffer);
+            m_uploadSlots[i].pixelBuffer = 0;
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    }
+
+    m_texture.reset();
+    m_initialized = false;
+}
+
+void VideoTextureSource::update(double time) {
+    if (!m_initialized) {
+        return;
+    }
+
+    if (!m_started) {
+        m_startTime = time;
+        m_started   = true;
+    }
+
+    double videoTime = time - m_startTime;
+    m_videoTime.store(videoTime, std::memory_order_relaxed);
+
+    //
+    // Take the latest frame that is due. Earlier frames that are due were never shown,
+    // so their slots go straight back to the conversion thread, still mapped.
+    //
+    int slot = -1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        while (!m_convertedFrames.empty() && m_convertedFrames.front().time <= videoTime) {
+            if (slot >= 0) {
+                m_writableSlots.push_back(slot);
+                ++m_droppedFrames;
+            }
+
+            slot = m_convertedFrames.front().slot;
+            m_convertedFrames.pop_front();
+        }
+    }
+
+    if (slot < 0) {
+        return;
+    }
+
+    upload(slot);
+    ++m_presentedFrames;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_writableSlots.push_back(slot);
+    }
+    m_condition.notify_all();
+}
+
+const std::shared_ptr<G3D::Texture>& VideoTextureSource::texture() const {
+    return m_texture;
+}
+
+int VideoTextureSource::width() const {
+    return m_width;
+}
+
+int VideoTextureSource::height() const {
+    return m_height;
+}
+
+const std::string& VideoTextureSource::filename() const {
+    return m_filename;
+}
+
+std::uint64_t VideoTextureSource::presentedFrames() const {
+    return m_presentedFrames;
+}
+
+std::uint64_t VideoTextureSource::droppedFrames() const {
+    return m_droppedFrames;
+}
+
+void VideoTextureSource::decode() {
+    AVFrame* frame = av_frame_alloc();
+    MOJO_RELEASE_ASSERT(frame != NULL);
+
+    AVPacket packet;
+    av_init_packet(&packet);
+
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                break;
+            }
+        }
+
+        if (av_read_frame(m_formatContext, &packet) < 0) {
+
+            // decoders with frame threads or B-frames hold back frames until drained
+            packet.data = NULL;
+            packet.size = 0;
+            while (decodePacket(&packet, frame)) {
+            }
+
+            if (!m_loop) {
+                break;
+            }
+
+            //
+            // Frame times keep increasing across loops, so presentation, which only moves
+            // forward, carries on into the next loop.
+            //
+            AVStream*    stream    = m_formatContext->streams[m_streamIndex];
+            std::int64_t startTime = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+
+            av_seek_frame(m_formatContext, m_streamIndex, startTime, AVSEEK_FLAG_BACKWARD);
+            avcodec_flush_buffers(m_codecContext);
+
+            m_loopOffset        += m_lastFrameTime + m_frameDuration;
+            m_firstFrameDecoded  = false;
+            continue;
+        }
+
+        if (packet.stream_index == m_streamIndex) {
+            decodePacket(&packet, frame);
+        }
+
+        av_free_packet(&packet);
+    }
+
+    av_frame_free(&frame);
+}
+
+bool VideoTextureSource::decodePacket(AVPacket* packet, AVFrame* frame) {
+    int gotFrame = 0;
+    if (avcodec_decode_video2(m_codecContext, frame, &gotFrame, packet) < 0 || !gotFrame) {
+        return false;
+    }
+
+    double time = av_frame_get_best_effort_timestamp(frame) * av_q2d(m_formatContext->streams[m_streamIndex]->time_base);
+    if (!m_firstFrameDecoded) {
+        m_firstFrameTime    = time;
+        m_firstFrameDecoded = true;
+    }
+
+    m_lastFrameTime = time - m_firstFrameTime;
+
+    DecodedFrame decodedFrame;
+    decodedFrame.frame = av_frame_clone(frame);
+    decodedFrame.time  = m_loopOffset + m_lastFrameTime;
+    av_frame_unref(frame);
+
+    if (decodedFrame.frame == NULL) {
+        return false;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_stopping || (int)m_decodedFrames.size() < kDecodedFrameQueueSize; });
+
+        if (m_stopping) {
+            av_frame_free(&decodedFrame.frame);
+            return false;
+        }
+
+        m_decodedFrames.push_back(decodedFrame);
+    }
+    m_condition.notify_all();
+
+    return true;
+}
+
+void VideoTextureSource::convert() {
+    for (;;) {
+        DecodedFrame decodedFrame;
+        int          slot;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || (!m_decodedFrames.empty() && !m_writableSlots.empty()); });
+
+            if (m_stopping) {
+                return;
+            }
+
+            // a frame whose successor is due already would be dropped by update(...) anyway
+            double videoTime = m_videoTime.load(std::memory_order_relaxed);
+            while (m_decodedFrames.size() > 1 && m_decodedFrames[1].time <= videoTime) {
+                av_frame_free(&m_decodedFrames.front().frame);
+                m_decodedFrames.pop_front();
+                ++m_droppedFrames;
+            }
+
+            decodedFrame = m_decodedFrames.front();
+            slot         = m_writableSlots.front();
+            m_decodedFrames.pop_front();
+            m_writableSlots.pop_front();
+        }
+        m_condition.notify_all();
+
+        // the slot's buffer stays mapped until the render thread takes it back
+        unsigned char* pixels = m_uploadSlots[slot].pixels;
+
+        {
+            std::lock_guard<std::mutex> lock(m_sliceMutex);
+            m_sliceFrame    = decodedFrame.frame;
+            m_slicePixels   = pixels;
+            m_pendingSlices = (int)m_conversionSlices.size() - 1;
+            ++m_sliceGeneration;
+        }
+        m_sliceCondition.notify_all();
+
+        convertSlice(m_conversionSlices[0], decodedFrame.frame, pixels);
+
+        {
+            std::unique_lock<std::mutex> lock(m_sliceMutex);
+            m_sliceCondition.wait(lock, [this]() { return m_pendingSlices == 0; });
+            m_sliceFrame  = NULL;
+            m_slicePixels = NULL;
+        }
+
+        av_frame_free(&decodedFrame.frame);
+
+        ConvertedFrame convertedFrame;
+        convertedFrame.slot = slot;
+        convertedFrame.time = decodedFrame.time;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_convertedFrames.push_back(convertedFrame);
+        }
+    }
+}
+
+void VideoTextureSource::convertSliceLoop(int index) {
+    std::uint64_t generation = 0;
+
+    for (;;) {
+        const AVFrame* frame;
+        unsigned char* pixels;
+        {
+            std::unique_lock<std::mutex> lock(m_sliceMutex);
+            m_sliceCondition.wait(lock, [this, generation]() { return m_sliceStopping || m_sliceGeneration != generation; });
+
+            if (m_sliceStopping) {
+                return;
+            }
+
+            generation = m_sliceGeneration;
+            frame      = m_sliceFrame;
+            pixels     = m_slicePixels;
+        }
+
+        convertSlice(m_conversionSlices[index], frame, pixels);
+
+        {
+            std::lock_guard<std::mutex> lock(m_sliceMutex);
+            --m_pendingSlices;
+        }
+        m_sliceCondition.notify_all();
+    }
+}
+
+void VideoTextureSource::convertSlice(const ConversionSlice& slice, const AVFrame* frame, unsigned char* pixels) {
+
+    //
+    // Planes 1 and 2 are the chroma planes, which have fewer rows in subsampled formats,
+    // e.g., half as many in 4:2:0. Planes 0 and 3, luma and alpha, have all the rows.
+    //
+    const uint8_t* source[4];
+    for (int plane = 0; plane < 4; ++plane) {
+        int shift     = (plane == 1 || plane == 2) ? m_chromaShift : 0;
+        source[plane] = frame->data[plane] != NULL ? frame->data[plane] + (slice.y >> shift) * frame->linesize[plane] : NULL;
+    }
+
+    uint8_t* destination[4] = { pixels + (std::size_t)slice.y * m_width * 4, NULL, NULL, NULL };
+    int      strides[4]     = { m_width * 4, 0, 0, 0 };
+
+    sws_scale(slice.swsContext, source, frame->linesize, 0, slice.height, destination, strides);
+}
+
+void VideoTextureSource::upload(int slot) {
+
+    //
+    // G3D::RenderDevice tracks the GL state it sets, so we restore what we change. The
+    // copy from the pixel buffer object into the texture happens on the GPU.
+    //
+    GLint pixelBuffer, texture, alignment, rowLength;
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &pixelBuffer);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D,          &texture);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT,            &alignment);
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH,           &rowLength);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadSlots[slot].pixelBuffer);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    m_uploadSlots[slot].pixels = NULL;
+
+    glBindTexture(GL_TEXTURE_2D, m_texture->openGLID());
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+    m_uploadSlots[slot].pixels = mapPixelBuffer(slot);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+    glPixelStorei(GL_UNPACK_ALIGNMENT,  alignment);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+}
+
+unsigned char* VideoTextureSource::mapPixelBuffer(int slot) {
+    GLsizeiptr size = (GLsizeiptr)m_width * m_height * 4;
+
+    //
+    // Respecifying the storage orphans the old one, which the GPU may still be reading
+    // from for the last upload, so mapping the new storage never waits.
+    //
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadSlots[slot].pixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+    unsigned char* pixels = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    MOJO_RELEASE_ASSERT(pixels != NULL);
+
+    return pixels;
+}
+
+}
@@ -0,0 +1,181 @@
+#ifndef VIDEO_TEXTURE_SOURCE_HPP
+#define VIDEO_TEXTURE_SOURCE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <G3D/G3D.h>
+#include <GLG3D/GLG3D.h>
+
+struct AVCodecContext;
+struct AVFormatContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+namespace mojo
+{
+
+//
+// VideoTextureSource plays a video file into a G3D::Texture, e.g., to map it onto a
+// surface of a GLG3D::GApp's scene. Frames go through a pipeline of two worker
+// threads, so the render thread never decodes, converts or waits:
+//
+//   decoding   demuxes and decodes the file with libavformat and libavcodec, which
+//              uses frame threads of its own, into a queue of kDecodedFrameQueueSize
+//              frames
+//
+//   conversion converts the decoded frames to RGBA8 with libswscale, straight into
+//              one of kUploadSlotCount pixel buffer objects, which the render thread
+//              keeps mapped for it
+//
+// A 4K frame takes too long to convert on one core, so the conversion thread splits
+// each frame into horizontal slices, each with a libswscale context of its own, and
+// converts them on up to kMaxConversionThreads threads, itself included.
+//
+// Each call to update(...) presents the latest converted frame that is due, and drops
+// the ones before it. The conversion thread drops decoded frames that are already
+// late, i.e., that a later decoded frame is due at the last update(...), without
+// converting them, so a conversion thread that falls behind catches up rather than
+// spending its time on frames that would never be shown. Presenting a frame unmaps its pixel buffer object and copies it
+// into the texture on the GPU, then orphans the buffer's storage and maps it again for
+// the conversion thread, so the GPU reads the old storage while the CPU writes the new
+// one, and neither waits on the other. Both queues are bounded, so the worker threads
+// block when they get ahead of presentation, rather than decoding the whole file.
+//
+// All methods must be called with the OpenGL context current, on the render thread.
+//
+class VideoTextureSource
+{
+public:
+    static const int kDecodedFrameQueueSize = 4;
+    static const int kUploadSlotCount       = 3;
+    static const int kMaxConversionThreads  = 4;
+
+    //
+    // Returns an empty pointer, and logs why, if the file has no video stream we can
+    // decode. A looping source starts over at the end of the file.
+    //
+    static std::shared_ptr<VideoTextureSource> create(const std::string& filename, bool loop = true);
+
+    ~VideoTextureSource();
+
+    void cleanup();
+
+    //
+    // Presents the frame that is due at time, in seconds, e.g., the simulation time.
+    // The first call starts playback at its time.
+    //
+    void update(double time);
+
+    const std::shared_ptr<G3D::Texture>& texture() const;
+
+    int width() const;
+    int height() const;
+    const std::string& filename() const;
+
+    std::uint64_t presentedFrames() const;
+    std::uint64_t droppedFrames() const;
+
+private:
+    struct DecodedFrame
+    {
+        AVFrame* frame;
+        double   time;
+    };
+
+    struct ConvertedFrame
+    {
+        int      slot;
+        double   time;
+    };
+
+    struct UploadSlot
+    {
+        unsigned int   pixelBuffer;
+        unsigned char* pixels;
+    };
+
+    // rows y to y + height - 1 of every frame
+    struct ConversionSlice
+    {
+        SwsContext*    swsContext;
+        int            y;
+        int            height;
+    };
+
+    VideoTextureSource(const std::string& filename, bool loop);
+
+    bool open();
+    void start();
+    void stop();
+
+    void decode();
+    bool decodePacket(AVPacket* packet, AVFrame* frame);
+    void convert();
+    void convertSliceLoop(int index);
+    void convertSlice(const ConversionSlice& slice, const AVFrame* frame, unsigned char* pixels);
+
+    void upload(int slot);
+    unsigned char* mapPixelBuffer(int slot);
+
+    std::string                   m_filename;
+    bool                          m_loop;
+
+    AVFormatContext*              m_formatContext;
+    AVCodecContext*               m_codecContext;
+    std::vector<ConversionSlice>  m_conversionSlices;
+    int                           m_chromaShift;
+    int                           m_streamIndex;
+    int                           m_width;
+    int                           m_height;
+    double                        m_frameDuration;
+
+    // only touched by the decoding thread
+    bool                          m_firstFrameDecoded;
+    double                        m_firstFrameTime;
+    double                        m_lastFrameTime;
+    double                        m_loopOffset;
+
+    UploadSlot                    m_uploadSlots[kUploadSlotCount];
+    std::shared_ptr<G3D::Texture> m_texture;
+    bool                          m_initialized;
+    bool                          m_started;
+    double                        m_startTime;
+    std::uint64_t                 m_presentedFrames;
+    std::atomic<std::uint64_t>    m_droppedFrames;
+
+    // the video time of the last update(...), for the conversion thread to skip late frames
+    std::atomic<double>           m_videoTime;
+
+    std::thread                   m_decodeThread;
+    std::thread                   m_convertThread;
+    std::vector<std::thread>      m_sliceThreads;
+
+    std::mutex                    m_mutex;
+    std::condition_variable       m_condition;
+    bool                          m_stopping;
+    std::deque<DecodedFrame>      m_decodedFrames;
+    std::deque<int>               m_writableSlots;
+    std::deque<ConvertedFrame>    m_convertedFrames;
+
+    // the frame the slice threads convert, handed over by the conversion thread
+    std::mutex                    m_sliceMutex;
+    std::condition_variable       m_sliceCondition;
+    bool                          m_sliceStopping;
+    std::uint64_t                 m_sliceGeneration;
+    int                           m_pendingSlices;
+    const AVFrame*                m_sliceFrame;
+    unsigned char*                m_slicePixels;
+};
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+#!/bin/sh
+#
+# Builds G3DWidgetDemo with profile-guided and link time optimization, and reports
+# the speedup over a plain release build.
+#
+#   1. plain release build, timed on the training workload
+#   2. instrumented build (CONFIG+=pgo_generate), run on the training workload
+#   3. llvm-profdata merges the recorded profiles
+#   4. optimized build (CONFIG+=ltcg CONFIG+=pgo_use), timed on the training workload
+#
+# The training workload (G3DWidgetDemo --training-workload N) drives the G3DWidgets
+# with scripted input for N frames and then quits, see TrainingWorkload.hpp.
+#
+# Usage: build_pgo.sh [frames]    (default 2000)
+#
+# The build directories are siblings of code/, because QMAKE_POST_LINK copies ../bin
+# and ../shaders into the build directory.
+#
+
+set -e
+
+FRAMES=${1:-2000}
+CODE_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT_DIR=$(dirname "$CODE_DIR")
+JOBS=$(sysctl -n hw.ncpu 2>/dev/null || nproc)
+
+if command -v xcrun > /dev/null 2>&1; then
+    LLVM_PROFDATA="xcrun llvm-profdata"
+else
+    LLVM_PROFDATA=llvm-profdata
+fi
+
+build() {
+    BUILD_DIR="$ROOT_DIR/$1"
+    shift
+
+    mkdir -p "$BUILD_DIR"
+    (cd "$BUILD_DIR" && qmake "$CODE_DIR/G3DWidgetDemo.pro" CONFIG+=release "$@" && make -j"$JOBS")
+}
+
+# Prints the milliseconds per frame reported by the training workload
+train() {
+    (cd "$ROOT_DIR/$1" && ./G3DWidgetDemo --training-workload "$FRAMES") | sed -n 's/.*Training workload: .* ms (\(.*\) ms\/frame)/\1/p' | tail -n 1
+}
+
+echo "== plain build"
+build build-pgo-plain
+PLAIN=$(train build-pgo-plain)
+
+echo "== instrumented build"
+build build-pgo-instrumented CONFIG+=pgo_generate
+rm -f "$ROOT_DIR"/build-pgo-instrumented/*.profraw
+(cd "$ROOT_DIR/build-pgo-instrumented" && LLVM_PROFILE_FILE="G3DWidgetDemo-%p.profraw" ./G3DWidgetDemo --training-workload "$FRAMES" > /dev/null)
+
+echo "== merging profiles"
+mkdir -p "$ROOT_DIR/build-pgo-optimized"
+$LLVM_PROFDATA merge -output="$ROOT_DIR/build-pgo-optimized/G3DWidgetDemo.profdata" "$ROOT_DIR"/build-pgo-instrumented/*.profraw
+
+echo "== optimized build"
+build build-pgo-optimized CONFIG+=ltcg CONFIG+=pgo_use PGO_PROFILE="$ROOT_DIR/build-pgo-optimized/G3DWidgetDemo.profdata"
+OPTIMIZED=$(train build-pgo-optimized)
+
+echo
+echo "plain:     $PLAIN ms/frame"
+echo "optimized: $OPTIMIZED ms/frame"
+awk -v plain="$PLAIN" -v optimized="$OPTIMIZED" 'BEGIN { if (optimized > 0) printf("speedup:   %.3fx\n", plain / optimized) }'